@@ -0,0 +1,297 @@
+/**
+ * Hive Monitor System - Anomaly Detection Module
+ *
+ * This module implements the detectors behind the learned alerts. The
+ * joint anomaly detector scores the whole sensor feature vector at once,
+ * so correlated shifts (for example brood temperature and B3 audio rising
+ * together before a swarm) add up even when each sensor alone stays
+ * within its univariate limits. The change-point detector runs a CUSUM
+ * over a single series such as hive weight, catching a swarm that leaves
+ * over several wakes or a slow drain that no single reading shows.
+ */
+
+#include "anomaly_detection.h"
+#include <math.h>
+
+/**
+ * Index of element (row, col), col <= row, in packed lower-triangular storage
+ */
+static inline uint16_t triIndex(uint8_t row, uint8_t col) {
+    return (uint16_t)row * (row + 1) / 2 + col;
+}
+
+/**
+ * Initialize with a diagonal covariance from per-feature statistics
+ */
+void MahalanobisDetector::init(uint8_t dim, const float* mean, const float* stdDev,
+                               const float* minStdDev, float halfLifeSamples) {
+    dim_ = (dim > MAHALANOBIS_MAX_DIM) ? MAHALANOBIS_MAX_DIM : dim;
+    count_ = 0;
+    alpha_ = 1.0f - powf(0.5f, 1.0f / fmaxf(halfLifeSamples, 1.0f));
+
+    for (uint16_t i = 0; i < MAHALANOBIS_TRI_SIZE; i++) {
+        chol_[i] = 0.0f;
+    }
+
+    for (uint8_t i = 0; i < dim_; i++) {
+        mean_[i] = mean[i];
+        // Keep the factor strictly positive definite
+        minStdDev_[i] = fmaxf(minStdDev[i], 1e-6f);
+        chol_[triIndex(i, i)] = fmaxf(stdDev[i], minStdDev_[i]);
+    }
+}
+
+/**
+ * Solve L*y = delta (forward) and L^T*z = y (backward), so z = Sigma^-1 * delta
+ */
+void MahalanobisDetector::solve(const float* delta, float* y, float* z) const {
+    for (uint8_t i = 0; i < dim_; i++) {
+        float sum = delta[i];
+        for (uint8_t j = 0; j < i; j++) {
+            sum -= chol_[triIndex(i, j)] * y[j];
+        }
+        y[i] = sum / chol_[triIndex(i, i)];
+    }
+
+    for (int8_t i = dim_ - 1; i >= 0; i--) {
+        float sum = y[i];
+        for (uint8_t j = i + 1; j < dim_; j++) {
+            sum -= chol_[triIndex(j, i)] * z[j];
+        }
+        z[i] = sum / chol_[triIndex(i, i)];
+    }
+}
+
+/**
+ * Squared Mahalanobis distance of a sample from the learned distribution
+ * Per-feature contributions delta_i * (Sigma^-1 * delta)_i sum to the
+ * score; a negative contribution means that feature made the sample
+ * look more normal given the others. Pass NULL to skip them.
+ * A non-finite feature (a failed sensor read) is taken at its mean, so
+ * it adds nothing and the rest of the vector is still scored.
+ */
+float MahalanobisDetector::score(const float* x, float* contributions) const {
+    float delta[MAHALANOBIS_MAX_DIM] = {0.0f};
+    float y[MAHALANOBIS_MAX_DIM] = {0.0f};
+    float z[MAHALANOBIS_MAX_DIM] = {0.0f};
+
+    for (uint8_t i = 0; i < dim_; i++) {
+        if (isfinite(x[i])) {
+            delta[i] = x[i] - mean_[i];
+        }
+    }
+    solve(delta, y, z);
+
+    float distance = 0.0f;
+    for (uint8_t i = 0; i < dim_; i++) {
+        distance += y[i] * y[i];
+        if (contributions) {
+            contributions[i] = delta[i] * z[i];
+        }
+    }
+    return distance;
+}
+
+/**
+ * Add a sample: Sigma' = (1 - w) * (Sigma + w * delta * delta^T)
+ * Applied to L as a rank-1 Cholesky update followed by a scale.
+ * A sample with any non-finite feature is not learned, since one NaN
+ * would spread through the whole factor.
+ */
+void MahalanobisDetector::update(const float* x) {
+    for (uint8_t i = 0; i < dim_; i++) {
+        if (!isfinite(x[i])) {
+            return;
+        }
+    }
+
+    if (count_ < UINT16_MAX) {
+        count_++;
+    }
+
+    // The initial covariance counts as one prior sample during warm-up
+    float weight = 1.0f / (count_ + 1);
+    if (weight < alpha_) {
+        weight = alpha_;
+    }
+
+    float v[MAHALANOBIS_MAX_DIM];
+    float root = sqrtf(weight);
+    for (uint8_t i = 0; i < dim_; i++) {
+        float delta = x[i] - mean_[i];
+        mean_[i] += weight * delta;
+        v[i] = root * delta;
+    }
+
+    // Rank-1 update L*L^T + v*v^T using Givens-style rotations
+    for (uint8_t k = 0; k < dim_; k++) {
+        float diag = chol_[triIndex(k, k)];
+        float r = sqrtf(diag * diag + v[k] * v[k]);
+        float c = r / diag;
+        float s = v[k] / diag;
+        chol_[triIndex(k, k)] = r;
+
+        for (uint8_t i = k + 1; i < dim_; i++) {
+            float lik = (chol_[triIndex(i, k)] + s * v[i]) / c;
+            v[i] = c * v[i] - s * lik;
+            chol_[triIndex(i, k)] = lik;
+        }
+    }
+
+    // Fade old samples and keep every feature's variance above its floor
+    float scale = sqrtf(1.0f - weight);
+    for (uint8_t i = 0; i < dim_; i++) {
+        for (uint8_t j = 0; j <= i; j++) {
+            chol_[triIndex(i, j)] *= scale;
+        }
+        if (chol_[triIndex(i, i)] < minStdDev_[i]) {
+            chol_[triIndex(i, i)] = minStdDev_[i];
+        }
+    }
+}
+
+/**
+ * Get number of features in use
+ */
+uint8_t MahalanobisDetector::dimension() const {
+    return dim_;
+}
+
+/**
+ * Get sample count (saturates at UINT16_MAX)
+ */
+uint16_t MahalanobisDetector::count() const {
+    return count_;
+}
+
+/**
+ * Write the detector's fields to a record section
+ * The reserved byte keeps the layout of records written before the
+ * fields were serialized one by one.
+ */
+void MahalanobisDetector::serialize(RecordWriter* out) const {
+    out->putU8(dim_);
+    out->putReserved(1);
+    out->putU16(count_);
+    out->putFloat(alpha_);
+    out->putFloats(mean_, MAHALANOBIS_MAX_DIM);
+    out->putFloats(minStdDev_, MAHALANOBIS_MAX_DIM);
+    out->putFloats(chol_, MAHALANOBIS_TRI_SIZE);
+}
+
+/**
+ * Read the detector's fields from a record section
+ */
+void MahalanobisDetector::deserialize(RecordReader* in) {
+    dim_ = in->getU8();
+    if (dim_ > MAHALANOBIS_MAX_DIM) {
+        dim_ = MAHALANOBIS_MAX_DIM;
+    }
+    in->skip(1);
+    count_ = in->getU16();
+    alpha_ = in->getFloat();
+    in->getFloats(mean_, MAHALANOBIS_MAX_DIM);
+    in->getFloats(minStdDev_, MAHALANOBIS_MAX_DIM);
+    in->getFloats(chol_, MAHALANOBIS_TRI_SIZE);
+}
+
+/**
+ * Initialize a change detector
+ */
+void ChangeDetector::init(float drift, float threshold, float referenceHalfLife) {
+    drift_ = drift;
+    threshold_ = threshold;
+    referenceAlpha_ = 1.0f - powf(0.5f, 1.0f / fmaxf(referenceHalfLife, 1.0f));
+    last_.direction = CHANGE_NONE;
+    last_.magnitude = 0.0f;
+    last_.startTime = 0;
+    last_.detectTime = 0;
+    reset();
+}
+
+/**
+ * Clear the accumulated evidence and reference level
+ */
+void ChangeDetector::reset() {
+    reference_ = 0.0f;
+    upSum_ = 0.0f;
+    downSum_ = 0.0f;
+    upStart_ = 0;
+    downStart_ = 0;
+    count_ = 0;
+}
+
+/**
+ * Add a sample; returns true when a change is confirmed
+ * Non-finite values are ignored.
+ */
+bool ChangeDetector::addSample(float value, uint32_t time) {
+    if (!isfinite(value)) {
+        return false;
+    }
+    if (count_ == 0) {
+        reference_ = value;
+        count_ = 1;
+        return false;
+    }
+
+    float deviation = value - reference_;
+
+    // Accumulate each side, remembering when its current run began
+    if (upSum_ == 0.0f) {
+        upStart_ = time;
+    }
+    upSum_ = fmaxf(0.0f, upSum_ + deviation - drift_);
+
+    if (downSum_ == 0.0f) {
+        downStart_ = time;
+    }
+    downSum_ = fmaxf(0.0f, downSum_ - deviation - drift_);
+
+    // Follow slow drift (nectar flow, consumption) only while neither side
+    // holds evidence, so the reference stays at the pre-change level
+    if (upSum_ == 0.0f && downSum_ == 0.0f) {
+        reference_ += referenceAlpha_ * deviation;
+    }
+    if (count_ < UINT16_MAX) {
+        count_++;
+    }
+
+    int8_t direction = CHANGE_NONE;
+    if (upSum_ > threshold_ && upSum_ >= downSum_) {
+        direction = CHANGE_UP;
+        last_.startTime = upStart_;
+    } else if (downSum_ > threshold_) {
+        direction = CHANGE_DOWN;
+        last_.startTime = downStart_;
+    }
+
+    if (direction == CHANGE_NONE) {
+        return false;
+    }
+
+    // Shift from the pre-change level; covers both steps and ramps
+    last_.direction = direction;
+    last_.magnitude = fabsf(deviation);
+    last_.detectTime = time;
+
+    // Restart from the new level
+    reference_ = value;
+    upSum_ = 0.0f;
+    downSum_ = 0.0f;
+    return true;
+}
+
+/**
+ * Get the reference (pre-change) level
+ */
+float ChangeDetector::reference() const {
+    return reference_;
+}
+
+/**
+ * Get the most recent detected change
+ */
+const ChangeEvent& ChangeDetector::lastChange() const {
+    return last_;
+}
\ No newline at end of file
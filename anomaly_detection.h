@@ -0,0 +1,98 @@
+/**
+ * Hive Monitor System - Anomaly Detection Header
+ *
+ * Header file for the anomaly and change-point detectors used by the
+ * learning and weight sensing modules. Both keep fixed-size state with
+ * no Arduino dependencies, so the replay tool links them on the host,
+ * and the Mahalanobis detector writes itself into learning record
+ * sections.
+ */
+
+#ifndef ANOMALY_DETECTION_H
+#define ANOMALY_DETECTION_H
+
+#include <stdint.h>
+#include "record_sections.h"
+
+// Largest feature vector supported by the joint detector
+#define MAHALANOBIS_MAX_DIM 10
+
+// Packed lower-triangular storage size for MAHALANOBIS_MAX_DIM
+#define MAHALANOBIS_TRI_SIZE (MAHALANOBIS_MAX_DIM * (MAHALANOBIS_MAX_DIM + 1) / 2)
+
+// Joint (Mahalanobis) anomaly detector over a feature vector.
+// Keeps an exponentially weighted mean and the Cholesky factor L of the
+// covariance (Sigma = L * L^T), updated by a rank-1 Cholesky update, so
+// both scoring and updating are O(d^2) with no matrix inversion.
+// Memory: d + d(d+1)/2 + d floats (~300 bytes at d = 10).
+class MahalanobisDetector {
+public:
+    MahalanobisDetector() : dim_(0), count_(0), alpha_(0.0f) {}
+
+    void init(uint8_t dim, const float* mean, const float* stdDev,
+              const float* minStdDev, float halfLifeSamples);
+    float score(const float* x, float* contributions) const;
+    void update(const float* x);
+    void serialize(RecordWriter* out) const;
+    void deserialize(RecordReader* in);
+
+    uint8_t dimension() const;
+    uint16_t count() const;
+
+private:
+    void solve(const float* delta, float* y, float* z) const;
+
+    uint8_t dim_;                           // Features in use
+    uint16_t count_;                        // Samples seen, saturating
+    float alpha_;                           // Per-sample weight of the newest value
+    float mean_[MAHALANOBIS_MAX_DIM];       // Weighted mean
+    float minStdDev_[MAHALANOBIS_MAX_DIM];  // Floor on each diagonal of L
+    float chol_[MAHALANOBIS_TRI_SIZE];      // Lower-triangular L, row-major packed
+};
+
+// Direction of a detected level change
+enum ChangeDirection {
+    CHANGE_DOWN = -1,
+    CHANGE_NONE = 0,
+    CHANGE_UP = 1
+};
+
+// A detected level change
+typedef struct {
+    int8_t direction;     // ChangeDirection
+    float magnitude;      // Estimated size of the shift (input units)
+    uint32_t startTime;   // Time the change began (caller's time units)
+    uint32_t detectTime;  // Time the change was confirmed
+} ChangeEvent;
+
+// Two-sided CUSUM change-point detector with an adaptive reference level.
+// Each side accumulates deviations beyond the drift allowance; a change
+// is reported when one side exceeds the threshold, with the time its run
+// started, the estimated shift and the direction. The drift allowance is
+// usually half the smallest shift of interest; raising the threshold
+// lowers the false-alarm rate exponentially. O(1) state and work.
+class ChangeDetector {
+public:
+    ChangeDetector() : count_(0) {}
+
+    void init(float drift, float threshold, float referenceHalfLife);
+    bool addSample(float value, uint32_t time);
+    void reset();
+
+    float reference() const;
+    const ChangeEvent& lastChange() const;
+
+private:
+    float drift_;          // Allowance k per sample
+    float threshold_;      // Decision threshold h
+    float referenceAlpha_; // Weight of new samples in the reference level
+    float reference_;      // Tracked pre-change level
+    float upSum_;          // Positive CUSUM
+    float downSum_;        // Negative CUSUM
+    uint32_t upStart_;     // Time upSum_ left zero
+    uint32_t downStart_;   // Time downSum_ left zero
+    uint16_t count_;       // Samples seen, saturating
+    ChangeEvent last_;     // Most recent detection
+};
+
+#endif // ANOMALY_DETECTION_H
\ No newline at end of file
@@ -0,0 +1,176 @@
+/**
+ * Hive Monitor System - Colony State Module
+ *
+ * This module estimates the colony state with a small hidden Markov
+ * model. The tables below are hand-set priors from beekeeping practice
+ * (one step = one wake, about 10 minutes) and can be refined offline
+ * from labelled logs.
+ */
+
+#include "colony_state.h"
+
+// Initial belief and the state returned to on reset
+static const float initialBelief[NUM_COLONY_STATES] = {
+    0.95f, 0.01f, 0.01f, 0.01f, 0.01f, 0.01f
+};
+
+// State transition probabilities per wake, transition[from][to].
+// Rows sum to 1. States are sticky; disturbances clear within hours,
+// while a swarmed or queenless colony stays so for days.
+static const float transition[NUM_COLONY_STATES][NUM_COLONY_STATES] = {
+    // NORMAL  PRE_SW   SWARMED  QLESS    ROBBED   DISTURB
+    { 0.9900f, 0.0020f, 0.0005f, 0.0005f, 0.0010f, 0.0060f },  // NORMAL
+    { 0.0100f, 0.9750f, 0.0100f, 0.0000f, 0.0000f, 0.0050f },  // PRE_SWARM
+    { 0.0050f, 0.0000f, 0.9800f, 0.0100f, 0.0000f, 0.0050f },  // SWARMED
+    { 0.0020f, 0.0000f, 0.0000f, 0.9950f, 0.0000f, 0.0030f },  // QUEENLESS
+    { 0.0200f, 0.0000f, 0.0000f, 0.0000f, 0.9700f, 0.0100f },  // ROBBED
+    { 0.3000f, 0.0050f, 0.0050f, 0.0050f, 0.0050f, 0.6800f }   // DISTURBED
+};
+
+// P(sound class | state): NORMAL, QUEEN, SWARM, ALARM, SILENT, UNKNOWN
+static const float soundLikelihood[NUM_COLONY_STATES][COLONY_OBS_SOUND_SYMBOLS] = {
+    { 0.80f, 0.02f, 0.03f, 0.05f, 0.05f, 0.05f },  // NORMAL
+    { 0.35f, 0.30f, 0.25f, 0.05f, 0.02f, 0.03f },  // PRE_SWARM
+    { 0.40f, 0.03f, 0.10f, 0.05f, 0.35f, 0.07f },  // SWARMED
+    { 0.35f, 0.20f, 0.05f, 0.25f, 0.10f, 0.05f },  // QUEENLESS
+    { 0.20f, 0.02f, 0.10f, 0.55f, 0.05f, 0.08f },  // ROBBED
+    { 0.15f, 0.02f, 0.08f, 0.60f, 0.05f, 0.10f }   // DISTURBED
+};
+
+// P(weight status | state): STABLE, INCREASE, DECREASE, DROP_ALERT
+static const float weightLikelihood[NUM_COLONY_STATES][COLONY_OBS_WEIGHT_SYMBOLS] = {
+    { 0.85f, 0.07f, 0.07f, 0.01f },  // NORMAL
+    { 0.85f, 0.06f, 0.08f, 0.01f },  // PRE_SWARM
+    { 0.40f, 0.02f, 0.18f, 0.40f },  // SWARMED
+    { 0.80f, 0.05f, 0.14f, 0.01f },  // QUEENLESS
+    { 0.35f, 0.02f, 0.55f, 0.08f },  // ROBBED
+    { 0.50f, 0.15f, 0.20f, 0.15f }   // DISTURBED
+};
+
+// P(motion status | state): NOMINAL, WARNING, ALERT
+static const float motionLikelihood[NUM_COLONY_STATES][COLONY_OBS_MOTION_SYMBOLS] = {
+    { 0.95f, 0.04f, 0.01f },  // NORMAL
+    { 0.93f, 0.05f, 0.02f },  // PRE_SWARM
+    { 0.93f, 0.05f, 0.02f },  // SWARMED
+    { 0.95f, 0.04f, 0.01f },  // QUEENLESS
+    { 0.90f, 0.08f, 0.02f },  // ROBBED
+    { 0.40f, 0.30f, 0.30f }   // DISTURBED
+};
+
+// P(light status | state): ENCLOSED, OPEN
+static const float lightLikelihood[NUM_COLONY_STATES][COLONY_OBS_LIGHT_SYMBOLS] = {
+    { 0.98f, 0.02f },  // NORMAL
+    { 0.98f, 0.02f },  // PRE_SWARM
+    { 0.97f, 0.03f },  // SWARMED
+    { 0.98f, 0.02f },  // QUEENLESS
+    { 0.97f, 0.03f },  // ROBBED
+    { 0.35f, 0.65f }   // DISTURBED
+};
+
+// P(environment status | state): NOMINAL, ALERT
+static const float envLikelihood[NUM_COLONY_STATES][COLONY_OBS_ENV_SYMBOLS] = {
+    { 0.92f, 0.08f },  // NORMAL
+    { 0.80f, 0.20f },  // PRE_SWARM
+    { 0.60f, 0.40f },  // SWARMED
+    { 0.75f, 0.25f },  // QUEENLESS
+    { 0.80f, 0.20f },  // ROBBED
+    { 0.50f, 0.50f }   // DISTURBED
+};
+
+/**
+ * Likelihood of one observed symbol, 1 when the reading is missing
+ */
+static inline float symbolLikelihood(const float* row, uint8_t symbols, uint8_t symbol) {
+    return (symbol < symbols) ? row[symbol] : 1.0f;
+}
+
+/**
+ * Return to the initial belief
+ */
+void ColonyStateEstimator::reset() {
+    for (int i = 0; i < NUM_COLONY_STATES; i++) {
+        belief_[i] = initialBelief[i];
+    }
+}
+
+/**
+ * Run one forward-filter step with this wake's subsystem statuses
+ */
+void ColonyStateEstimator::update(const ColonyObservation& observation) {
+    float next[NUM_COLONY_STATES];
+    float total = 0.0f;
+
+    for (int to = 0; to < NUM_COLONY_STATES; to++) {
+        // Predict: probability of arriving in this state
+        float predicted = 0.0f;
+        for (int from = 0; from < NUM_COLONY_STATES; from++) {
+            predicted += belief_[from] * transition[from][to];
+        }
+
+        // Correct: weight by the joint likelihood of the statuses
+        float likelihood =
+            symbolLikelihood(soundLikelihood[to], COLONY_OBS_SOUND_SYMBOLS, observation.sound) *
+            symbolLikelihood(weightLikelihood[to], COLONY_OBS_WEIGHT_SYMBOLS, observation.weight) *
+            symbolLikelihood(motionLikelihood[to], COLONY_OBS_MOTION_SYMBOLS, observation.motion) *
+            symbolLikelihood(lightLikelihood[to], COLONY_OBS_LIGHT_SYMBOLS, observation.light) *
+            symbolLikelihood(envLikelihood[to], COLONY_OBS_ENV_SYMBOLS, observation.env);
+
+        next[to] = predicted * likelihood;
+        total += next[to];
+    }
+
+    // All likelihoods are positive, so total only underflows on corrupt state
+    if (!(total > 0.0f)) {
+        reset();
+        return;
+    }
+
+    float scale = 1.0f / total;
+    for (int i = 0; i < NUM_COLONY_STATES; i++) {
+        belief_[i] = next[i] * scale;
+    }
+}
+
+/**
+ * Copy out the posterior probability of every state
+ */
+void ColonyStateEstimator::posterior(float probabilities[NUM_COLONY_STATES]) const {
+    for (int i = 0; i < NUM_COLONY_STATES; i++) {
+        probabilities[i] = belief_[i];
+    }
+}
+
+/**
+ * Posterior probability of one state
+ */
+float ColonyStateEstimator::probability(ColonyState state) const {
+    return belief_[state];
+}
+
+/**
+ * State with the highest posterior probability
+ */
+ColonyState ColonyStateEstimator::mostLikely() const {
+    int best = 0;
+    for (int i = 1; i < NUM_COLONY_STATES; i++) {
+        if (belief_[i] > belief_[best]) {
+            best = i;
+        }
+    }
+    return (ColonyState)best;
+}
+
+/**
+ * Get the name of a colony state
+ */
+const char* getColonyStateName(ColonyState state) {
+    switch (state) {
+        case COLONY_NORMAL: return "Normal";
+        case COLONY_PRE_SWARM: return "Pre-swarm";
+        case COLONY_SWARMED: return "Swarmed";
+        case COLONY_QUEENLESS: return "Queenless";
+        case COLONY_ROBBED: return "Robbed";
+        case COLONY_DISTURBED: return "Disturbed";
+        default: return "Unknown";
+    }
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+/**
+ * Hive Monitor System - Colony State Header
+ *
+ * Header file for the colony state estimator that fuses the discrete
+ * status of every sensor subsystem into a belief over what the colony
+ * is doing. The estimator sees only status enums passed in as small
+ * integers, so it does not depend on the sensor modules themselves.
+ */
+
+#ifndef COLONY_STATE_H
+#define COLONY_STATE_H
+
+#include <stdint.h>
+
+// Hidden colony states
+enum ColonyState {
+    COLONY_NORMAL,      // Queenright colony going about its business
+    COLONY_PRE_SWARM,   // Queen piping and congestion before a swarm
+    COLONY_SWARMED,     // A swarm has left
+    COLONY_QUEENLESS,   // Queen lost, colony roaring
+    COLONY_ROBBED,      // Being robbed by other colonies
+    COLONY_DISTURBED,   // Hive opened, knocked or moved
+    NUM_COLONY_STATES
+};
+
+// Observation symbol counts, in the order of the subsystem status enums
+#define COLONY_OBS_SOUND_SYMBOLS   6   // SoundClass
+#define COLONY_OBS_WEIGHT_SYMBOLS  4   // WeightStatus
+#define COLONY_OBS_MOTION_SYMBOLS  3   // MotionStatus
+#define COLONY_OBS_LIGHT_SYMBOLS   2   // LightStatus
+#define COLONY_OBS_ENV_SYMBOLS     2   // EnvAlertStatus
+
+// Marks a subsystem that produced no reading this wake
+#define COLONY_OBS_MISSING         0xFF
+
+// One wake's subsystem statuses
+typedef struct {
+    uint8_t sound;   // SoundClass
+    uint8_t weight;  // WeightStatus
+    uint8_t motion;  // MotionStatus
+    uint8_t light;   // LightStatus
+    uint8_t env;     // EnvAlertStatus
+} ColonyObservation;
+
+// Discrete hidden Markov model over the colony states. Each wake runs
+// one forward-filter step: the belief is propagated through the state
+// transition matrix and weighted by the likelihood of the observed
+// statuses, taken as independent given the state. A single noisy
+// sensor therefore shifts the belief only as far as its likelihood
+// ratio allows, while agreeing sensors and persistence across wakes
+// build it up. O(states^2) work and 24 bytes of state.
+class ColonyStateEstimator {
+public:
+    ColonyStateEstimator() { reset(); }
+
+    void reset();
+    void update(const ColonyObservation& observation);
+
+    void posterior(float probabilities[NUM_COLONY_STATES]) const;
+    float probability(ColonyState state) const;
+    ColonyState mostLikely() const;
+
+private:
+    float belief_[NUM_COLONY_STATES];  // Filtered state probabilities
+};
+
+// Function prototypes
+const char* getColonyStateName(ColonyState state);
+
+#endif // COLONY_STATE_H
\ No newline at end of file
@@ -272,7 +272,7 @@ void getTemperatureThresholds(float* lowThreshold, float* highThreshold) {
     // Let learning system adjust if enabled and available
     if (isLearningEnabled() && isBaselineEstablished()) {
         DateTime now = getRTCTime();
-        getAdaptedTempThresholds(lowThreshold, highThreshold, now.hour());
+        getAdaptedTempThresholds(lowThreshold, highThreshold, now);
     }
 }
 
@@ -287,7 +287,7 @@ void getHumidityThresholds(float* lowThreshold, float* highThreshold) {
     // Let learning system adjust if enabled and available
     if (isLearningEnabled() && isBaselineEstablished()) {
         DateTime now = getRTCTime();
-        getAdaptedHumidityThresholds(lowThreshold, highThreshold, now.hour());
+        getAdaptedHumidityThresholds(lowThreshold, highThreshold, now);
     }
 }
 
@@ -303,6 +303,7 @@ void getAudioThresholds(float thresholds[4]) {
     
     // Let learning system adjust if enabled and available
     if (isLearningEnabled() && isBaselineEstablished()) {
-        getAdaptedAudioThresholds(thresholds);
+        DateTime now = getRTCTime();
+        getAdaptedAudioThresholds(thresholds, now);
     }
 }
\ No newline at end of file
@@ -9,7 +9,9 @@
  #ifndef HIVE_MONITOR_CONFIG_H
  #define HIVE_MONITOR_CONFIG_H
  
+ #ifdef ARDUINO
  #include <Arduino.h>
+ #endif
  
  // System identification
  #define DEVICE_ID                "HIVE01"    // Unique identifier for this monitor
@@ -24,8 +26,8 @@
  
  // Pin definitions
  #define SD_CS_PIN                5           // SD card chip select pin
- #define HX711_DATA_PIN           6           // HX711 data pin
- #define HX711_CLOCK_PIN          5           // HX711 clock pin
+ #define HX711_DATA_PINS          { 6, 9, 10, 11 }  // HX711 data pins, one per weight channel
+ #define HX711_CLOCK_PIN          12          // HX711 clock pin, shared by all channels (not SD_CS_PIN)
  #define VBAT_PIN                 A7          // Battery voltage monitoring pin
  #define LED_PIN                  13          // Status LED pin
  
@@ -55,20 +57,80 @@
  // Anomaly detection thresholds
  #define TEMP_ANOMALY_THRESHOLD   3.0f        // Z-score threshold for temperature anomalies
  #define HUMIDITY_ANOMALY_THRESHOLD 3.0f      // Z-score threshold for humidity anomalies
+ #define AUDIO_HUM_ANOMALY_THRESHOLD 3.0f     // Z-score threshold for the normal hum band until its percentiles are learned
+ #define AUDIO_ANOMALY_THRESHOLD  2.5f        // Z-score threshold for the other audio bands until their percentiles are learned
  #define WEIGHT_ANOMALY_THRESHOLD 3.5f        // Z-score threshold for weight anomalies
  #define WEIGHT_CHANGE_THRESHOLD  2.0f        // Std deviations for significant weight change
+ #define JOINT_ANOMALY_THRESHOLD  29.6f       // Squared Mahalanobis distance (chi-square, 10 dof, p=0.001)
+ #define COLONY_ALERT_PROBABILITY 0.8f        // Posterior mass off the normal colony state needed for an alert
  
  // Light sensing thresholds
  #define LIGHT_THRESHOLD          100         // Threshold for detecting lid removal (lux)
+ #define LIGHT_CLOSE_THRESHOLD    50          // Level below which an open lid counts as closed again (lux)
+ #define LIGHT_WAKE_ENABLE        1           // Wake from deep sleep on APDS-9960 light interrupt (1=on, 0=off)
+ #define LIGHT_INT_PIN            36          // APDS-9960 INT pin (active low)
+ #define LIGHT_WAKE_PERSISTENCE   2           // Light cycles past a threshold before interrupting (APERS: 0-3, then 5 per step)
+ #define LIGHT_WAIT_MS            250         // APDS-9960 idle time between light cycles (ms, 3-712)
+ #define LIGHT_EVENTS_PER_SLEEP   4           // Light wakes handled before sleeping on the timer only
+ #define LIGHT_LUX_PER_COUNT      1.0         // Lux per clear count at 4x gain and 11.1 ms integration (calibrate against a lux meter)
+ #define LIGHT_TARGET_COUNTS      100         // Clear counts a reading aims for when choosing gain and integration (below 1025)
+ #define LIGHT_RANGE_ATTEMPTS     3           // Readings per wake while settling gain and integration
+ #define LIGHT_WAKE_COUNTS        20          // Clear counts at LIGHT_CLOSE_THRESHOLD while the light interrupt watches
  
  // Motion sensing thresholds
- #define MOTION_ALERT_THRESHOLD   12.0f       // Motion alert threshold (m/s²)
- #define MOTION_WARNING_THRESHOLD 10.5f       // Motion warning threshold (m/s²)
+ #define MOTION_ALERT_THRESHOLD   0.10f       // Motion alert threshold until the baseline is learned (g RMS, gravity removed)
+ #define MOTION_WARNING_THRESHOLD 0.03f       // Motion warning threshold until the baseline is learned (g RMS, gravity removed)
+ #define MOTION_ALERT_ZSCORE      6.0f        // Activity z-score for a motion alert (higher scores are not learned)
+ #define MOTION_WARNING_ZSCORE    3.0f        // Activity z-score for a motion warning
+ #define MOTION_REST_HALF_LIFE    4           // Learned rest vector half-life (wakes)
+ #define MOTION_REST_TOLERANCE    0.005f      // Consecutive wakes this close in mean acceleration set a new rest (g)
+ #define MOTION_BASELINE_HALF_LIFE 1008       // Activity baseline half-life (wakes, 1 week at 10 min)
+ #define MOTION_BASELINE_MIN_WAKES 36         // Wakes before activity is scored against the baseline
+ #define MOTION_SCORE_MIN_STDDEV  0.2f        // Floor on the activity baseline spread (natural log units)
+ #define MOTION_WAKE_ENABLE       1           // Wake from deep sleep on LSM6DS33 motion interrupt (1=on, 0=off)
+ #define MOTION_INT_PIN           3           // LSM6DS33 INT1 pin
+ #define MOTION_WAKE_THRESHOLD    0.25f       // Wake-up threshold on high-passed acceleration (g, 31.25 mg steps)
+ #define MOTION_WAKE_DURATION     1           // Samples above threshold before waking (0-3 at 52 Hz)
+ #define MOTION_EVENT_SAMPLES     52          // Accelerometer samples captured per motion event (1 s at 52 Hz)
+ #define MOTION_IMPACT_THRESHOLD  1.0f        // Peak deviation from 1 g classed as an impact (g)
+ #define MOTION_TILT_THRESHOLD    20.0f       // Orientation change classed as the hive tipping (degrees)
+ #define MOTION_EVENTS_PER_SLEEP  3           // Motion wakes handled before sleeping on the timer only
+ #define MOTION_BURST_SAMPLES     512         // Accel/gyro FIFO samples per wake at 1.66 kHz (power of two, max 682)
+ #define VIBRATION_ENABLE         1           // Capture a comb vibration spectrum each wake (1=on, 0=off)
+ #define VIBRATION_BAND_EDGES     { 20.0f, 100.0f, 250.0f, 550.0f, 800.0f }  // Vibration band edges (Hz)
+ #define ORIENTATION_ENABLE       1           // Track orientation with the fusion filter each wake (1=on, 0=off)
+ #define ORIENTATION_KP           5.0f        // Fusion filter proportional gain (1/s)
+ #define ORIENTATION_KI           0.5f        // Fusion filter gyro bias gain (1/s²)
+ #define ORIENTATION_TILT_THRESHOLD    10.0f  // Tilt from the reference orientation that raises an alert (degrees)
+ #define ORIENTATION_HEADING_THRESHOLD 15.0f  // Turn from the reference heading that raises an alert (degrees)
+ #define ORIENTATION_SETTLE_WAKES 8           // Wakes at a steady new orientation before it becomes the reference
  
  // Weight sensing configuration
+ #define WEIGHT_CHANNELS          1           // Hives weighed by this board, one HX711 each (1-4)
  #define WEIGHT_CALIBRATION       22000.0f    // Calibration factor for load cell
- #define WEIGHT_SAMPLES           5           // Number of weight samples to average
+ #define WEIGHT_TARE_SAMPLES      10          // Conversions averaged when taring or calibrating
+ #define WEIGHT_SAMPLES           5           // HX711 conversions per reading (collected by interrupt)
+ #define WEIGHT_TRIM_SAMPLES      1           // Conversions dropped from each end before averaging
+ #define WEIGHT_ACQUISITION_TIMEOUT_MS 1000   // Longest wait for outstanding conversions (10 SPS = 100 ms each)
+ #define WEIGHT_BURST_RATE_HZ     10          // HX711 data rate during burst capture (RATE pin low = 10 SPS)
+ #define WEIGHT_BURST_SECONDS     120         // Length of a burst capture after a weight event (s)
+ #define WEIGHT_BURST_SPREAD      0.05f       // Conversion spread that also triggers a burst (kg)
+ #define WEIGHT_BURST_MIN_INTERVAL 1800       // Shortest time between burst captures (s)
  #define WEIGHT_CHANGE_ALERT      2.0f        // Significant weight change threshold (kg)
+ #define WEIGHT_CUSUM_DRIFT       0.5f        // CUSUM allowance (kg), about half the smallest change to detect
+ #define WEIGHT_CUSUM_THRESHOLD   1.0f        // CUSUM decision threshold (kg), higher = fewer false alarms
+ #define WEIGHT_CUSUM_HALF_LIFE   36          // CUSUM reference level half-life (samples, ~6 h at 10 min wakes)
+ #define WEIGHT_TEMP_REFERENCE    20.0f       // Temperature at which drift compensation is zero (°C)
+ #define WEIGHT_DRIFT_FORGETTING  0.998f      // Drift regression forgetting factor (~500 night steps, ~10 nights)
+ #define WEIGHT_DRIFT_NIGHT_START 22          // First hour of the quiet night window used to learn drift
+ #define WEIGHT_DRIFT_NIGHT_END   5           // Hour the quiet night window ends
+ #define WEIGHT_DRIFT_MAX_GAP     1800        // Longest gap between wakes used as one step (s)
+ #define WEIGHT_DRIFT_MAX_STEP    0.2f        // Larger unexplained night steps are events, not drift (kg)
+ #define DAILY_DAWN_HOUR          6           // Hour before foragers leave; first reading from here is the dawn weight
+ #define DAILY_DUSK_HOUR          21          // Hour foragers are home; first reading from here is the dusk weight
+ #define DAILY_DEPARTURE_HOURS    3           // Window after dawn searched for the forager departure dip (h)
+ #define DAILY_RANGE_HALF_LIFE    7           // Typical daily weight range half-life (days)
+ #define DAILY_RANGE_MIN_DAYS     3           // Complete days before the daily range sets the baseline delta
  
  // Power management
  #define LOW_BATTERY_THRESHOLD    3.5f        // Low battery voltage threshold (V)
@@ -86,6 +148,20 @@
  #define LEARNING_ADAPTATION_RATE 0.05f       // Rate at which baseline adapts to changes (0.01-0.1)
  #define LEARNING_UPDATE_INTERVAL 50          // Update baseline every N samples
  #define LEARNING_SAVE_INTERVAL   20          // Save learning data every N samples
+ #define LEARNING_SLOT_SIZE       4096        // Bytes reserved per LEARN.DAT slot (file holds 2 slots)
+ #define LEARNED_QUANTILE_LOW     0.01f       // Lower percentile for learned thresholds
+ #define LEARNED_QUANTILE_HIGH    0.99f       // Upper percentile for learned thresholds
+ #define QUANTILE_THRESHOLD_MARGIN 0.25f      // Widen learned percentile band by this fraction of its width
+ #define QUANTILE_HORIZON_SAMPLES 2016        // Percentile sketch memory (~14 days at 10 min wakes)
+ #define FORECAST_ALPHA           0.02f       // Holt-Winters level smoothing (per sample)
+ #define FORECAST_BETA            0.005f      // Holt-Winters trend smoothing (per sample)
+ #define FORECAST_GAMMA           0.1f        // Holt-Winters daily seasonal smoothing (per sample)
+ #define AUDIO_PROFILE_HARMONICS  3           // Harmonics in the time-of-day audio profile (1-3)
+ #define BROOD_TEMP_TARGET        34.75f      // Brood nest temperature held by a queenright colony (°C)
+ #define BROOD_TEMP_TOLERANCE     0.75f       // Deviation from the brood target still counted as regulated (°C)
+ #define THERMO_FAST_HALF_LIFE    6           // Sub-hour temperature band half-life (samples, ~1 h at 10 min wakes)
+ #define THERMO_SLOW_HALF_LIFE    144         // Diurnal temperature band half-life (samples, ~1 day at 10 min wakes)
+ #define THERMO_AMBIENT_REFERENCE 1           // BME280 mounted outside the brood nest as ambient reference (0 = none)
  
  // Bluetooth configuration (if enabled)
  #define BLE_NAME                 "HiveMonitor"  // Bluetooth device name
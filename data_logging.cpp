@@ -15,6 +15,7 @@
 static int sdCardPin = 0;
 static RTC_PCF8523 *rtcPtr = NULL;
 static bool sdCardAvailable = false;
+static ColonyStateEstimator colonyState;
 
 /**
  * Initialize data logging system
@@ -42,6 +43,42 @@ bool isSDCardAvailable() {
   return sdCardAvailable;
 }
 
+/**
+ * Feed this wake's subsystem statuses to the colony state estimator
+ * A subsystem that produced no reading this wake is reported missing
+ * rather than repeating its previous status.
+ */
+void updateColonyState() {
+  ColonyObservation observation;
+  observation.sound = getCurrentSoundClass();
+  observation.weight = isWeightReadingValid() ? getWeightStatus() : COLONY_OBS_MISSING;
+  observation.motion = getMotionStatus();
+  observation.light = isLightReadingValid() ? getLightStatus() : COLONY_OBS_MISSING;
+  observation.env = isnan(getEnvData().temperature) ? COLONY_OBS_MISSING : getEnvAlertStatus();
+  colonyState.update(observation);
+  
+  ColonyState state = colonyState.mostLikely();
+  Serial.print("Colony state: ");
+  Serial.print(getColonyStateName(state));
+  Serial.print(" (p=");
+  Serial.print(colonyState.probability(state), 2);
+  Serial.println(")");
+}
+
+/**
+ * Get the most likely colony state
+ */
+ColonyState getColonyState() {
+  return colonyState.mostLikely();
+}
+
+/**
+ * Get the posterior probability of a colony state
+ */
+float getColonyStateProbability(ColonyState state) {
+  return colonyState.probability(state);
+}
+
 /**
  * Generate ISO8601 timestamp string
  */
@@ -94,7 +131,7 @@ bool logEnvironmentalData(DateTime time, EnvData envData) {
 /**
  * Log weight data to a dedicated file
  */
-bool logWeightData(DateTime time, float weight, WeightStatus status) {
+bool logWeightData(DateTime time, uint8_t channel, const WeightReading& reading) {
   if (!sdCardAvailable) {
     return false;
   }
@@ -102,8 +139,14 @@ bool logWeightData(DateTime time, float weight, WeightStatus status) {
   char filename[32];
   char timestamp[24];
   
-  // Generate filename with WEIGHT_ prefix
-  getLogFilename(time, "WEIGHT_", filename, sizeof(filename));
+  // Generate filename with WEIGHT_ prefix, WEIGHTn_ for scales after the first
+  char prefix[10];
+  if (channel == 0) {
+    snprintf(prefix, sizeof(prefix), "WEIGHT_");
+  } else {
+    snprintf(prefix, sizeof(prefix), "WEIGHT%u_", channel);
+  }
+  getLogFilename(time, prefix, filename, sizeof(filename));
   
   // Generate timestamp
   getTimestampString(time, timestamp, sizeof(timestamp));
@@ -114,12 +157,14 @@ bool logWeightData(DateTime time, float weight, WeightStatus status) {
   if (logFile) {
     logFile.print(timestamp);
     logFile.print(" | Weight: ");
-    logFile.print(weight, 2);
+    logFile.print(reading.weight, 2);
+    logFile.print(" kg | Spread: ");
+    logFile.print(reading.spread, 3);
     logFile.print(" kg | Status: ");
     
     // Convert status to string
     const char* statusStr = "Unknown";
-    switch (status) {
+    switch (reading.status) {
       case WEIGHT_STABLE: statusStr = "Stable"; break;
       case WEIGHT_INCREASE: statusStr = "Increase"; break;
       case WEIGHT_DECREASE: statusStr = "Decrease"; break;
@@ -137,6 +182,108 @@ bool logWeightData(DateTime time, float weight, WeightStatus status) {
   }
 }
 
+/**
+ * Append a weight burst to the binary burst log as one block
+ */
+bool logWeightBurst(const WeightBurst* burst) {
+  if (!sdCardAvailable || burst->count == 0) {
+    return false;
+  }
+  
+  WeightBurstHeader header;
+  header.magic = WEIGHT_BURST_MAGIC;
+  header.version = WEIGHT_BURST_VERSION;
+  header.rateHz = WEIGHT_BURST_RATE_HZ;
+  header.count = burst->count;
+  header.startTime = burst->startTime;
+  header.durationMs = burst->durationMs;
+  header.baseWeight = burst->baseWeight;
+  header.channel = burst->channel;
+  memset(header.reserved, 0, sizeof(header.reserved));
+  
+  File logFile = SD.open(WEIGHT_BURST_FILE, FILE_WRITE);
+  if (!logFile) {
+    Serial.print("Error opening weight burst file: ");
+    Serial.println(WEIGHT_BURST_FILE);
+    return false;
+  }
+  
+  size_t length = burst->count * sizeof(burst->grams[0]);
+  bool ok = logFile.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+            logFile.write((const uint8_t*)burst->grams, length) == length;
+  logFile.close();
+  
+  if (!ok) {
+    Serial.println("Error writing weight burst");
+  }
+  return ok;
+}
+
+/**
+ * Append a completed day's weight metrics to the daily summary log
+ * Times are written as hh:mm; metrics that could not be measured that
+ * day (NAN) are left empty.
+ */
+bool logDailyWeightSummary(const DailyWeightSummary& day) {
+  if (!sdCardAvailable) {
+    return false;
+  }
+  
+  File logFile = SD.open(DAILY_WEIGHT_FILE, FILE_WRITE);
+  if (!logFile) {
+    Serial.print("Error opening daily weight file: ");
+    Serial.println(DAILY_WEIGHT_FILE);
+    return false;
+  }
+  
+  if (logFile.size() == 0) {
+    logFile.println("Date,Samples,Open(kg),Close(kg),Min(kg),MinTime,Max(kg),MaxTime,Dawn(kg),DawnTime,Dusk(kg),DuskTime,Gain(kg),OvernightLoss(kg),DepartureDip(kg),NetFlow(kg)");
+  }
+  
+  char text[16];
+  DateTime date(day.dayStart);
+  snprintf(text, sizeof(text), "%04d-%02d-%02d", date.year(), date.month(), date.day());
+  logFile.print(text);
+  logFile.print(",");
+  logFile.print(day.samples);
+  
+  struct {
+    float weight;
+    uint32_t time;  // Unix time of the reading, 0 if none
+    bool hasTime;
+  } columns[] = {
+    { day.openWeight, 0, false },
+    { day.closeWeight, 0, false },
+    { day.minWeight, day.minTime, true },
+    { day.maxWeight, day.maxTime, true },
+    { day.dawnWeight, day.dawnTime, true },
+    { day.duskWeight, day.duskTime, true },
+    { day.dailyGain, 0, false },
+    { day.overnightLoss, 0, false },
+    { day.departureDip, 0, false },
+    { day.netFlow, 0, false }
+  };
+  
+  for (size_t i = 0; i < sizeof(columns) / sizeof(columns[0]); i++) {
+    logFile.print(",");
+    if (!isnan(columns[i].weight)) {
+      logFile.print(columns[i].weight, 3);
+    }
+    if (columns[i].hasTime) {
+      logFile.print(",");
+      if (columns[i].time != 0) {
+        DateTime at(columns[i].time);
+        snprintf(text, sizeof(text), "%02d:%02d", at.hour(), at.minute());
+        logFile.print(text);
+      }
+    }
+  }
+  logFile.println();
+  
+  logFile.close();
+  return true;
+}
+
 /**
  * Log motion data to a dedicated file
  */
@@ -165,15 +312,19 @@ bool logMotionData(DateTime time, MotionData motionData, MotionStatus status) {
     logFile.print(motionData.accelY, 2);
     logFile.print("g Z: ");
     logFile.print(motionData.accelZ, 2);
-    logFile.print("g | Orientation: ");
+    logFile.print("g | Tilt: ");
+    logFile.print(motionData.tilt, 1);
+    logFile.print(" deg Heading: ");
+    logFile.print(motionData.heading, 1);
+    logFile.print(" deg | Orientation: ");
     
-    // Determine orientation
-    if (abs(motionData.accelZ - 1.0) < 0.1) {
-      logFile.print("Stable");
-    } else if (motionData.accelZ < 0.8) {
+    // Fused orientation against the reference pose
+    if (motionData.tilt > ORIENTATION_TILT_THRESHOLD) {
       logFile.print("Tilted");
+    } else if (fabsf(motionData.heading) > ORIENTATION_HEADING_THRESHOLD) {
+      logFile.print("Turned");
     } else {
-      logFile.print("Shifted");
+      logFile.print("Stable");
     }
     
     logFile.print(" | Motion Status: ");
@@ -186,7 +337,56 @@ bool logMotionData(DateTime time, MotionData motionData, MotionStatus status) {
       case MOTION_ALERT: statusStr = "Movement Alert"; break;
     }
     
-    logFile.println(statusStr);
+    logFile.print(statusStr);
+    
+    // Comb vibration band RMS (mg)
+    float vibration[NUM_VIBRATION_BANDS];
+    getVibrationEnergyValues(vibration);
+    for (int i = 0; i < NUM_VIBRATION_BANDS; i++) {
+      logFile.print(i == 0 ? " | V" : "mg V");
+      logFile.print(i + 1);
+      logFile.print(": ");
+      logFile.print(vibration[i] * 1000.0f, 2);
+    }
+    logFile.println("mg");
+    
+    logFile.close();
+    return true;
+  } else {
+    Serial.print("Error opening motion log file: ");
+    Serial.println(filename);
+    return false;
+  }
+}
+
+/**
+ * Log a motion event caught between scheduled wakes
+ * Written to the same daily file as the scheduled motion readings.
+ */
+bool logMotionEvent(DateTime time, const MotionEvent& event) {
+  if (!sdCardAvailable) {
+    return false;
+  }
+  
+  char filename[32];
+  char timestamp[24];
+  
+  getLogFilename(time, "MOTION_", filename, sizeof(filename));
+  getTimestampString(time, timestamp, sizeof(timestamp));
+  
+  File logFile = SD.open(filename, FILE_WRITE);
+  
+  if (logFile) {
+    logFile.print(timestamp);
+    logFile.print(" | Event: ");
+    logFile.print(getMotionEventName(event.type));
+    logFile.print(" | Peak: ");
+    logFile.print(event.peak, 2);
+    logFile.print("g RMS: ");
+    logFile.print(event.rms, 3);
+    logFile.print("g | Tilt: ");
+    logFile.print(event.tilt, 1);
+    logFile.println(" deg");
     
     logFile.close();
     return true;
@@ -236,6 +436,51 @@ bool logLightData(DateTime time, LightData lightData) {
   }
 }
 
+/**
+ * Log a lid opening or closing caught between scheduled wakes
+ * Written to the same daily file as the scheduled light readings; a
+ * closing line carries when the lid was opened and for how long.
+ */
+bool logLightEvent(DateTime time, const LightEvent& event) {
+  if (!sdCardAvailable) {
+    return false;
+  }
+  
+  char filename[32];
+  char timestamp[24];
+  
+  getLogFilename(time, "LIGHT_", filename, sizeof(filename));
+  getTimestampString(time, timestamp, sizeof(timestamp));
+  
+  File logFile = SD.open(filename, FILE_WRITE);
+  
+  if (logFile) {
+    logFile.print(timestamp);
+    logFile.print(" | Event: ");
+    logFile.print(getLightEventName(event.type));
+    logFile.print(" | Light: ");
+    logFile.print(event.level);
+    
+    if (event.type == LIGHT_EVENT_CLOSED) {
+      char opened[24];
+      getTimestampString(DateTime(event.openedAt), opened, sizeof(opened));
+      logFile.print(" | Opened: ");
+      logFile.print(opened);
+      logFile.print(" | Duration: ");
+      logFile.print(event.duration);
+      logFile.print(" s");
+    }
+    logFile.println();
+    
+    logFile.close();
+    return true;
+  } else {
+    Serial.print("Error opening light log file: ");
+    Serial.println(filename);
+    return false;
+  }
+}
+
 /**
  * Generate filename based on date and prefix
  */
@@ -270,7 +515,7 @@ bool logSensorData(DateTime time, EnvData envData, float* audioEnergy,
   if (logFile) {
     // If file is newly created, write header
     if (logFile.size() == 0) {
-      logFile.println("Timestamp,Temperature(C),Humidity(%),Pressure(hPa),Weight(kg),Light,AccelX,AccelY,AccelZ,B1,B2,B3,B4,Battery(V),Status");
+      logFile.println("Timestamp,Temperature(C),Humidity(%),Pressure(hPa),Weight(kg),Light(lux),AccelX,AccelY,AccelZ,B1,B2,B3,B4,Battery(V),Status,State,StateP,Motion(g)");
     }
     
     // Log data
@@ -303,16 +548,19 @@ bool logSensorData(DateTime time, EnvData envData, float* audioEnergy,
     logFile.print(batteryVoltage);
     logFile.print(",");
     
-    // Overall status (most critical of all subsystems)
+    // Overall status from the fused colony state, not any single sensor
     const char* status = "Nominal";
-    if (getEnvAlertStatus() != ENV_STATUS_NOMINAL || 
-        getCurrentSoundClass() == SOUND_ALARM ||
-        getMotionStatus() != MOTION_NOMINAL ||
-        getLightStatus() != LIGHT_ENCLOSED ||
-        getWeightStatus() != WEIGHT_STABLE) {
+    if (1.0f - colonyState.probability(COLONY_NORMAL) >= COLONY_ALERT_PROBABILITY) {
       status = "Alert";
     }
-    logFile.println(status);
+    ColonyState state = colonyState.mostLikely();
+    logFile.print(status);
+    logFile.print(",");
+    logFile.print(getColonyStateName(state));
+    logFile.print(",");
+    logFile.print(colonyState.probability(state), 3);
+    logFile.print(",");
+    logFile.println(motionData.activity, 4);
     
     logFile.close();
     return true;
@@ -16,6 +16,29 @@
 #include "light_sensing.h"
 #include "weight_sensing.h"
 #include "audio_processing.h"
+#include "colony_state.h"
+#include "learning_stats.h"
+
+// Daily weight summary log, one row per day
+#define DAILY_WEIGHT_FILE     "DAILY.CSV"
+
+// Binary weight burst log, appended one record per burst
+#define WEIGHT_BURST_FILE     "WBURST.BIN"
+#define WEIGHT_BURST_MAGIC    0x54534257UL  // "WBST" in little-endian
+#define WEIGHT_BURST_VERSION  2
+
+// Header written before each burst's int16 samples
+typedef struct __attribute__((packed)) {
+  uint32_t magic;       // WEIGHT_BURST_MAGIC
+  uint8_t version;      // WEIGHT_BURST_VERSION
+  uint8_t rateHz;       // Nominal sample rate
+  uint16_t count;       // Samples that follow (int16 grams)
+  uint32_t startTime;   // Unix time of the first sample
+  uint32_t durationMs;  // Capture start to the last sample (ms)
+  float baseWeight;     // Weight the samples are relative to (kg)
+  uint8_t channel;      // Weight channel traced
+  uint8_t reserved[3];  // Zero
+} WeightBurstHeader;
 
 // Function prototypes
 bool setupDataLogging(int csPin, RTC_PCF8523 *rtc);
@@ -28,11 +51,20 @@ bool logSensorData(DateTime time, EnvData envData, float* audioEnergy,
                    MotionData motionData, LightData lightData, 
                    float weight, float batteryVoltage);
                    
+// Colony state fused from all subsystem statuses
+void updateColonyState();
+ColonyState getColonyState();
+float getColonyStateProbability(ColonyState state);
+
 // Subsystem-specific logging
 bool logAudioData(DateTime time, float* audioEnergy, SoundClass soundClass);
 bool logEnvironmentalData(DateTime time, EnvData envData);
-bool logWeightData(DateTime time, float weight, WeightStatus status);
+bool logWeightData(DateTime time, uint8_t channel, const WeightReading& reading);
 bool logMotionData(DateTime time, MotionData motionData, MotionStatus status);
+bool logMotionEvent(DateTime time, const MotionEvent& event);
 bool logLightData(DateTime time, LightData lightData);
+bool logLightEvent(DateTime time, const LightEvent& event);
+bool logWeightBurst(const WeightBurst* burst);
+bool logDailyWeightSummary(const DailyWeightSummary& day);
 
 #endif // DATA_LOGGING_H
\ No newline at end of file
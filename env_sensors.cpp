@@ -66,13 +66,15 @@ void readEnvSensors() {
   envData.temperature = 0.0f;
   envData.humidity = 0.0f;
   envData.pressure = 0.0f;
+  envData.ambientTemperature = NAN;
   
   // Read SHT31 (primary temperature and humidity)
   envData.temperature = sht.readTemperature();
   envData.humidity = sht.readHumidity();
   
   // Check if readings are valid
-  if (isnan(envData.temperature) || isnan(envData.humidity)) {
+  bool shtValid = !isnan(envData.temperature) && !isnan(envData.humidity);
+  if (!shtValid) {
     Serial.println("SHT31 read failed!");
     
     // Fall back to BME280 for temperature if available
@@ -82,9 +84,13 @@ void readEnvSensors() {
     }
   }
   
-  // Read BME280 for pressure
+  // Read BME280 for pressure, and for ambient temperature unless it
+  // stood in for the SHT31
   if (bme.takeForcedMeasurement()) {
     envData.pressure = bme.readPressure() / 100.0F; // Convert Pa to hPa
+    if (shtValid) {
+      envData.ambientTemperature = bme.readTemperature();
+    }
   } else {
     Serial.println("BME280 forced measurement failed!");
   }
@@ -94,6 +100,9 @@ void readEnvSensors() {
   Serial.print("Temperature: "); Serial.print(envData.temperature); Serial.println(" °C");
   Serial.print("Humidity: "); Serial.print(envData.humidity); Serial.println(" %");
   Serial.print("Pressure: "); Serial.print(envData.pressure); Serial.println(" hPa");
+  if (!isnan(envData.ambientTemperature)) {
+    Serial.print("Ambient: "); Serial.print(envData.ambientTemperature); Serial.println(" °C");
+  }
   
   // Determine alert status based on thresholds
   checkEnvAlerts();
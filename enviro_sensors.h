@@ -11,9 +11,10 @@
 
 // Structure to hold environmental data
 typedef struct {
-  float temperature;  // Temperature in Celsius
-  float humidity;     // Relative humidity percentage
-  float pressure;     // Barometric pressure in hPa
+  float temperature;         // Temperature in Celsius
+  float humidity;            // Relative humidity percentage
+  float pressure;            // Barometric pressure in hPa
+  float ambientTemperature;  // BME280 temperature in Celsius (NAN if unavailable)
 } EnvData;
 
 // Environment alert status
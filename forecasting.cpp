@@ -0,0 +1,445 @@
+/**
+ * Hive Monitor System - Forecasting Module
+ *
+ * This module implements an incremental Holt-Winters forecaster with
+ * level, trend and a daily seasonal component. The learning module uses
+ * its one-step-ahead prediction so anomaly checks compare a reading with
+ * what this colony would be expected to show at this time of day,
+ * given its recent trend. A harmonic (Fourier-series) daily model gives
+ * the same time-of-day expectation for multi-channel signals such as
+ * the audio bands.
+ */
+
+#include "forecasting.h"
+#include <math.h>
+
+// Longest gap (hours) over which the trend is extrapolated
+#define FORECAST_MAX_GAP_HOURS 24.0f
+
+// Seconds per day, the period of the harmonic model
+#define SECONDS_PER_DAY 86400UL
+
+/**
+ * Seasonal slot (hour of day) for a timestamp in seconds
+ */
+static inline uint8_t seasonSlot(uint32_t timestamp) {
+    return (timestamp / 3600UL) % FORECAST_SEASON_SLOTS;
+}
+
+/**
+ * Hours elapsed between two timestamps, clamped to the extrapolation limit
+ */
+static inline float elapsedHours(uint32_t from, uint32_t to) {
+    if (to <= from) {
+        return 0.0f;
+    }
+    float hours = (to - from) / 3600.0f;
+    return (hours > FORECAST_MAX_GAP_HOURS) ? FORECAST_MAX_GAP_HOURS : hours;
+}
+
+/**
+ * Initialize smoothing factors and clear state
+ */
+void HoltWintersForecaster::init(float alpha, float beta, float gamma,
+                                 float residualHalfLife) {
+    alpha_ = alpha;
+    beta_ = beta;
+    gamma_ = gamma;
+    residualAlpha_ = 1.0f - powf(0.5f, 1.0f / fmaxf(residualHalfLife, 1.0f));
+    level_ = 0.0f;
+    trend_ = 0.0f;
+    residualVar_ = 0.0f;
+    for (uint8_t i = 0; i < FORECAST_SEASON_SLOTS; i++) {
+        season_[i] = 0.0f;
+    }
+    count_ = 0;
+    lastTime_ = 0;
+}
+
+/**
+ * Predicted value at a given time
+ */
+float HoltWintersForecaster::forecast(uint32_t timestamp) const {
+    if (count_ == 0) {
+        return 0.0f;
+    }
+    return level_ + trend_ * elapsedHours(lastTime_, timestamp) +
+           season_[seasonSlot(timestamp)];
+}
+
+/**
+ * Add an observation and return its one-step-ahead forecast residual
+ * A non-finite value is ignored and returns 0.
+ */
+float HoltWintersForecaster::update(float value, uint32_t timestamp) {
+    if (!isfinite(value)) {
+        return 0.0f;
+    }
+    uint8_t slot = seasonSlot(timestamp);
+
+    if (count_ == 0) {
+        level_ = value;
+        lastTime_ = timestamp;
+        count_ = 1;
+        return 0.0f;
+    }
+
+    float hours = elapsedHours(lastTime_, timestamp);
+    float predictedLevel = level_ + trend_ * hours;
+    float residual = value - (predictedLevel + season_[slot]);
+
+    // Level, trend (per hour) and the seasonal offset for this hour
+    float previousLevel = level_;
+    level_ = alpha_ * (value - season_[slot]) + (1.0f - alpha_) * predictedLevel;
+    if (hours > 0.0f) {
+        trend_ = beta_ * (level_ - previousLevel) / hours + (1.0f - beta_) * trend_;
+    }
+    season_[slot] = gamma_ * (value - level_) + (1.0f - gamma_) * season_[slot];
+
+    // Residual spread, with a 1/n weight until warmed up
+    float weight = 1.0f / count_;
+    if (weight < residualAlpha_) {
+        weight = residualAlpha_;
+    }
+    residualVar_ = (1.0f - weight) * residualVar_ + weight * residual * residual;
+
+    if (count_ < UINT16_MAX) {
+        count_++;
+    }
+    lastTime_ = timestamp;
+    return residual;
+}
+
+/**
+ * Learned daily-cycle offset at a given time
+ */
+float HoltWintersForecaster::seasonalOffset(uint32_t timestamp) const {
+    return season_[seasonSlot(timestamp)];
+}
+
+/**
+ * Typical size of a one-step forecast error
+ */
+float HoltWintersForecaster::residualStdDev() const {
+    return sqrtf(residualVar_);
+}
+
+/**
+ * Peak-to-peak size of the learned daily cycle
+ */
+float HoltWintersForecaster::seasonalRange() const {
+    float low = season_[0];
+    float high = season_[0];
+    for (uint8_t i = 1; i < FORECAST_SEASON_SLOTS; i++) {
+        low = fminf(low, season_[i]);
+        high = fmaxf(high, season_[i]);
+    }
+    return high - low;
+}
+
+/**
+ * Get sample count (saturates at UINT16_MAX)
+ */
+uint16_t HoltWintersForecaster::count() const {
+    return count_;
+}
+
+/**
+ * Write the forecaster's fields to a record section
+ * The reserved bytes keep the layout of records written before the
+ * fields were serialized one by one.
+ */
+void HoltWintersForecaster::serialize(RecordWriter* out) const {
+    out->putFloat(alpha_);
+    out->putFloat(beta_);
+    out->putFloat(gamma_);
+    out->putFloat(residualAlpha_);
+    out->putFloat(level_);
+    out->putFloat(trend_);
+    out->putFloat(residualVar_);
+    out->putFloats(season_, FORECAST_SEASON_SLOTS);
+    out->putU16(count_);
+    out->putReserved(2);
+    out->putU32(lastTime_);
+}
+
+/**
+ * Read the forecaster's fields from a record section
+ */
+void HoltWintersForecaster::deserialize(RecordReader* in) {
+    alpha_ = in->getFloat();
+    beta_ = in->getFloat();
+    gamma_ = in->getFloat();
+    residualAlpha_ = in->getFloat();
+    level_ = in->getFloat();
+    trend_ = in->getFloat();
+    residualVar_ = in->getFloat();
+    in->getFloats(season_, FORECAST_SEASON_SLOTS);
+    count_ = in->getU16();
+    in->skip(2);
+    lastTime_ = in->getU32();
+}
+
+/**
+ * Initialize a daily harmonic model and clear its coefficients
+ */
+void DailyHarmonicModel::init(uint8_t channels, uint8_t harmonics, float halfLifeSamples) {
+    channels_ = (channels > HARMONIC_MAX_CHANNELS) ? HARMONIC_MAX_CHANNELS : channels;
+    order_ = (harmonics > HARMONIC_MAX_ORDER) ? HARMONIC_MAX_ORDER : harmonics;
+    alpha_ = 1.0f - powf(0.5f, 1.0f / fmaxf(halfLifeSamples, 1.0f));
+    count_ = 0;
+    for (uint8_t c = 0; c < HARMONIC_MAX_CHANNELS; c++) {
+        for (uint8_t t = 0; t < HARMONIC_TERMS; t++) {
+            coeffs_[c][t] = 0.0f;
+        }
+        residualVar_[c] = 0.0f;
+    }
+}
+
+/**
+ * cos(k w t) and sin(k w t) for k = 1..order at a time of day
+ * Only the fundamental calls sinf/cosf; higher harmonics use angle addition.
+ */
+void DailyHarmonicModel::basis(uint32_t timestamp, float* cosines, float* sines) const {
+    float phase = 2.0f * (float)M_PI * (timestamp % SECONDS_PER_DAY) / SECONDS_PER_DAY;
+    float c1 = cosf(phase);
+    float s1 = sinf(phase);
+    cosines[0] = c1;
+    sines[0] = s1;
+    for (uint8_t k = 1; k < order_; k++) {
+        cosines[k] = cosines[k - 1] * c1 - sines[k - 1] * s1;
+        sines[k] = sines[k - 1] * c1 + cosines[k - 1] * s1;
+    }
+}
+
+/**
+ * Add one sample per channel
+ * Normalized LMS step: the cos/sin regressors have variance 1/2, so their
+ * coefficients take twice the step of the mean. Early samples use a 1/n
+ * step so the fit starts as a running projection rather than from zero.
+ * A channel with a non-finite value is left unchanged.
+ */
+void DailyHarmonicModel::update(const float* values, uint32_t timestamp) {
+    float cosines[HARMONIC_MAX_ORDER];
+    float sines[HARMONIC_MAX_ORDER];
+    basis(timestamp, cosines, sines);
+
+    if (count_ < UINT16_MAX) {
+        count_++;
+    }
+    float weight = fmaxf(1.0f / count_, alpha_);
+
+    for (uint8_t c = 0; c < channels_; c++) {
+        if (!isfinite(values[c])) {
+            continue;
+        }
+        float* coeffs = coeffs_[c];
+        float predicted = coeffs[0];
+        for (uint8_t k = 0; k < order_; k++) {
+            predicted += coeffs[1 + 2 * k] * cosines[k] + coeffs[2 + 2 * k] * sines[k];
+        }
+        float residual = values[c] - predicted;
+
+        // The first prediction is meaningless, so it doesn't count as spread
+        if (count_ > 1) {
+            float varWeight = fmaxf(1.0f / (count_ - 1), alpha_);
+            residualVar_[c] = (1.0f - varWeight) * residualVar_[c] +
+                              varWeight * residual * residual;
+        }
+
+        coeffs[0] += weight * residual;
+        for (uint8_t k = 0; k < order_; k++) {
+            coeffs[1 + 2 * k] += 2.0f * weight * residual * cosines[k];
+            coeffs[2 + 2 * k] += 2.0f * weight * residual * sines[k];
+        }
+    }
+}
+
+/**
+ * Expected value of every channel at a time of day
+ */
+void DailyHarmonicModel::expected(uint32_t timestamp, float* values) const {
+    float cosines[HARMONIC_MAX_ORDER];
+    float sines[HARMONIC_MAX_ORDER];
+    basis(timestamp, cosines, sines);
+
+    for (uint8_t c = 0; c < channels_; c++) {
+        const float* coeffs = coeffs_[c];
+        float value = coeffs[0];
+        for (uint8_t k = 0; k < order_; k++) {
+            value += coeffs[1 + 2 * k] * cosines[k] + coeffs[2 + 2 * k] * sines[k];
+        }
+        values[c] = value;
+    }
+}
+
+/**
+ * Typical size of a channel's deviation from its daily profile
+ */
+float DailyHarmonicModel::residualStdDev(uint8_t channel) const {
+    return sqrtf(residualVar_[channel]);
+}
+
+/**
+ * Get sample count (saturates at UINT16_MAX)
+ */
+uint16_t DailyHarmonicModel::count() const {
+    return count_;
+}
+
+/**
+ * Write the model's fields to a record section
+ */
+void DailyHarmonicModel::serialize(RecordWriter* out) const {
+    out->putU8(channels_);
+    out->putU8(order_);
+    out->putU16(count_);
+    out->putFloat(alpha_);
+    for (uint8_t i = 0; i < HARMONIC_MAX_CHANNELS; i++) {
+        out->putFloats(coeffs_[i], HARMONIC_TERMS);
+    }
+    out->putFloats(residualVar_, HARMONIC_MAX_CHANNELS);
+}
+
+/**
+ * Read the model's fields from a record section
+ */
+void DailyHarmonicModel::deserialize(RecordReader* in) {
+    channels_ = in->getU8();
+    order_ = in->getU8();
+    if (channels_ > HARMONIC_MAX_CHANNELS) {
+        channels_ = HARMONIC_MAX_CHANNELS;
+    }
+    if (order_ > HARMONIC_MAX_ORDER) {
+        order_ = HARMONIC_MAX_ORDER;
+    }
+    count_ = in->getU16();
+    alpha_ = in->getFloat();
+    for (uint8_t i = 0; i < HARMONIC_MAX_CHANNELS; i++) {
+        in->getFloats(coeffs_[i], HARMONIC_TERMS);
+    }
+    in->getFloats(residualVar_, HARMONIC_MAX_CHANNELS);
+}
+
+/**
+ * Initialize with zero coefficients and P = initialCovariance * I
+ * forgetting is lambda; 1 - lambda is about 1 / effective window length.
+ */
+void RecursiveLeastSquares::init(uint8_t dim, float forgetting, float initialCovariance) {
+    dim_ = (dim > RLS_MAX_DIM) ? RLS_MAX_DIM : dim;
+    count_ = 0;
+    forgetting_ = fminf(fmaxf(forgetting, 0.5f), 1.0f);
+    maxTrace_ = initialCovariance * dim_;
+
+    for (uint8_t i = 0; i < RLS_MAX_DIM; i++) {
+        theta_[i] = 0.0f;
+        for (uint8_t j = 0; j < RLS_MAX_DIM; j++) {
+            cov_[i][j] = (i == j) ? initialCovariance : 0.0f;
+        }
+    }
+}
+
+/**
+ * Fit one observation; returns the prior prediction error
+ */
+float RecursiveLeastSquares::update(const float* x, float y) {
+    // Gain k = P x / (lambda + x' P x)
+    float px[RLS_MAX_DIM];
+    float denominator = forgetting_;
+    for (uint8_t i = 0; i < dim_; i++) {
+        px[i] = 0.0f;
+        for (uint8_t j = 0; j < dim_; j++) {
+            px[i] += cov_[i][j] * x[j];
+        }
+        denominator += x[i] * px[i];
+    }
+
+    float error = y - predict(x);
+    float inverse = 1.0f / denominator;
+    for (uint8_t i = 0; i < dim_; i++) {
+        theta_[i] += px[i] * inverse * error;
+    }
+
+    // P = (P - k x' P) / lambda, kept symmetric; forgetting stops at the cap
+    float trace = 0.0f;
+    for (uint8_t i = 0; i < dim_; i++) {
+        for (uint8_t j = 0; j <= i; j++) {
+            float value = cov_[i][j] - px[i] * px[j] * inverse;
+            cov_[i][j] = value;
+            cov_[j][i] = value;
+        }
+        trace += cov_[i][i];
+    }
+    if (trace * (1.0f / forgetting_) < maxTrace_) {
+        for (uint8_t i = 0; i < dim_; i++) {
+            for (uint8_t j = 0; j < dim_; j++) {
+                cov_[i][j] *= 1.0f / forgetting_;
+            }
+        }
+    }
+
+    if (count_ < UINT16_MAX) {
+        count_++;
+    }
+    return error;
+}
+
+/**
+ * Predicted response for a regressor vector
+ */
+float RecursiveLeastSquares::predict(const float* x) const {
+    float value = 0.0f;
+    for (uint8_t i = 0; i < dim_; i++) {
+        value += theta_[i] * x[i];
+    }
+    return value;
+}
+
+/**
+ * Get one fitted coefficient
+ */
+float RecursiveLeastSquares::coefficient(uint8_t index) const {
+    return theta_[index];
+}
+
+/**
+ * Get sample count (saturates at UINT16_MAX)
+ */
+uint16_t RecursiveLeastSquares::count() const {
+    return count_;
+}
+
+/**
+ * Write the regression's fields to a record section
+ * The reserved byte keeps the layout of records written before the
+ * fields were serialized one by one.
+ */
+void RecursiveLeastSquares::serialize(RecordWriter* out) const {
+    out->putU8(dim_);
+    out->putReserved(1);
+    out->putU16(count_);
+    out->putFloat(forgetting_);
+    out->putFloat(maxTrace_);
+    out->putFloats(theta_, RLS_MAX_DIM);
+    for (uint8_t i = 0; i < RLS_MAX_DIM; i++) {
+        out->putFloats(cov_[i], RLS_MAX_DIM);
+    }
+}
+
+/**
+ * Read the regression's fields from a record section
+ */
+void RecursiveLeastSquares::deserialize(RecordReader* in) {
+    dim_ = in->getU8();
+    if (dim_ > RLS_MAX_DIM) {
+        dim_ = RLS_MAX_DIM;
+    }
+    in->skip(1);
+    count_ = in->getU16();
+    forgetting_ = in->getFloat();
+    maxTrace_ = in->getFloat();
+    in->getFloats(theta_, RLS_MAX_DIM);
+    for (uint8_t i = 0; i < RLS_MAX_DIM; i++) {
+        in->getFloats(cov_[i], RLS_MAX_DIM);
+    }
+}
\ No newline at end of file
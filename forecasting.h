@@ -0,0 +1,118 @@
+/**
+ * Hive Monitor System - Forecasting Header
+ *
+ * Header file for the seasonal forecaster used by the learning module
+ * to predict weight and brood temperature one wake ahead, the daily
+ * audio profile, and the online regression used for load-cell drift.
+ * Wake times are passed in as Unix seconds rather than read from the
+ * RTC, so the replay tool can drive these models from a CSV log.
+ */
+
+#ifndef FORECASTING_H
+#define FORECASTING_H
+
+#include <stdint.h>
+#include "record_sections.h"
+
+// Seasonal slots per day (one per hour)
+#define FORECAST_SEASON_SLOTS 24
+
+// Additive Holt-Winters (triple exponential smoothing) forecaster with a
+// daily seasonal component. Wakes are not evenly spaced (low battery
+// stretches the interval), so the trend is kept per hour and the season
+// is indexed by hour of day rather than by sample number. O(1) per update.
+class HoltWintersForecaster {
+public:
+    HoltWintersForecaster() : count_(0), lastTime_(0) {}
+
+    void init(float alpha, float beta, float gamma, float residualHalfLife);
+    float forecast(uint32_t timestamp) const;
+    float update(float value, uint32_t timestamp);
+    void serialize(RecordWriter* out) const;
+    void deserialize(RecordReader* in);
+
+    float seasonalOffset(uint32_t timestamp) const;
+    float residualStdDev() const;
+    float seasonalRange() const;
+    uint16_t count() const;
+
+private:
+    float alpha_;                          // Level smoothing
+    float beta_;                           // Trend smoothing
+    float gamma_;                          // Seasonal smoothing
+    float residualAlpha_;                  // Residual variance smoothing
+    float level_;                          // Deseasonalized level
+    float trend_;                          // Level change per hour
+    float residualVar_;                    // EW variance of one-step residuals
+    float season_[FORECAST_SEASON_SLOTS];  // Additive offset per hour of day
+    uint16_t count_;                       // Samples seen, saturating
+    uint32_t lastTime_;                    // Timestamp of the last update (s)
+};
+
+// Largest number of channels and harmonics in a daily harmonic model
+#define HARMONIC_MAX_CHANNELS 4
+#define HARMONIC_MAX_ORDER    3
+
+// Coefficients per channel: mean plus a cosine/sine pair per harmonic
+#define HARMONIC_TERMS (1 + 2 * HARMONIC_MAX_ORDER)
+
+// Daily profile as a short Fourier series per channel,
+// x(t) = a0 + sum_k (a_k cos(k w t) + b_k sin(k w t)) with w = 2 pi / day,
+// fitted online by normalized LMS with an exponential forgetting factor.
+// Evaluation is O(channels x harmonics): one sin/cos per call, higher
+// harmonics by angle addition. Memory ~140 bytes at 4 channels x 3 harmonics.
+class DailyHarmonicModel {
+public:
+    DailyHarmonicModel() : channels_(0), order_(0), count_(0) {}
+
+    void init(uint8_t channels, uint8_t harmonics, float halfLifeSamples);
+    void update(const float* values, uint32_t timestamp);
+    void expected(uint32_t timestamp, float* values) const;
+    void serialize(RecordWriter* out) const;
+    void deserialize(RecordReader* in);
+
+    float residualStdDev(uint8_t channel) const;
+    uint16_t count() const;
+
+private:
+    void basis(uint32_t timestamp, float* cosines, float* sines) const;
+
+    uint8_t channels_;                                        // Channels in use
+    uint8_t order_;                                           // Harmonics in use
+    uint16_t count_;                                          // Samples seen, saturating
+    float alpha_;                                             // Per-sample forgetting weight
+    float coeffs_[HARMONIC_MAX_CHANNELS][HARMONIC_TERMS];    // a0, a1, b1, a2, b2, ...
+    float residualVar_[HARMONIC_MAX_CHANNELS];                // EW variance of fit residuals
+};
+
+// Largest number of regressors in a recursive least-squares fit
+#define RLS_MAX_DIM 3
+
+// Recursive least-squares linear regression y = theta . x with an
+// exponential forgetting factor. Each update is O(k^2) for k regressors
+// with no matrix inversion. While a regressor is not excited (its input
+// stays near zero) forgetting would inflate its covariance without
+// bound, so the covariance trace is capped. Memory ~60 bytes at k = 3.
+class RecursiveLeastSquares {
+public:
+    RecursiveLeastSquares() : dim_(0), count_(0) {}
+
+    void init(uint8_t dim, float forgetting, float initialCovariance);
+    float update(const float* x, float y);
+    float predict(const float* x) const;
+    void serialize(RecordWriter* out) const;
+    void deserialize(RecordReader* in);
+
+    float coefficient(uint8_t index) const;
+    uint16_t count() const;
+
+private:
+    uint8_t dim_;                          // Regressors in use
+    uint16_t count_;                       // Samples seen, saturating
+    float forgetting_;                     // Forgetting factor lambda (0-1]
+    float maxTrace_;                       // Covariance trace cap
+    float theta_[RLS_MAX_DIM];             // Coefficients
+    float cov_[RLS_MAX_DIM][RLS_MAX_DIM];  // Scaled inverse information matrix P
+};
+
+#endif // FORECASTING_H
\ No newline at end of file
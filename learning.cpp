@@ -1,13 +1,16 @@
 /**
  * Hive Monitor System - Learning Module
- * 
+ *
  * This module implements adaptive learning capabilities for the hive monitor.
- * It collects baseline data on normal colony behavior and adjusts 
- * detection thresholds based on observed patterns.
+ * It collects baseline data on normal colony behavior and adjusts
+ * detection thresholds based on observed patterns. The learned state
+ * itself lives in a LearningModel (learning_model.h); this module owns
+ * the device's single instance, its persistence and its diagnostics.
  */
 
 #include "learning.h"
 #include "config.h"
+#include "record_store.h"
 #include <SD.h>
 #include <RTClib.h>
 #include <ArduinoJson.h>
@@ -16,23 +19,33 @@
 #define LEARNING_FILE "LEARN.DAT"
 #define LEARNING_JSON "LEARN.JSN"
 
-// Learning state
-static SensorBaseline colonyBaseline;
-static bool baselineEstablished = false;
-static uint16_t learningSampleCount = 0;
-static uint8_t currentSeason = 0;
-
-// Running statistics for incremental calculations
-static RunningStats tempStats;
-static RunningStats humidityStats;
-static RunningStats pressureStats;
-static RunningStats weightStats;
-static RunningStats audioStats[NUM_AUDIO_BANDS];
-static RunningStats lightStats;
-static RunningStats motionStats;
-
-// Daily patterns storage (hour by season)
-static DailyPattern dailyPatterns[24][4];
+// Learned state of this colony
+static LearningModel colonyModel;
+
+// Feature names for diagnostics (order of JointFeature)
+static const char* jointFeatureNames[NUM_JOINT_FEATURES] = {
+    "Temp", "Humidity", "Pressure", "Weight",
+    "B1", "B2", "B3", "B4", "Motion", "Light"
+};
+
+// Size of one dump in the pre-slot LEARN.DAT format, which appended a
+// full copy on every save
+#define LEGACY_PATTERNS_SIZE (24 * NUM_SEASONS * sizeof(DailyPattern))
+#define LEGACY_RECORD_SIZE (sizeof(SensorBaseline) + LEGACY_PATTERNS_SIZE + \
+                            sizeof(uint16_t) + sizeof(uint8_t))
+
+// A/B slot store for LEARN.DAT and its serialization buffer. The
+// buffer is free while a legacy file is migrated, so it also holds the
+// legacy patterns, as a properly aligned DailyPattern array.
+static RecordStore learningStore;
+static union {
+    uint8_t record[LEARNING_SLOT_SIZE - sizeof(RecordHeader)];
+    DailyPattern legacyPatterns[24][NUM_SEASONS];
+} learningBuffer;
+
+// Save scheduling
+static uint16_t samplesSinceSave = 0;
+static bool jsonExportStale = true;
 
 /**
  * Initialize learning system
@@ -40,146 +53,123 @@ static DailyPattern dailyPatterns[24][4];
 void setupLearning() {
     Serial.println("Initializing learning system...");
     
+    recordStoreInit(&learningStore, LEARNING_FILE, LEARNING_SLOT_SIZE);
+    
+    // Start from defaults so sections missing from the saved record keep them
+    resetLearningSystem();
+    
     // Try to load existing learning data
     if (loadLearnedParameters()) {
         Serial.println("Loaded existing learning parameters");
-        baselineEstablished = true;
     } else {
         Serial.println("No saved learning data, starting with defaults");
-        resetLearningSystem();
     }
     
     // Determine current season
-    DateTime now;
     if (rtcIsRunning()) {
-        now = getRTCTime();
-        currentSeason = getSeason(now.month());
+        colonyModel.setSeason(getSeason(getRTCTime().month()));
     } else {
-        currentSeason = 0; // Default to first season
+        colonyModel.setSeason(0); // Default to first season
     }
     
     Serial.print("Current season: ");
-    Serial.println(currentSeason);
+    Serial.println(colonyModel.season());
 }
 
 /**
  * Reset learning system to defaults
  */
 void resetLearningSystem() {
-    // Initialize with sensible defaults
-    colonyBaseline.tempMean = 35.0;         // °C
-    colonyBaseline.tempStdDev = 2.0;        // °C
-    colonyBaseline.humidityMean = 60.0;     // %
-    colonyBaseline.humidityStdDev = 5.0;    // %
-    colonyBaseline.pressureMean = 1013.25;  // hPa
-    colonyBaseline.pressureStdDev = 5.0;    // hPa
-    colonyBaseline.weightMean = 0.0;        // kg
-    colonyBaseline.weightStdDev = 1.0;      // kg
-    colonyBaseline.weightDailyDelta = 0.2;  // kg
-    
-    // Audio energy defaults
-    colonyBaseline.audioEnergy[0] = THRESH_B1; // Normal hum band
-    colonyBaseline.audioEnergy[1] = THRESH_B2; // Queen piping band
-    colonyBaseline.audioEnergy[2] = THRESH_B3; // Swarming band
-    colonyBaseline.audioEnergy[3] = THRESH_B4; // Alarm band
-    
-    for (int i = 0; i < NUM_AUDIO_BANDS; i++) {
-        colonyBaseline.audioStdDev[i] = 0.1; // Initial std deviation
-        audioStats[i].reset();
-    }
-    
-    // Reset running statistics
-    tempStats.reset();
-    humidityStats.reset();
-    pressureStats.reset();
-    weightStats.reset();
-    lightStats.reset();
-    motionStats.reset();
-    
-    // Reset learning counter
-    learningSampleCount = 0;
-    
-    // Initialize daily patterns
-    for (int h = 0; h < 24; h++) {
-        for (int s = 0; s < 4; s++) {
-            dailyPatterns[h][s].activityLevel = 0.5;    // Medium activity
-            dailyPatterns[h][s].tempOffset = 0.0;       // No offset
-            dailyPatterns[h][s].humidityOffset = 0.0;   // No offset
-            dailyPatterns[h][s].sampleCount = 0;
-        }
-    }
-    
-    baselineEstablished = false;
+    colonyModel.reset();
+    jsonExportStale = true;
 }
 
 /**
  * Process new sensor readings and update learning model
  */
-void updateLearningModel(EnvData envData, float* audioEnergy, 
-                        MotionData motionData, LightData lightData, 
-                        float weight, DateTime timestamp) {
-    
-    // Increment sample counter
-    learningSampleCount++;
-    
-    // Update running statistics
-    tempStats.addSample(envData.temperature);
-    humidityStats.addSample(envData.humidity);
-    pressureStats.addSample(envData.pressure);
-    weightStats.addSample(weight);
-    
-    // Audio energy for each band
+void updateLearningModel(EnvData envData, float* audioEnergy,
+                        MotionData motionData, LightData lightData,
+                        float weight, float rawWeight, DateTime timestamp) {
+    
+    LearningSample sample;
+    sample.time = timestamp.unixtime();
+    sample.month = timestamp.month();
+    sample.temperature = envData.temperature;
+    sample.ambientTemperature = THERMO_AMBIENT_REFERENCE ? envData.ambientTemperature : NAN;
+    sample.humidity = envData.humidity;
+    sample.pressure = envData.pressure;
+    sample.weight = weight;
+    sample.rawWeight = rawWeight;
     for (int i = 0; i < NUM_AUDIO_BANDS; i++) {
-        audioStats[i].addSample(audioEnergy[i]);
+        sample.audioEnergy[i] = audioEnergy[i];
     }
     
-    // Motion magnitude
-    float motionMag = sqrt(motionData.accelX*motionData.accelX + 
-                          motionData.accelY*motionData.accelY + 
-                          motionData.accelZ*motionData.accelZ);
-    motionStats.addSample(motionMag);
+    // Motion activity with gravity removed
+    sample.motion = motionData.activity;
     
     // Light level
-    lightStats.addSample(lightData.lightLevel);
-    
-    // Update daily pattern for current hour and season
-    int hour = timestamp.hour();
-    int season = getSeason(timestamp.month());
-    
-    // Activity level is based on audio energy in normal band and motion
-    float activity = (audioEnergy[0] / colonyBaseline.audioEnergy[0]) * 0.8f + 
-                    (motionMag / motionStats.mean()) * 0.2f;
-    
-    updateDailyPattern(hour, season, activity, envData.temperature, envData.humidity);
+    sample.light = lightData.lightLevel;
+    
+    uint8_t events = colonyModel.update(sample);
+    samplesSinceSave++;
+    jsonExportStale = true;
+    
+    if (events & LEARNING_EVENT_JOINT_ANOMALY) {
+        float contributions[NUM_JOINT_FEATURES];
+        float score = colonyModel.jointAnomalyScore(contributions);
+        uint8_t top = 0;
+        for (uint8_t i = 1; i < NUM_JOINT_FEATURES; i++) {
+            if (contributions[i] > contributions[top]) {
+                top = i;
+            }
+        }
+        Serial.print("Joint anomaly score: ");
+        Serial.print(score);
+        Serial.print(" (largest contribution: ");
+        Serial.print(jointFeatureNames[top]);
+        Serial.println(")");
+    }
     
-    // After sufficient samples, establish baseline
-    if (learningSampleCount >= LEARNING_SAMPLES_MIN && !baselineEstablished) {
-        updateBaseline();
-        baselineEstablished = true;
+    if (events & LEARNING_EVENT_ESTABLISHED) {
+        printBaseline();
         Serial.println("Baseline established!");
-        saveLearnedParameters();
     }
     
-    // Periodically update baseline with slow adaptation rate
-    if (baselineEstablished && learningSampleCount % LEARNING_UPDATE_INTERVAL == 0) {
-        updateBaselineAdaptive();
-        saveLearnedParameters();
+    if (events & LEARNING_EVENT_ADAPTED) {
+        Serial.println("Updated adaptive baseline:");
+        printBaseline();
+    }
+    
+    float thermoregulation = colonyModel.thermoregulationScore();
+    if (!isnan(thermoregulation)) {
+        Serial.print("Thermoregulation: ");
+        Serial.println(thermoregulation, 2);
     }
     
-    // Periodically save learning data
-    if (learningSampleCount % LEARNING_SAVE_INTERVAL == 0) {
-        saveLearnedParameters();
+    if (events & LEARNING_EVENT_DAY_COMPLETE) {
+        const DailyWeightSummary& day = colonyModel.dailyWeightSummary();
+        Serial.print("Daily weight: gain ");
+        Serial.print(day.dailyGain, 2);
+        Serial.print(" kg, net flow ");
+        Serial.print(day.netFlow, 2);
+        Serial.print(" kg, overnight loss ");
+        Serial.print(day.overnightLoss, 2);
+        Serial.println(" kg");
+        logDailyWeightSummary(day);
     }
     
+    // Saving is deferred to commitLearningState() at the end of the wake
+    
     // Log learning progress
+    uint16_t learningSampleCount = colonyModel.sampleCount();
     if (learningSampleCount % 10 == 0 || learningSampleCount == LEARNING_SAMPLES_MIN) {
         Serial.print("Learning progress: ");
         Serial.print(learningSampleCount);
-        if (!baselineEstablished) {
+        if (!colonyModel.isBaselineEstablished()) {
             Serial.print("/");
             Serial.print(LEARNING_SAMPLES_MIN);
             Serial.print(" (");
-            Serial.print((learningSampleCount * 100) / LEARNING_SAMPLES_MIN);
+            Serial.print(colonyModel.progress());
             Serial.println("%)");
         } else {
             Serial.println(" samples collected");
@@ -188,220 +178,226 @@ void updateLearningModel(EnvData envData, float* audioEnergy,
 }
 
 /**
- * Update baseline from collected statistics
+ * Persist pending learning changes once at the end of a wake
+ * A changed baseline is written straight away; pattern and counter
+ * updates are batched until LEARNING_SAVE_INTERVAL samples accumulate.
+ * The JSON copy is only produced when exportJson is set (on demand or
+ * while a phone is connected) since nothing on the device reads it.
  */
-void updateBaseline() {
-    // Update environmental baselines
-    colonyBaseline.tempMean = tempStats.mean();
-    colonyBaseline.tempStdDev = tempStats.standardDeviation();
-    
-    colonyBaseline.humidityMean = humidityStats.mean();
-    colonyBaseline.humidityStdDev = humidityStats.standardDeviation();
-    
-    colonyBaseline.pressureMean = pressureStats.mean();
-    colonyBaseline.pressureStdDev = pressureStats.standardDeviation();
-    
-    colonyBaseline.weightMean = weightStats.mean();
-    colonyBaseline.weightStdDev = weightStats.standardDeviation();
+bool commitLearningState(bool exportJson) {
+    uint16_t dirtySections = colonyModel.dirtySections();
+    bool saveDue = (dirtySections & LEARNING_DIRTY_BASELINE) ||
+                   samplesSinceSave >= LEARNING_SAVE_INTERVAL;
+    
+    bool success = true;
+    if (dirtySections != 0 && saveDue) {
+        success = saveLearnedParameters();
+    }
     
-    // Update audio energy baselines
-    for (int i = 0; i < NUM_AUDIO_BANDS; i++) {
-        colonyBaseline.audioEnergy[i] = audioStats[i].mean();
-        colonyBaseline.audioStdDev[i] = audioStats[i].standardDeviation();
+    if (exportJson && jsonExportStale) {
+        if (saveJsonParameters()) {
+            jsonExportStale = false;
+        } else {
+            success = false;
+        }
     }
     
+    return success;
+}
+
+/**
+ * Update baseline from collected statistics
+ */
+void updateBaseline() {
+    colonyModel.updateBaseline();
+    
     // Log the new baseline
     printBaseline();
 }
 
 /**
  * Update baseline with adaptive rate (slower changes over time)
+ * The statistics are exponentially weighted with per-sensor half-lives,
+ * so the adapted baseline is simply their current snapshot - no window
+ * blending or resets are needed.
  */
 void updateBaselineAdaptive() {
-    float adaptRate = LEARNING_ADAPTATION_RATE;
-    
-    // Slowly adapt baseline to seasonal changes
-    colonyBaseline.tempMean = (1-adaptRate) * colonyBaseline.tempMean + 
-                             adaptRate * tempStats.mean();
-    colonyBaseline.tempStdDev = (1-adaptRate) * colonyBaseline.tempStdDev + 
-                               adaptRate * tempStats.standardDeviation();
-    
-    colonyBaseline.humidityMean = (1-adaptRate) * colonyBaseline.humidityMean + 
-                                adaptRate * humidityStats.mean();
-    colonyBaseline.humidityStdDev = (1-adaptRate) * colonyBaseline.humidityStdDev + 
-                                  adaptRate * humidityStats.standardDeviation();
-    
-    colonyBaseline.pressureMean = (1-adaptRate) * colonyBaseline.pressureMean + 
-                                adaptRate * pressureStats.mean();
-    
-    // Weight changes more slowly with seasons
-    colonyBaseline.weightMean = (1-adaptRate/2) * colonyBaseline.weightMean + 
-                              (adaptRate/2) * weightStats.mean();
-    
-    // Update audio energy baselines (more responsive)
-    for (int i = 0; i < NUM_AUDIO_BANDS; i++) {
-        colonyBaseline.audioEnergy[i] = (1-adaptRate*2) * colonyBaseline.audioEnergy[i] + 
-                                       (adaptRate*2) * audioStats[i].mean();
-        colonyBaseline.audioStdDev[i] = (1-adaptRate) * colonyBaseline.audioStdDev[i] + 
-                                      adaptRate * audioStats[i].standardDeviation();
-    }
-    
-    // Reset statistics for next adaptation period
-    tempStats.reset();
-    humidityStats.reset();
-    pressureStats.reset();
-    audioStats[0].reset();
-    audioStats[1].reset();
-    audioStats[2].reset();
-    audioStats[3].reset();
-    
-    // Keep weight history longer
-    weightStats.partialReset(0.8);
-    
-    // Log the updated baseline
     Serial.println("Updated adaptive baseline:");
-    printBaseline();
+    updateBaseline();
 }
 
 /**
- * Update daily pattern for specific hour and season
+ * Update daily pattern for specific 15-minute slot and season
  */
-void updateDailyPattern(uint8_t hour, uint8_t season, float activity, 
+void updateDailyPattern(uint8_t slot, uint8_t season, float activity,
                        float temp, float humidity) {
-    
-    DailyPattern* pattern = &dailyPatterns[hour][season];
-    
-    // Calculate adaptation rate (faster when fewer samples)
-    float adaptRate = min(0.5f, 5.0f / (pattern->sampleCount + 10.0f));
-    
-    // Update pattern
-    pattern->activityLevel = (1-adaptRate) * pattern->activityLevel + 
-                           adaptRate * activity;
-    
-    pattern->tempOffset = (1-adaptRate) * pattern->tempOffset + 
-                         adaptRate * (temp - colonyBaseline.tempMean);
-    
-    pattern->humidityOffset = (1-adaptRate) * pattern->humidityOffset + 
-                            adaptRate * (humidity - colonyBaseline.humidityMean);
-    
-    pattern->sampleCount++;
+    colonyModel.updateDailyPattern(slot, season, activity, temp, humidity);
 }
 
 /**
- * Get the current season (0-3) based on month
+ * Check if a temperature reading is anomalous based on learned patterns
  */
-uint8_t getSeason(uint8_t month) {
-    // Simple season calculation
-    // 0 = Winter (Dec-Feb), 1 = Spring (Mar-May), 
-    // 2 = Summer (Jun-Aug), 3 = Fall (Sep-Nov)
-    if (month == 12 || month == 1 || month == 2) return 0;
-    if (month >= 3 && month <= 5) return 1;
-    if (month >= 6 && month <= 8) return 2;
-    return 3; // Fall (Sep-Nov)
+bool isTemperatureAnomaly(float temperature, DateTime time) {
+    return colonyModel.isTemperatureAnomaly(temperature, time.unixtime());
 }
 
 /**
- * Check if a temperature reading is anomalous based on learned patterns
+ * Check if humidity is anomalous based on learned patterns
  */
-bool isTemperatureAnomaly(float temperature, uint8_t hour) {
-    // Get expected temperature for current time and season
-    float expectedTemp = colonyBaseline.tempMean + 
-                        dailyPatterns[hour][currentSeason].tempOffset;
-    
-    // Calculate z-score (standard deviations from mean)
-    float zScore = (temperature - expectedTemp) / colonyBaseline.tempStdDev;
-    
-    // Consider anomaly if more than ANOMALY_THRESHOLD standard deviations from mean
-    return abs(zScore) > TEMP_ANOMALY_THRESHOLD;
+bool isHumidityAnomaly(float humidity, DateTime time) {
+    return colonyModel.isHumidityAnomaly(humidity, time.unixtime());
 }
 
 /**
- * Check if humidity is anomalous based on learned patterns
+ * Check if audio pattern is anomalous for this time of day
  */
-bool isHumidityAnomaly(float humidity, uint8_t hour) {
-    float expectedHumidity = colonyBaseline.humidityMean + 
-                           dailyPatterns[hour][currentSeason].humidityOffset;
-    
-    float zScore = (humidity - expectedHumidity) / colonyBaseline.humidityStdDev;
-    
-    return abs(zScore) > HUMIDITY_ANOMALY_THRESHOLD;
+bool isAudioAnomaly(float* audioLevels, DateTime time) {
+    return colonyModel.isAudioAnomaly(audioLevels, time.unixtime());
 }
 
 /**
- * Check if audio pattern is anomalous based on learned baselines
+ * Check if weight change is anomalous
  */
-bool isAudioAnomaly(float* audioLevels) {
-    // Check each frequency band
-    for (int i = 0; i < NUM_AUDIO_BANDS; i++) {
-        float zScore = (audioLevels[i] - colonyBaseline.audioEnergy[i]) / 
-                     max(0.01f, colonyBaseline.audioStdDev[i]);
-        
-        // Different thresholds for different bands
-        float threshold = (i == 0) ? 3.0f : 2.5f; // Normal band can vary more
-        
-        if (abs(zScore) > threshold) {
-            return true;
-        }
-    }
-    return false;
+bool isWeightAnomaly(float weight, float previousWeight, DateTime time) {
+    return colonyModel.isWeightAnomaly(weight, previousWeight, time.unixtime());
 }
 
 /**
- * Check if weight change is anomalous
+ * Get the brood-nest thermoregulation score (0-1, NAN while learning)
  */
-bool isWeightAnomaly(float weight, float previousWeight) {
-    // Short term change (sudden)
-    float change = weight - previousWeight;
-    if (abs(change) > WEIGHT_CHANGE_THRESHOLD * colonyBaseline.weightStdDev) {
-        return true;
-    }
-    
-    // Long term deviation from baseline
-    float zScore = (weight - colonyBaseline.weightMean) / colonyBaseline.weightStdDev;
-    if (abs(zScore) > WEIGHT_ANOMALY_THRESHOLD) {
-        return true;
-    }
-    
-    return false;
+float getThermoregulationScore() {
+    return colonyModel.thermoregulationScore();
+}
+
+/**
+ * Add one accelerometer sample (g) of the wake's motion burst
+ */
+void addMotionActivitySample(float ax, float ay, float az, float dt) {
+    colonyModel.addMotionSample(ax, ay, az, dt);
+}
+
+/**
+ * Score the wake's motion burst against the hive's learned activity
+ * Returns the z-score, and the burst's acceleration and jerk RMS
+ * through rms (g) and jerk (g/s).
+ */
+float endMotionActivityWindow(float* rms, float* jerk) {
+    float score = colonyModel.endMotionWindow();
+    *rms = colonyModel.motionActivity().rms();
+    *jerk = colonyModel.motionActivity().jerk();
+    return score;
+}
+
+/**
+ * Check whether the motion activity baseline is learned
+ */
+bool isMotionActivityLearned() {
+    return colonyModel.motionActivity().isReady();
+}
+
+/**
+ * Get the joint (squared Mahalanobis) anomaly score of the latest sample
+ * Optionally copies per-feature contributions, which sum to the score.
+ */
+float getJointAnomalyScore(float contributions[NUM_JOINT_FEATURES]) {
+    return colonyModel.jointAnomalyScore(contributions);
+}
+
+/**
+ * Get the forecast brood temperature at a given time
+ */
+float getForecastTemperature(DateTime time) {
+    return colonyModel.forecastTemperature(time.unixtime());
+}
+
+/**
+ * Get the forecast hive weight at a given time
+ */
+float getForecastWeight(DateTime time) {
+    return colonyModel.forecastWeight(time.unixtime());
+}
+
+/**
+ * Get the load-cell temperature drift to subtract from a raw weight (kg)
+ * rate is the temperature's rate of change in °C per hour.
+ */
+float getWeightTemperatureCorrection(float temperature, float rate) {
+    return colonyModel.weightTemperatureCorrection(temperature, rate);
+}
+
+/**
+ * Get the learned daily-cycle weight offset (e.g. forager departure dip)
+ * Zero until the weight forecaster is trained.
+ */
+float getWeightDailyOffset(DateTime time) {
+    return colonyModel.weightDailyOffset(time.unixtime());
+}
+
+/**
+ * Check if the latest sample is anomalous across all sensors jointly
+ */
+bool isJointAnomaly() {
+    return colonyModel.isJointAnomaly();
 }
 
 /**
  * Get adapted temperature thresholds based on learning
  */
-void getAdaptedTempThresholds(float* lowThreshold, float* highThreshold, uint8_t hour) {
-    float seasonalOffset = dailyPatterns[hour][currentSeason].tempOffset;
-    
-    // Base thresholds adjusted for this colony's normal patterns
-    *lowThreshold = max(MIN_SAFE_TEMP, TEMP_ALERT_LOW + 
-                      (colonyBaseline.tempMean - 35.0f) + 
-                      seasonalOffset - colonyBaseline.tempStdDev);
-    
-    *highThreshold = min(MAX_SAFE_TEMP, TEMP_ALERT_HIGH + 
-                       (colonyBaseline.tempMean - 35.0f) + 
-                       seasonalOffset + colonyBaseline.tempStdDev);
+void getAdaptedTempThresholds(float* lowThreshold, float* highThreshold, DateTime time) {
+    colonyModel.tempThresholds(lowThreshold, highThreshold, time.unixtime());
 }
 
 /**
  * Get adapted humidity thresholds based on learning
  */
-void getAdaptedHumidityThresholds(float* lowThreshold, float* highThreshold, uint8_t hour) {
-    float seasonalOffset = dailyPatterns[hour][currentSeason].humidityOffset;
-    
-    *lowThreshold = max(MIN_SAFE_HUMIDITY, HUM_ALERT_LOW + 
-                     seasonalOffset - colonyBaseline.humidityStdDev);
-    
-    *highThreshold = min(MAX_SAFE_HUMIDITY, HUM_ALERT_HIGH + 
-                      seasonalOffset + colonyBaseline.humidityStdDev);
+void getAdaptedHumidityThresholds(float* lowThreshold, float* highThreshold, DateTime time) {
+    colonyModel.humidityThresholds(lowThreshold, highThreshold, time.unixtime());
 }
 
 /**
- * Get adapted audio thresholds for each band
+ * Get adapted audio thresholds for each band at this time of day
  */
-void getAdaptedAudioThresholds(float thresholds[NUM_AUDIO_BANDS]) {
-    thresholds[0] = max(MIN_AUDIO_THRESHOLD, colonyBaseline.audioEnergy[0] * 0.7f); // Normal hum
-    thresholds[1] = max(MIN_AUDIO_THRESHOLD, colonyBaseline.audioEnergy[1] * 1.5f); // Queen
-    thresholds[2] = max(MIN_AUDIO_THRESHOLD, colonyBaseline.audioEnergy[2] * 1.5f); // Swarming
-    thresholds[3] = max(MIN_AUDIO_THRESHOLD, colonyBaseline.audioEnergy[3] * 1.8f); // Alarm
+void getAdaptedAudioThresholds(float thresholds[NUM_AUDIO_BANDS], DateTime time) {
+    colonyModel.audioThresholds(thresholds, time.unixtime());
+}
+
+/**
+ * Load the newest dump from a pre-slot LEARN.DAT file
+ * The old format appended a full dump on every save, so the last complete
+ * dump is the newest. The file is removed afterwards so the slot store
+ * starts over at a constant size.
+ */
+static bool loadLegacyParameters() {
+    File dataFile = SD.open(LEARNING_FILE, FILE_READ);
+    if (!dataFile) {
+        return false;
+    }
+    
+    uint32_t size = dataFile.size();
+    uint32_t magic = 0;
+    dataFile.read((uint8_t*)&magic, sizeof(magic));
+    if (magic == RECORD_STORE_MAGIC || size < LEGACY_RECORD_SIZE ||
+        size % LEGACY_RECORD_SIZE != 0) {
+        dataFile.close();
+        return false;
+    }
+    
+    SensorBaseline baseline;
+    DailyPattern (*patterns)[NUM_SEASONS] = learningBuffer.legacyPatterns;
+    uint16_t sampleCount = 0;
+    uint8_t season = 0;
+    
+    dataFile.seek(size - LEGACY_RECORD_SIZE);
+    dataFile.read((uint8_t*)&baseline, sizeof(baseline));
+    dataFile.read((uint8_t*)patterns, LEGACY_PATTERNS_SIZE);
+    dataFile.read((uint8_t*)&sampleCount, sizeof(sampleCount));
+    dataFile.read((uint8_t*)&season, sizeof(season));
+    dataFile.close();
+    
+    colonyModel.restoreLegacy(baseline, patterns, sampleCount, season);
+    
+    SD.remove(LEARNING_FILE);
+    return true;
 }
 
 /**
@@ -413,30 +409,23 @@ bool saveLearnedParameters() {
         return false;
     }
     
-    // First save binary version for internal use
-    File dataFile = SD.open(LEARNING_FILE, FILE_WRITE);
-    if (dataFile) {
-        // Write the baseline data
-        dataFile.write((uint8_t*)&colonyBaseline, sizeof(SensorBaseline));
-        
-        // Write the daily patterns
-        dataFile.write((uint8_t*)dailyPatterns, sizeof(dailyPatterns));
-        
-        // Write learning progress
-        dataFile.write((uint8_t*)&learningSampleCount, sizeof(learningSampleCount));
-        dataFile.write((uint8_t*)&currentSeason, sizeof(currentSeason));
-        
-        dataFile.close();
-        
-        // Now save human-readable JSON version
-        saveJsonParameters();
-        
-        Serial.println("Learning data saved");
-        return true;
-    } else {
-        Serial.println("Failed to open learning data file for writing");
+    // Binary record for internal use, written in place into the older slot
+    uint16_t length = colonyModel.serialize(learningBuffer.record,
+                                            sizeof(learningBuffer.record));
+    if (length == 0) {
+        Serial.println("Learning data does not fit in record slot");
+        return false;
+    }
+    if (!recordStoreSave(&learningStore, LEARNING_STATE_VERSION, learningBuffer.record, length)) {
+        Serial.println("Failed to write learning data file");
         return false;
     }
+    
+    colonyModel.clearDirty();
+    samplesSinceSave = 0;
+    
+    Serial.println("Learning data saved");
+    return true;
 }
 
 /**
@@ -447,11 +436,14 @@ bool saveJsonParameters() {
         return false;
     }
     
-    File jsonFile = SD.open(LEARNING_JSON, FILE_WRITE);
+    // Truncate rather than append so the file holds a single document
+    File jsonFile = SD.open(LEARNING_JSON, O_WRITE | O_CREAT | O_TRUNC);
     if (jsonFile) {
+        const SensorBaseline& colonyBaseline = colonyModel.baseline();
+    
         // Create JSON document
         StaticJsonDocument<1024> doc;
-        
+    
         // Store baseline data
         JsonObject baseline = doc.createNestedObject("baseline");
         baseline["tempMean"] = colonyBaseline.tempMean;
@@ -460,25 +452,31 @@ bool saveJsonParameters() {
         baseline["humidityStdDev"] = colonyBaseline.humidityStdDev;
         baseline["weightMean"] = colonyBaseline.weightMean;
         baseline["weightStdDev"] = colonyBaseline.weightStdDev;
-        
+    
         JsonArray audio = baseline.createNestedArray("audio");
         for (int i = 0; i < NUM_AUDIO_BANDS; i++) {
             JsonObject band = audio.createNestedObject();
             band["energy"] = colonyBaseline.audioEnergy[i];
             band["stdDev"] = colonyBaseline.audioStdDev[i];
         }
-        
-        doc["sampleCount"] = learningSampleCount;
-        doc["baselineEstablished"] = baselineEstablished;
-        doc["currentSeason"] = currentSeason;
-        
+    
+        doc["jointScore"] = colonyModel.jointAnomalyScore(NULL);
+        float thermoregulation = colonyModel.thermoregulationScore();
+        if (!isnan(thermoregulation)) {
+            doc["thermoregulation"] = thermoregulation;
+        }
+        doc["sampleCount"] = colonyModel.sampleCount();
+        doc["baselineEstablished"] = colonyModel.isBaselineEstablished();
+        doc["currentSeason"] = colonyModel.season();
+    
         // Serialize to file
-        if (serializeJson(doc, jsonFile) == 0) {
+        bool written = serializeJson(doc, jsonFile) != 0;
+        if (!written) {
             Serial.println("Failed to write JSON data");
         }
-        
+    
         jsonFile.close();
-        return true;
+        return written;
     }
     return false;
 }
@@ -496,42 +494,33 @@ bool loadLearnedParameters() {
         return false;
     }
     
-    File dataFile = SD.open(LEARNING_FILE, FILE_READ);
-    if (dataFile) {
-        // Read the baseline data
-        dataFile.read((uint8_t*)&colonyBaseline, sizeof(SensorBaseline));
-        
-        // Read the daily patterns
-        dataFile.read((uint8_t*)dailyPatterns, sizeof(dailyPatterns));
-        
-        // Read learning progress
-        dataFile.read((uint8_t*)&learningSampleCount, sizeof(learningSampleCount));
-        dataFile.read((uint8_t*)&currentSeason, sizeof(currentSeason));
-        
-        dataFile.close();
-        
-        // Initialize stats with baseline values
-        tempStats.setStats(colonyBaseline.tempMean, colonyBaseline.tempStdDev);
-        humidityStats.setStats(colonyBaseline.humidityMean, colonyBaseline.humidityStdDev);
-        pressureStats.setStats(colonyBaseline.pressureMean, colonyBaseline.pressureStdDev);
-        weightStats.setStats(colonyBaseline.weightMean, colonyBaseline.weightStdDev);
-        
-        for (int i = 0; i < NUM_AUDIO_BANDS; i++) {
-            audioStats[i].setStats(colonyBaseline.audioEnergy[i], colonyBaseline.audioStdDev[i]);
+    uint16_t version = 0;
+    uint16_t length = 0;
+    if (recordStoreLoad(&learningStore, &version, learningBuffer.record,
+                        sizeof(learningBuffer.record), &length)) {
+        if (version != LEARNING_STATE_VERSION) {
+            Serial.print("Learning data version ");
+            Serial.print(version);
+            Serial.println(" - restoring known sections only");
         }
-        
-        printBaseline();
-        return true;
+        colonyModel.deserialize(learningBuffer.record, length);
+    } else if (loadLegacyParameters()) {
+        Serial.println("Migrated legacy learning data file");
     } else {
-        Serial.println("Failed to open learning data file");
+        Serial.println("Learning data file unreadable");
         return false;
     }
+    
+    printBaseline();
+    return true;
 }
 
 /**
  * Print the current baseline values to serial
  */
 void printBaseline() {
+    const SensorBaseline& colonyBaseline = colonyModel.baseline();
+    
     Serial.println("Current Baseline Values:");
     Serial.print("Temperature: "); 
     Serial.print(colonyBaseline.tempMean);
@@ -562,92 +551,19 @@ void printBaseline() {
     }
     
     Serial.print("Learning samples: ");
-    Serial.println(learningSampleCount);
+    Serial.println(colonyModel.sampleCount());
 }
 
 /**
  * Get current learning status
  */
 bool isBaselineEstablished() {
-    return baselineEstablished;
+    return colonyModel.isBaselineEstablished();
 }
 
 /**
  * Get learning progress percentage
  */
 uint8_t getLearningProgress() {
-    if (baselineEstablished) return 100;
-    
-    return min(99, (learningSampleCount * 100) / LEARNING_SAMPLES_MIN);
-}
-
-/**
- * Reset statistics without losing all history
- */
-void RunningStats::partialReset(float keepRatio) {
-    if (count_ > 0) {
-        count_ = max(1, (int)(count_ * keepRatio));
-    }
-}
-
-/**
- * Set statistics to known values
- */
-void RunningStats::setStats(float mean, float stdDev) {
-    mean_ = mean;
-    // To set a known standard deviation with a valid M2, we need:
-    // stdDev² = M2 / (count - 1)
-    // So: M2 = stdDev² * (count - 1)
-    count_ = 30; // Arbitrary sample size that gives reasonable weight
-    M2_ = stdDev * stdDev * (count_ - 1);
-}
-
-/**
- * Add a sample to running statistics
- */
-void RunningStats::addSample(float value) {
-    count_++;
-    
-    // Welford's online algorithm
-    float delta = value - mean_;
-    mean_ += delta / count_;
-    float delta2 = value - mean_;
-    M2_ += delta * delta2;
-}
-
-/**
- * Reset statistics
- */
-void RunningStats::reset() {
-    count_ = 0;
-    mean_ = 0.0;
-    M2_ = 0.0;
-}
-
-/**
- * Get current mean
- */
-float RunningStats::mean() const {
-    return (count_ > 0) ? mean_ : 0.0f;
-}
-
-/**
- * Get current variance
- */
-float RunningStats::variance() const {
-    return (count_ > 1) ? M2_ / (count_ - 1) : 0.0f;
-}
-
-/**
- * Get current standard deviation
- */
-float RunningStats::standardDeviation() const {
-    return sqrt(variance());
-}
-
-/**
- * Get sample count
- */
-unsigned long RunningStats::count() const {
-    return count_;
+    return colonyModel.progress();
 }
\ No newline at end of file
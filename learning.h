@@ -14,78 +14,44 @@
  #include "motion_sensing.h"
  #include "light_sensing.h"
  #include "data_logging.h"
- 
- // Number of audio frequency bands
- #define NUM_AUDIO_BANDS 4
- 
- // Structure to hold baseline sensor data
- typedef struct {
-     float tempMean;          // Mean temperature
-     float tempStdDev;        // Temperature standard deviation
-     float humidityMean;      // Mean humidity
-     float humidityStdDev;    // Humidity standard deviation
-     float pressureMean;      // Mean barometric pressure
-     float pressureStdDev;    // Pressure standard deviation
-     float weightMean;        // Mean hive weight
-     float weightStdDev;      // Weight standard deviation
-     float weightDailyDelta;  // Normal daily weight fluctuation
-     float audioEnergy[NUM_AUDIO_BANDS];  // Mean energy in each freq band
-     float audioStdDev[NUM_AUDIO_BANDS];  // StdDev in each freq band
- } SensorBaseline;
- 
- // Structure to hold time-of-day patterns
- typedef struct {
-     float activityLevel;    // Relative activity level (0.0-1.0)
-     float tempOffset;       // Temperature offset from baseline
-     float humidityOffset;   // Humidity offset from baseline
-     uint16_t sampleCount;   // Number of samples for this time period
- } DailyPattern;
- 
- // Class for maintaining running statistics with low memory usage
- class RunningStats {
- public:
-     RunningStats() : count_(0), mean_(0), M2_(0) {}
-     
-     void addSample(float value);
-     void reset();
-     void partialReset(float keepRatio);
-     void setStats(float mean, float stdDev);
-     
-     float mean() const;
-     float variance() const;
-     float standardDeviation() const;
-     unsigned long count() const;
-     
- private:
-     unsigned long count_;  // Number of samples
-     float mean_;           // Running mean
-     float M2_;             // Sum of squared differences (for variance)
- };
+ #include "learning_model.h"
  
  // Function prototypes
  void setupLearning();
  void resetLearningSystem();
  void updateLearningModel(EnvData envData, float* audioEnergy, 
                         MotionData motionData, LightData lightData, 
-                        float weight, DateTime timestamp);
+                        float weight, float rawWeight, DateTime timestamp);
  void updateBaseline();
  void updateBaselineAdaptive();
- void updateDailyPattern(uint8_t hour, uint8_t season, float activity, 
+ void updateDailyPattern(uint8_t slot, uint8_t season, float activity, 
                        float temp, float humidity);
- uint8_t getSeason(uint8_t month);
  
  // Anomaly detection
- bool isTemperatureAnomaly(float temperature, uint8_t hour);
- bool isHumidityAnomaly(float humidity, uint8_t hour);
- bool isAudioAnomaly(float* audioLevels);
- bool isWeightAnomaly(float weight, float previousWeight);
+ bool isTemperatureAnomaly(float temperature, DateTime time);
+ bool isHumidityAnomaly(float humidity, DateTime time);
+ bool isAudioAnomaly(float* audioLevels, DateTime time);
+ bool isWeightAnomaly(float weight, float previousWeight, DateTime time);
+ bool isJointAnomaly();
+ float getForecastTemperature(DateTime time);
+ float getForecastWeight(DateTime time);
+ float getWeightDailyOffset(DateTime time);
+ float getWeightTemperatureCorrection(float temperature, float rate);
+ float getJointAnomalyScore(float contributions[NUM_JOINT_FEATURES]);
+ float getThermoregulationScore();
+ 
+ // Motion activity
+ void addMotionActivitySample(float ax, float ay, float az, float dt);
+ float endMotionActivityWindow(float* rms, float* jerk);
+ bool isMotionActivityLearned();
  
  // Get adapted thresholds
- void getAdaptedTempThresholds(float* lowThreshold, float* highThreshold, uint8_t hour);
- void getAdaptedHumidityThresholds(float* lowThreshold, float* highThreshold, uint8_t hour);
- void getAdaptedAudioThresholds(float thresholds[NUM_AUDIO_BANDS]);
+ void getAdaptedTempThresholds(float* lowThreshold, float* highThreshold, DateTime time);
+ void getAdaptedHumidityThresholds(float* lowThreshold, float* highThreshold, DateTime time);
+ void getAdaptedAudioThresholds(float thresholds[NUM_AUDIO_BANDS], DateTime time);
  
  // Parameter persistence
+ bool commitLearningState(bool exportJson);
  bool saveLearnedParameters();
  bool saveJsonParameters();
  bool loadLearnedParameters();
@@ -0,0 +1,1160 @@
+/**
+ * Hive Monitor System - Learning Model
+ *
+ * Per-colony learning model: baseline statistics, daily patterns, joint
+ * anomaly detector, residual percentile sketches and seasonal forecasters
+ * for one colony. The model does no I/O; the learning module owns the
+ * device instance, its persistence and its diagnostics.
+ */
+
+#include "learning_model.h"
+#include "config.h"
+#include "record_sections.h"
+#include <math.h>
+#include <string.h>
+
+// Sections of the learning record
+#define SECTION_BASELINE        1
+#define SECTION_DAILY_PATTERNS  2
+#define SECTION_COUNTERS        3
+#define SECTION_JOINT_DETECTOR  4
+#define SECTION_QUANTILES       5
+#define SECTION_FORECASTS       6
+#define SECTION_AUDIO_PROFILE   7
+#define SECTION_PATTERN_SLOTS   8     // Replaces SECTION_DAILY_PATTERNS (hourly)
+#define SECTION_THERMOREGULATION 9
+#define SECTION_WEIGHT_DRIFT    10
+#define SECTION_DAILY_WEIGHT    11
+#define SECTION_JOINT_ACTIVITY  12    // Replaces SECTION_JOINT_DETECTOR (motion as |a|)
+#define SECTION_MOTION_BASELINE 13
+
+// Serialized size of one daily pattern entry
+#define PATTERN_SLOT_BYTES      6
+#define HOURLY_PATTERN_BYTES    16    // Three floats, the count and two reserved bytes
+
+// Seconds per day
+#define SECONDS_PER_DAY 86400UL
+
+// Activity RMS of a hive at rest, the accelerometer noise (g)
+#define MOTION_REST_RMS 0.005f
+
+const LearningParams learningDefaultParams = {
+    LEARNING_SAMPLES_MIN,
+    LEARNING_UPDATE_INTERVAL,
+    LEARNING_ADAPTATION_RATE,
+    TEMP_ANOMALY_THRESHOLD,
+    HUMIDITY_ANOMALY_THRESHOLD,
+    AUDIO_HUM_ANOMALY_THRESHOLD,
+    AUDIO_ANOMALY_THRESHOLD,
+    WEIGHT_ANOMALY_THRESHOLD,
+    WEIGHT_CHANGE_THRESHOLD,
+    JOINT_ANOMALY_THRESHOLD,
+    LEARNED_QUANTILE_LOW,
+    LEARNED_QUANTILE_HIGH,
+    QUANTILE_THRESHOLD_MARGIN,
+    QUANTILE_HORIZON_SAMPLES,
+    FORECAST_ALPHA,
+    FORECAST_BETA,
+    FORECAST_GAMMA
+};
+
+// Smallest standard deviation per feature, keeps the covariance invertible
+static const float jointFeatureFloor[NUM_JOINT_FEATURES] = {
+    0.1f, 0.5f, 0.5f, 0.05f,            // °C, %, hPa, kg
+    0.01f, 0.01f, 0.01f, 0.01f,         // Audio band energy
+    0.001f, 1.0f                        // g RMS, lux
+};
+
+/**
+ * Get the current season (0-3) based on month
+ */
+uint8_t getSeason(uint8_t month) {
+    // Simple season calculation
+    // 0 = Winter (Dec-Feb), 1 = Spring (Mar-May),
+    // 2 = Summer (Jun-Aug), 3 = Fall (Sep-Nov)
+    if (month == 12 || month == 1 || month == 2) return 0;
+    if (month >= 3 && month <= 5) return 1;
+    if (month >= 6 && month <= 8) return 2;
+    return 3; // Fall (Sep-Nov)
+}
+
+/**
+ * Pack a value into a fixed-point pattern field, rounding and saturating
+ */
+static int16_t packSigned(float value, float scale) {
+    float scaled = roundf(value * scale);
+    return (int16_t)fmaxf(-32768.0f, fminf(32767.0f, scaled));
+}
+
+/**
+ * Pack a non-negative value into an 8-bit pattern field
+ */
+static uint8_t packUnsigned(float value, float scale) {
+    float scaled = roundf(value * scale);
+    return (uint8_t)fmaxf(0.0f, fminf(255.0f, scaled));
+}
+
+/**
+ * Half-life (in samples) equivalent to blending a window mean into the
+ * baseline at the given rate every update interval
+ */
+static float adaptationHalfLife(uint16_t interval, float rate) {
+    return interval * logf(0.5f) / logf(1.0f - rate);
+}
+
+/**
+ * Use a different parameter set and reset to defaults
+ * The parameters must outlive the model.
+ */
+void LearningModel::init(const LearningParams* params) {
+    params_ = params;
+    reset();
+}
+
+/**
+ * Reset the model to defaults
+ */
+void LearningModel::reset() {
+    // Initialize with sensible defaults
+    baseline_.tempMean = 35.0;         // °C
+    baseline_.tempStdDev = 2.0;        // °C
+    baseline_.humidityMean = 60.0;     // %
+    baseline_.humidityStdDev = 5.0;    // %
+    baseline_.pressureMean = 1013.25;  // hPa
+    baseline_.pressureStdDev = 5.0;    // hPa
+    baseline_.weightMean = 0.0;        // kg
+    baseline_.weightStdDev = 1.0;      // kg
+    baseline_.weightDailyDelta = 0.2;  // kg
+
+    // Audio energy defaults
+    baseline_.audioEnergy[0] = THRESH_B1; // Normal hum band
+    baseline_.audioEnergy[1] = THRESH_B2; // Queen piping band
+    baseline_.audioEnergy[2] = THRESH_B3; // Swarming band
+    baseline_.audioEnergy[3] = THRESH_B4; // Alarm band
+
+    // Audio adapts faster and weight slower than the environment
+    float adaptRate = params_->adaptationRate;
+    uint16_t interval = params_->updateInterval;
+    featureStats_.init(NUM_JOINT_FEATURES);
+    for (int i = 0; i < NUM_JOINT_FEATURES; i++) {
+        featureStats_.setHalfLife(i, adaptationHalfLife(interval, adaptRate));
+    }
+    for (int i = 0; i < NUM_AUDIO_BANDS; i++) {
+        baseline_.audioStdDev[i] = 0.1; // Initial std deviation
+        featureStats_.setHalfLife(FEATURE_AUDIO_B1 + i, adaptationHalfLife(interval, adaptRate * 2));
+    }
+    featureStats_.setHalfLife(FEATURE_WEIGHT, adaptationHalfLife(interval, adaptRate / 2));
+
+    // Reset learning counter
+    sampleCount_ = 0;
+    season_ = 0;
+
+    // Initialize daily patterns
+    for (int s = 0; s < NUM_SEASONS; s++) {
+        for (int i = 0; i < PATTERN_SLOTS; i++) {
+            PackedPattern* slot = &dailyPatterns_[s][i];
+            slot->activityLevel = packUnsigned(0.5f, PATTERN_ACTIVITY_SCALE); // Medium activity
+            slot->tempOffset = 0;                                           // No offset
+            slot->humidityOffset = 0;                                       // No offset
+            slot->sampleCount = 0;
+        }
+    }
+
+    // Joint detector starts from the default baseline with no correlations
+    initJointDetector();
+
+    for (int i = 0; i < NUM_SKETCHES; i++) {
+        residualSketches_[i].init(params_->quantileLow, params_->quantileHigh,
+                                  params_->quantileHorizon);
+    }
+
+    for (int i = 0; i < NUM_FORECASTS; i++) {
+        forecasters_[i].init(params_->forecastAlpha, params_->forecastBeta,
+                             params_->forecastGamma, adaptationHalfLife(interval, adaptRate));
+    }
+
+    audioProfile_.init(NUM_AUDIO_BANDS, AUDIO_PROFILE_HARMONICS,
+                       adaptationHalfLife(interval, adaptRate * 2));
+
+    thermoregulation_.init(THERMO_FAST_HALF_LIFE, THERMO_SLOW_HALF_LIFE,
+                           BROOD_TEMP_TARGET, BROOD_TEMP_TOLERANCE);
+
+    // Regressors: intercept (night consumption), temperature step, rate step
+    weightDrift_.init(3, WEIGHT_DRIFT_FORGETTING, 1.0f);
+    driftTime_ = 0;
+    driftWeight_ = 0.0f;
+    driftTemp_ = 0.0f;
+    driftRate_ = 0.0f;
+
+    dailyWeight_.init(DAILY_DAWN_HOUR, DAILY_DUSK_HOUR, DAILY_DEPARTURE_HOURS,
+                      DAILY_RANGE_HALF_LIFE);
+    memset(&lastDay_, 0, sizeof(lastDay_));
+
+    motionScorer_.init(MOTION_REST_HALF_LIFE, MOTION_REST_TOLERANCE, MOTION_BASELINE_HALF_LIFE,
+                       MOTION_SCORE_MIN_STDDEV, MOTION_ALERT_ZSCORE, MOTION_BASELINE_MIN_WAKES);
+
+    established_ = false;
+    dirty_ = 0;
+}
+
+/**
+ * Process one wake's readings
+ * A reading left NAN by a failed sensor is skipped by every statistic
+ * it feeds, so it cannot poison the learned state.
+ * Returns LEARNING_EVENT_* flags for the caller to report.
+ */
+uint8_t LearningModel::update(const LearningSample& sample) {
+    uint8_t events = 0;
+
+    // Increment sample counter
+    sampleCount_++;
+    season_ = getSeason(sample.month);
+    dirty_ |= LEARNING_DIRTY_COUNTERS | LEARNING_DIRTY_DAILY_PATTERNS |
+              LEARNING_DIRTY_FORECASTS | LEARNING_DIRTY_JOINT_DETECTOR |
+              LEARNING_DIRTY_AUDIO_PROFILE | LEARNING_DIRTY_THERMOREGULATION |
+              LEARNING_DIRTY_DAILY_WEIGHT;
+
+    // Update running statistics for the whole feature vector at once
+    float features[NUM_JOINT_FEATURES] = {
+        sample.temperature, sample.humidity, sample.pressure, sample.weight,
+        sample.audioEnergy[0], sample.audioEnergy[1],
+        sample.audioEnergy[2], sample.audioEnergy[3],
+        sample.motion, sample.light
+    };
+    featureStats_.addSample(features);
+    thermoregulation_.addSample(sample.temperature, sample.ambientTemperature);
+    learnWeightDrift(sample);
+    if (dailyWeight_.addSample(sample.time, sample.weight, &lastDay_)) {
+        events |= LEARNING_EVENT_DAY_COMPLETE;
+    }
+
+    // Learn the readings for the next wakes' forecasts
+    forecasters_[FORECAST_TEMP].update(sample.temperature, sample.time);
+    forecasters_[FORECAST_WEIGHT].update(sample.weight, sample.time);
+
+    // Score the joint feature vector against the model so far, then learn it
+    jointScore_ = jointDetector_.score(features, jointContributions_);
+    jointDetector_.update(features);
+    if (isJointAnomaly()) {
+        events |= LEARNING_EVENT_JOINT_ANOMALY;
+    }
+
+    // Residuals from the expected values feed the percentile sketches
+    if (established_) {
+        float tempOffset, humidityOffset;
+        patternOffsets(sample.time, &tempOffset, &humidityOffset);
+        float expectedTemp = baseline_.tempMean + tempOffset;
+        float expectedHumidity = baseline_.humidityMean + humidityOffset;
+        float expectedAudio[NUM_AUDIO_BANDS];
+        expectedAudioEnergy(sample.time, expectedAudio);
+        residualSketches_[SKETCH_TEMP].addSample(sample.temperature - expectedTemp);
+        residualSketches_[SKETCH_HUMIDITY].addSample(sample.humidity - expectedHumidity);
+        for (int i = 0; i < NUM_AUDIO_BANDS; i++) {
+            residualSketches_[SKETCH_AUDIO + i].addSample(sample.audioEnergy[i] -
+                                                         expectedAudio[i]);
+        }
+        dirty_ |= LEARNING_DIRTY_QUANTILES;
+    }
+
+    // Learn the time-of-day audio profile after using it
+    audioProfile_.update(sample.audioEnergy, sample.time);
+
+    // Activity level is based on audio energy in normal band and motion
+    float activity = (sample.audioEnergy[0] / baseline_.audioEnergy[0]) * 0.8f +
+                    (sample.motion / fmaxf(featureStats_.mean(FEATURE_MOTION),
+                                           jointFeatureFloor[FEATURE_MOTION])) * 0.2f;
+
+    uint8_t slot = (sample.time % SECONDS_PER_DAY) / PATTERN_SLOT_SECONDS;
+    updateDailyPattern(slot, season_, activity, sample.temperature, sample.humidity);
+
+    // After sufficient samples, establish baseline
+    if (sampleCount_ >= params_->samplesMin && !established_) {
+        updateBaseline();
+        established_ = true;
+        events |= LEARNING_EVENT_ESTABLISHED;
+    } else if (established_ && sampleCount_ % params_->updateInterval == 0) {
+        // Periodically update baseline with slow adaptation rate
+        updateBaseline();
+        events |= LEARNING_EVENT_ADAPTED;
+    }
+
+    return events;
+}
+
+/**
+ * Update many models with one sample each
+ * events may be NULL; otherwise it receives each model's event flags.
+ */
+void LearningModel::updateBatch(LearningModel* models, const LearningSample* samples,
+                                size_t count, uint8_t* events) {
+    for (size_t i = 0; i < count; i++) {
+        uint8_t result = models[i].update(samples[i]);
+        if (events) {
+            events[i] = result;
+        }
+    }
+}
+
+/**
+ * Update baseline from collected statistics
+ * The statistics are exponentially weighted with per-sensor half-lives,
+ * so the adapted baseline is simply their current snapshot.
+ */
+void LearningModel::updateBaseline() {
+    // Update environmental baselines
+    baseline_.tempMean = featureStats_.mean(FEATURE_TEMP);
+    baseline_.tempStdDev = featureStats_.standardDeviation(FEATURE_TEMP);
+
+    baseline_.humidityMean = featureStats_.mean(FEATURE_HUMIDITY);
+    baseline_.humidityStdDev = featureStats_.standardDeviation(FEATURE_HUMIDITY);
+
+    baseline_.pressureMean = featureStats_.mean(FEATURE_PRESSURE);
+    baseline_.pressureStdDev = featureStats_.standardDeviation(FEATURE_PRESSURE);
+
+    baseline_.weightMean = featureStats_.mean(FEATURE_WEIGHT);
+    baseline_.weightStdDev = featureStats_.standardDeviation(FEATURE_WEIGHT);
+
+    // Normal daily swing is the average daily weight range, or the
+    // amplitude of the learned daily cycle until a few days are complete
+    if (dailyWeight_.days() >= DAILY_RANGE_MIN_DAYS) {
+        baseline_.weightDailyDelta = dailyWeight_.typicalRange();
+    } else if (isForecastReady(FORECAST_WEIGHT)) {
+        baseline_.weightDailyDelta = forecasters_[FORECAST_WEIGHT].seasonalRange();
+    }
+
+    // Update audio energy baselines
+    for (int i = 0; i < NUM_AUDIO_BANDS; i++) {
+        baseline_.audioEnergy[i] = featureStats_.mean(FEATURE_AUDIO_B1 + i);
+        baseline_.audioStdDev[i] = featureStats_.standardDeviation(FEATURE_AUDIO_B1 + i);
+    }
+
+    dirty_ |= LEARNING_DIRTY_BASELINE;
+}
+
+/**
+ * Update daily pattern for a specific 15-minute slot and season
+ * The sample count saturates at 255, so the adaptation rate never falls
+ * below about 2% and old seasons keep adapting.
+ */
+void LearningModel::updateDailyPattern(uint8_t slot, uint8_t season, float activity,
+                                       float temp, float humidity) {
+
+    PackedPattern* pattern = &dailyPatterns_[season][slot];
+
+    // Calculate adaptation rate (faster when fewer samples)
+    float adaptRate = fminf(0.5f, 5.0f / (pattern->sampleCount + 10.0f));
+
+    float activityLevel = pattern->activityLevel / PATTERN_ACTIVITY_SCALE;
+    float tempOffset = pattern->tempOffset / PATTERN_TEMP_SCALE;
+    float humidityOffset = pattern->humidityOffset / PATTERN_HUMIDITY_SCALE;
+
+    // Update pattern, keeping the learned value of any failed reading
+    if (isfinite(activity)) {
+        activityLevel = (1-adaptRate) * activityLevel + adaptRate * activity;
+    }
+    if (isfinite(temp)) {
+        tempOffset = (1-adaptRate) * tempOffset + adaptRate * (temp - baseline_.tempMean);
+    }
+    if (isfinite(humidity)) {
+        humidityOffset = (1-adaptRate) * humidityOffset +
+                         adaptRate * (humidity - baseline_.humidityMean);
+    }
+
+    pattern->activityLevel = packUnsigned(activityLevel, PATTERN_ACTIVITY_SCALE);
+    pattern->tempOffset = packSigned(tempOffset, PATTERN_TEMP_SCALE);
+    pattern->humidityOffset = packSigned(humidityOffset, PATTERN_HUMIDITY_SCALE);
+    if (pattern->sampleCount < UINT8_MAX) {
+        pattern->sampleCount++;
+    }
+    dirty_ |= LEARNING_DIRTY_DAILY_PATTERNS;
+}
+
+/**
+ * Learned temperature and humidity offsets at a time of day
+ * Slot values sit at slot centres and are interpolated linearly between
+ * the two neighbouring slots (wrapping at midnight), without branches.
+ */
+void LearningModel::patternOffsets(uint32_t time, float* tempOffset,
+                                   float* humidityOffset) const {
+    uint32_t position = (time % SECONDS_PER_DAY + SECONDS_PER_DAY -
+                         PATTERN_SLOT_SECONDS / 2) % SECONDS_PER_DAY;
+    uint32_t lower = position / PATTERN_SLOT_SECONDS;
+    uint32_t upper = (lower + 1) % PATTERN_SLOTS;
+    float fraction = (position % PATTERN_SLOT_SECONDS) * (1.0f / PATTERN_SLOT_SECONDS);
+
+    const PackedPattern* row = dailyPatterns_[season_];
+    float temp0 = row[lower].tempOffset;
+    float temp1 = row[upper].tempOffset;
+    float humidity0 = row[lower].humidityOffset;
+    float humidity1 = row[upper].humidityOffset;
+
+    *tempOffset = (temp0 + fraction * (temp1 - temp0)) * (1.0f / PATTERN_TEMP_SCALE);
+    *humidityOffset = (humidity0 + fraction * (humidity1 - humidity0)) *
+                      (1.0f / PATTERN_HUMIDITY_SCALE);
+}
+
+/**
+ * Fill the 15-minute slots from an hourly pattern table
+ * Each slot takes the hourly curve interpolated at its centre, and a
+ * quarter of the hour's sample count.
+ */
+void LearningModel::migrateHourlyPatterns(const DailyPattern hourly[24][NUM_SEASONS]) {
+    const uint32_t slotsPerHour = PATTERN_SLOTS / 24;
+    for (int s = 0; s < NUM_SEASONS; s++) {
+        for (uint32_t i = 0; i < PATTERN_SLOTS; i++) {
+            // Slot centre in hours, relative to the hourly centres (h + 0.5)
+            float hours = (i + 0.5f) / slotsPerHour - 0.5f + 24.0f;
+            uint32_t lower = (uint32_t)hours % 24;
+            uint32_t upper = (lower + 1) % 24;
+            float fraction = hours - floorf(hours);
+
+            const DailyPattern& a = hourly[lower][s];
+            const DailyPattern& b = hourly[upper][s];
+            const DailyPattern& own = hourly[i / slotsPerHour][s];
+            PackedPattern* slot = &dailyPatterns_[s][i];
+
+            slot->activityLevel = packUnsigned(a.activityLevel + fraction *
+                                               (b.activityLevel - a.activityLevel),
+                                               PATTERN_ACTIVITY_SCALE);
+            slot->tempOffset = packSigned(a.tempOffset + fraction *
+                                          (b.tempOffset - a.tempOffset),
+                                          PATTERN_TEMP_SCALE);
+            slot->humidityOffset = packSigned(a.humidityOffset + fraction *
+                                              (b.humidityOffset - a.humidityOffset),
+                                              PATTERN_HUMIDITY_SCALE);
+            uint32_t count = own.sampleCount / slotsPerHour;
+            slot->sampleCount = (count > UINT8_MAX) ? UINT8_MAX : count;
+        }
+    }
+}
+
+/**
+ * Check if a forecaster has seen enough samples to be trusted
+ */
+bool LearningModel::isForecastReady(uint8_t series) const {
+    return forecasters_[series].count() >= params_->samplesMin;
+}
+
+/**
+ * Forecast residual of a reading in units of typical forecast error
+ * The forecast is for the reading's own time, so score a wake's
+ * readings before update() absorbs them.
+ */
+float LearningModel::forecastZScore(uint8_t series, float value, uint32_t time,
+                                    float minStdDev) const {
+    float spread = fmaxf(minStdDev, forecasters_[series].residualStdDev());
+    return (value - forecasters_[series].forecast(time)) / spread;
+}
+
+/**
+ * Check if a temperature reading is anomalous based on learned patterns
+ */
+bool LearningModel::isTemperatureAnomaly(float temperature, uint32_t time) const {
+    // Compare against the seasonal forecast once it is trained
+    if (isForecastReady(FORECAST_TEMP)) {
+        float zScore = forecastZScore(FORECAST_TEMP, temperature, time,
+                                      jointFeatureFloor[FEATURE_TEMP]);
+        return fabsf(zScore) > params_->tempAnomalyThreshold;
+    }
+
+    // Get expected temperature for current time and season
+    float tempOffset, humidityOffset;
+    patternOffsets(time, &tempOffset, &humidityOffset);
+    float expectedTemp = baseline_.tempMean + tempOffset;
+
+    // Calculate z-score (standard deviations from mean)
+    float zScore = (temperature - expectedTemp) / baseline_.tempStdDev;
+
+    // Consider anomaly if more than ANOMALY_THRESHOLD standard deviations from mean
+    return fabsf(zScore) > params_->tempAnomalyThreshold;
+}
+
+/**
+ * Check if humidity is anomalous based on learned patterns
+ */
+bool LearningModel::isHumidityAnomaly(float humidity, uint32_t time) const {
+    float tempOffset, humidityOffset;
+    patternOffsets(time, &tempOffset, &humidityOffset);
+    float expectedHumidity = baseline_.humidityMean + humidityOffset;
+
+    float zScore = (humidity - expectedHumidity) / baseline_.humidityStdDev;
+
+    return fabsf(zScore) > params_->humidityAnomalyThreshold;
+}
+
+/**
+ * Check if audio pattern is anomalous based on learned baselines
+ * Each band is compared with its expected energy. Band energies are
+ * heavy-tailed, so once a band's residual sketch is trained the learned
+ * percentile band sets the limits; until then a z-score against the
+ * time-of-day profile (or the all-day spread) is used.
+ */
+bool LearningModel::isAudioAnomaly(const float* audioLevels, uint32_t time) const {
+    float expected[NUM_AUDIO_BANDS];
+    expectedAudioEnergy(time, expected);
+    bool profiled = isAudioProfileReady();
+
+    // Check each frequency band
+    for (int i = 0; i < NUM_AUDIO_BANDS; i++) {
+        if (isSketchReady(SKETCH_AUDIO + i)) {
+            float low, high;
+            sketchBounds(SKETCH_AUDIO + i, expected[i], &low, &high);
+            if (audioLevels[i] < low || audioLevels[i] > high) {
+                return true;
+            }
+            continue;
+        }
+
+        float spread = profiled ? audioProfile_.residualStdDev(i) : baseline_.audioStdDev[i];
+        float zScore = (audioLevels[i] - expected[i]) / fmaxf(0.01f, spread);
+
+        // The normal hum band varies more than the others
+        float threshold = (i == 0) ? params_->audioHumAnomalyThreshold :
+                                     params_->audioAnomalyThreshold;
+        if (fabsf(zScore) > threshold) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Check if weight change is anomalous
+ */
+bool LearningModel::isWeightAnomaly(float weight, float previousWeight, uint32_t time) const {
+    // Short term change (sudden)
+    float change = weight - previousWeight;
+    if (fabsf(change) > params_->weightChangeThreshold * baseline_.weightStdDev) {
+        return true;
+    }
+
+    // Deviation from the forecast (trend and daily cycle), or from the
+    // long-term baseline until the forecaster is trained
+    float zScore;
+    if (isForecastReady(FORECAST_WEIGHT)) {
+        zScore = forecastZScore(FORECAST_WEIGHT, weight, time, jointFeatureFloor[FEATURE_WEIGHT]);
+    } else {
+        zScore = (weight - baseline_.weightMean) / baseline_.weightStdDev;
+    }
+    return fabsf(zScore) > params_->weightAnomalyThreshold;
+}
+
+/**
+ * Check if the latest sample is anomalous across all sensors jointly
+ */
+bool LearningModel::isJointAnomaly() const {
+    return established_ && jointScore_ > params_->jointAnomalyThreshold;
+}
+
+/**
+ * Get the joint (squared Mahalanobis) anomaly score of the latest sample
+ * Optionally copies per-feature contributions, which sum to the score.
+ */
+float LearningModel::jointAnomalyScore(float* contributions) const {
+    if (contributions) {
+        memcpy(contributions, jointContributions_, sizeof(jointContributions_));
+    }
+    return jointScore_;
+}
+
+/**
+ * Get the forecast brood temperature at a given unix time
+ */
+float LearningModel::forecastTemperature(uint32_t time) const {
+    return forecasters_[FORECAST_TEMP].forecast(time);
+}
+
+/**
+ * Get the forecast hive weight at a given unix time
+ */
+float LearningModel::forecastWeight(uint32_t time) const {
+    return forecasters_[FORECAST_WEIGHT].forecast(time);
+}
+
+/**
+ * Get the learned daily-cycle weight offset at a given unix time
+ * Zero until the weight forecaster is trained.
+ */
+float LearningModel::weightDailyOffset(uint32_t time) const {
+    if (!isForecastReady(FORECAST_WEIGHT)) {
+        return 0.0f;
+    }
+    return forecasters_[FORECAST_WEIGHT].seasonalOffset(time);
+}
+
+/**
+ * Learn load-cell thermal drift from consecutive quiet night wakes
+ * At night with the lid closed the colony's weight barely moves, so the
+ * step between wakes is regressed on the temperature step and the step
+ * in its rate of change (thermal lag), plus an intercept that absorbs
+ * the slow overnight consumption.
+ */
+void LearningModel::learnWeightDrift(const LearningSample& sample) {
+    float temperature = isnan(sample.ambientTemperature) ? sample.temperature :
+                                                           sample.ambientTemperature;
+    if (isnan(sample.rawWeight) || isnan(temperature)) {
+        driftTime_ = 0;
+        return;
+    }
+
+    uint32_t gap = sample.time - driftTime_;
+    float rate = 0.0f;
+    if (driftTime_ != 0 && gap > 0 && gap <= WEIGHT_DRIFT_MAX_GAP) {
+        rate = (temperature - driftTemp_) * 3600.0f / gap;
+
+        uint8_t hour = (sample.time % SECONDS_PER_DAY) / 3600;
+        bool night = (hour >= WEIGHT_DRIFT_NIGHT_START || hour < WEIGHT_DRIFT_NIGHT_END);
+        if (night && sample.light < LIGHT_THRESHOLD) {
+            float x[3] = { 1.0f, temperature - driftTemp_, rate - driftRate_ };
+            float step = sample.rawWeight - driftWeight_;
+
+            // Skip real events (robbing, a visitor on the roof)
+            if (fabsf(step - weightDrift_.predict(x)) < WEIGHT_DRIFT_MAX_STEP) {
+                weightDrift_.update(x, step);
+                dirty_ |= LEARNING_DIRTY_WEIGHT_DRIFT;
+            }
+        }
+    }
+
+    driftTime_ = sample.time;
+    driftWeight_ = sample.rawWeight;
+    driftTemp_ = temperature;
+    driftRate_ = rate;
+}
+
+/**
+ * Weight error due to load-cell temperature drift (kg), to subtract
+ * from a raw reading. Zero relative to WEIGHT_TEMP_REFERENCE, and zero
+ * until the drift regression has seen samplesMin night steps.
+ */
+float LearningModel::weightTemperatureCorrection(float temperature, float rate) const {
+    if (weightDrift_.count() < params_->samplesMin || isnan(temperature)) {
+        return 0.0f;
+    }
+    return weightDrift_.coefficient(1) * (temperature - WEIGHT_TEMP_REFERENCE) +
+           weightDrift_.coefficient(2) * rate;
+}
+
+/**
+ * Check if the audio profile has seen enough samples to be trusted
+ */
+bool LearningModel::isAudioProfileReady() const {
+    return audioProfile_.count() >= params_->samplesMin;
+}
+
+/**
+ * Expected energy in each audio band at a given unix time
+ * Falls back to the all-day baseline until the profile is trained.
+ */
+void LearningModel::expectedAudioEnergy(uint32_t time, float levels[NUM_AUDIO_BANDS]) const {
+    if (isAudioProfileReady()) {
+        audioProfile_.expected(time, levels);
+        return;
+    }
+    memcpy(levels, baseline_.audioEnergy, sizeof(baseline_.audioEnergy));
+}
+
+/**
+ * Thermoregulation quality of the brood nest, 0 (none) to 1 (tight)
+ * Returns NAN until the tracker has seen samplesMin samples.
+ */
+float LearningModel::thermoregulationScore() const {
+    if (thermoregulation_.count() < params_->samplesMin) {
+        return NAN;
+    }
+    return thermoregulation_.score();
+}
+
+/**
+ * Weight metrics of the latest completed day
+ * Valid once update() has reported LEARNING_EVENT_DAY_COMPLETE.
+ */
+const DailyWeightSummary& LearningModel::dailyWeightSummary() const {
+    return lastDay_;
+}
+
+/**
+ * Add one accelerometer sample (g) of the current burst
+ */
+void LearningModel::addMotionSample(float ax, float ay, float az, float dt) {
+    motionScorer_.addSample(ax, ay, az, dt);
+}
+
+/**
+ * Close the burst and score it against the learned activity baseline
+ * Returns the burst's z-score; motionActivity() has its RMS values.
+ */
+float LearningModel::endMotionWindow() {
+    dirty_ |= LEARNING_DIRTY_MOTION_BASELINE;
+    return motionScorer_.endWindow();
+}
+
+/**
+ * Get the motion activity scorer
+ */
+const MotionActivityScorer& LearningModel::motionActivity() const {
+    return motionScorer_;
+}
+
+/**
+ * Check if a residual sketch has seen enough samples to set thresholds
+ */
+bool LearningModel::isSketchReady(uint8_t sketch) const {
+    return residualSketches_[sketch].count() >= params_->samplesMin;
+}
+
+/**
+ * Learned low/high bounds around an expected value from a residual sketch
+ * The percentile band is widened by the quantile margin of its width.
+ */
+void LearningModel::sketchBounds(uint8_t sketch, float expected,
+                                 float* low, float* high) const {
+    const QuantileSketch& residuals = residualSketches_[sketch];
+    float margin = params_->quantileMargin * (residuals.high() - residuals.low());
+    *low = expected + residuals.low() - margin;
+    *high = expected + residuals.high() + margin;
+}
+
+/**
+ * Get adapted temperature thresholds based on learning
+ */
+void LearningModel::tempThresholds(float* lowThreshold, float* highThreshold,
+                                   uint32_t time) const {
+    float seasonalOffset, humidityOffset;
+    patternOffsets(time, &seasonalOffset, &humidityOffset);
+
+    // Learned percentiles once enough residuals have been seen
+    if (isSketchReady(SKETCH_TEMP)) {
+        sketchBounds(SKETCH_TEMP, baseline_.tempMean + seasonalOffset,
+                     lowThreshold, highThreshold);
+        *lowThreshold = fmaxf(MIN_SAFE_TEMP, *lowThreshold);
+        *highThreshold = fminf(MAX_SAFE_TEMP, *highThreshold);
+        return;
+    }
+
+    // Base thresholds adjusted for this colony's normal patterns
+    *lowThreshold = fmaxf(MIN_SAFE_TEMP, TEMP_ALERT_LOW +
+                        (baseline_.tempMean - 35.0f) +
+                        seasonalOffset - baseline_.tempStdDev);
+
+    *highThreshold = fminf(MAX_SAFE_TEMP, TEMP_ALERT_HIGH +
+                         (baseline_.tempMean - 35.0f) +
+                         seasonalOffset + baseline_.tempStdDev);
+}
+
+/**
+ * Get adapted humidity thresholds based on learning
+ */
+void LearningModel::humidityThresholds(float* lowThreshold, float* highThreshold,
+                                       uint32_t time) const {
+    float tempOffset, seasonalOffset;
+    patternOffsets(time, &tempOffset, &seasonalOffset);
+
+    if (isSketchReady(SKETCH_HUMIDITY)) {
+        sketchBounds(SKETCH_HUMIDITY, baseline_.humidityMean + seasonalOffset,
+                     lowThreshold, highThreshold);
+        *lowThreshold = fmaxf(MIN_SAFE_HUMIDITY, *lowThreshold);
+        *highThreshold = fminf(MAX_SAFE_HUMIDITY, *highThreshold);
+        return;
+    }
+
+    *lowThreshold = fmaxf(MIN_SAFE_HUMIDITY, HUM_ALERT_LOW +
+                       seasonalOffset - baseline_.humidityStdDev);
+
+    *highThreshold = fminf(MAX_SAFE_HUMIDITY, HUM_ALERT_HIGH +
+                        seasonalOffset + baseline_.humidityStdDev);
+}
+
+/**
+ * Get adapted audio thresholds for each band at a given unix time
+ * Thresholds follow the time-of-day profile. Band energy is heavy-tailed,
+ * so learned percentiles are used when available: the normal-hum band
+ * uses its low bound (hum present above it), the queen/swarm/alarm bands
+ * their high bound.
+ */
+void LearningModel::audioThresholds(float thresholds[NUM_AUDIO_BANDS], uint32_t time) const {
+    float expected[NUM_AUDIO_BANDS];
+    expectedAudioEnergy(time, expected);
+
+    thresholds[0] = fmaxf(MIN_AUDIO_THRESHOLD, expected[0] * 0.7f); // Normal hum
+    thresholds[1] = fmaxf(MIN_AUDIO_THRESHOLD, expected[1] * 1.5f); // Queen
+    thresholds[2] = fmaxf(MIN_AUDIO_THRESHOLD, expected[2] * 1.5f); // Swarming
+    thresholds[3] = fmaxf(MIN_AUDIO_THRESHOLD, expected[3] * 1.8f); // Alarm
+
+    for (int i = 0; i < NUM_AUDIO_BANDS; i++) {
+        if (!isSketchReady(SKETCH_AUDIO + i)) {
+            continue;
+        }
+
+        float low, high;
+        sketchBounds(SKETCH_AUDIO + i, expected[i], &low, &high);
+        thresholds[i] = fmaxf(MIN_AUDIO_THRESHOLD, (i == 0) ? low : high);
+    }
+}
+
+/**
+ * Write the baseline's fields
+ */
+static void putBaseline(RecordWriter* out, const SensorBaseline& baseline) {
+    out->putFloat(baseline.tempMean);
+    out->putFloat(baseline.tempStdDev);
+    out->putFloat(baseline.humidityMean);
+    out->putFloat(baseline.humidityStdDev);
+    out->putFloat(baseline.pressureMean);
+    out->putFloat(baseline.pressureStdDev);
+    out->putFloat(baseline.weightMean);
+    out->putFloat(baseline.weightStdDev);
+    out->putFloat(baseline.weightDailyDelta);
+    out->putFloats(baseline.audioEnergy, NUM_AUDIO_BANDS);
+    out->putFloats(baseline.audioStdDev, NUM_AUDIO_BANDS);
+}
+
+/**
+ * Read the baseline's fields
+ */
+static void getBaseline(RecordReader* in, SensorBaseline* baseline) {
+    baseline->tempMean = in->getFloat();
+    baseline->tempStdDev = in->getFloat();
+    baseline->humidityMean = in->getFloat();
+    baseline->humidityStdDev = in->getFloat();
+    baseline->pressureMean = in->getFloat();
+    baseline->pressureStdDev = in->getFloat();
+    baseline->weightMean = in->getFloat();
+    baseline->weightStdDev = in->getFloat();
+    baseline->weightDailyDelta = in->getFloat();
+    in->getFloats(baseline->audioEnergy, NUM_AUDIO_BANDS);
+    in->getFloats(baseline->audioStdDev, NUM_AUDIO_BANDS);
+}
+
+/**
+ * Serialize the model into a tagged-section record
+ * Every field is written explicitly, little endian, in the layout the
+ * sections had when whole objects were copied, so older records still
+ * restore. Returns the record length, or 0 if the buffer is too small.
+ */
+uint16_t LearningModel::serialize(uint8_t* buffer, uint16_t capacity) const {
+    RecordWriter out(buffer, capacity);
+
+    out.beginSection(SECTION_BASELINE);
+    putBaseline(&out, baseline_);
+    out.endSection();
+
+    out.beginSection(SECTION_PATTERN_SLOTS);
+    for (int season = 0; season < NUM_SEASONS; season++) {
+        for (int slot = 0; slot < PATTERN_SLOTS; slot++) {
+            const PackedPattern& pattern = dailyPatterns_[season][slot];
+            out.putU16((uint16_t)pattern.tempOffset);
+            out.putU16((uint16_t)pattern.humidityOffset);
+            out.putU8(pattern.activityLevel);
+            out.putU8(pattern.sampleCount);
+        }
+    }
+    out.endSection();
+
+    out.beginSection(SECTION_COUNTERS);
+    out.putU16(sampleCount_);
+    out.putU8(season_);
+    out.putU8(established_ ? 1 : 0);
+    out.endSection();
+
+    out.beginSection(SECTION_JOINT_ACTIVITY);
+    jointDetector_.serialize(&out);
+    out.endSection();
+
+    out.beginSection(SECTION_QUANTILES);
+    for (int i = 0; i < NUM_SKETCHES; i++) {
+        residualSketches_[i].serialize(&out);
+    }
+    out.endSection();
+
+    out.beginSection(SECTION_FORECASTS);
+    for (int i = 0; i < NUM_FORECASTS; i++) {
+        forecasters_[i].serialize(&out);
+    }
+    out.endSection();
+
+    out.beginSection(SECTION_AUDIO_PROFILE);
+    audioProfile_.serialize(&out);
+    out.endSection();
+
+    out.beginSection(SECTION_THERMOREGULATION);
+    thermoregulation_.serialize(&out);
+    out.endSection();
+
+    out.beginSection(SECTION_WEIGHT_DRIFT);
+    weightDrift_.serialize(&out);
+    out.endSection();
+
+    out.beginSection(SECTION_DAILY_WEIGHT);
+    dailyWeight_.serialize(&out);
+    out.endSection();
+
+    out.beginSection(SECTION_MOTION_BASELINE);
+    motionScorer_.serialize(&out);
+    out.endSection();
+
+    return out.isValid() ? out.length() : 0;
+}
+
+/**
+ * Start the joint detector from the current baseline with no correlations
+ */
+void LearningModel::initJointDetector() {
+    float jointMean[NUM_JOINT_FEATURES] = {
+        baseline_.tempMean, baseline_.humidityMean,
+        baseline_.pressureMean, baseline_.weightMean,
+        baseline_.audioEnergy[0], baseline_.audioEnergy[1],
+        baseline_.audioEnergy[2], baseline_.audioEnergy[3],
+        MOTION_REST_RMS, 0.0f           // At rest (sensor noise), dark
+    };
+    float jointStdDev[NUM_JOINT_FEATURES] = {
+        baseline_.tempStdDev, baseline_.humidityStdDev,
+        baseline_.pressureStdDev, baseline_.weightStdDev,
+        baseline_.audioStdDev[0], baseline_.audioStdDev[1],
+        baseline_.audioStdDev[2], baseline_.audioStdDev[3],
+        MOTION_REST_RMS, 50.0f
+    };
+    jointDetector_.init(NUM_JOINT_FEATURES, jointMean, jointStdDev, jointFeatureFloor,
+                        adaptationHalfLife(params_->updateInterval, params_->adaptationRate));
+    jointScore_ = 0.0f;
+    for (int i = 0; i < NUM_JOINT_FEATURES; i++) {
+        jointContributions_[i] = 0.0f;
+    }
+}
+
+/**
+ * Restore an array of objects from one section
+ * The objects keep their current values unless the whole section
+ * reads back to exactly its length.
+ */
+template <typename T, size_t N>
+static bool restoreSection(const uint8_t* buffer, uint16_t length, uint8_t tag,
+                           T (&objects)[N]) {
+    uint16_t size;
+    const uint8_t* section = recordFindSection(buffer, length, tag, &size);
+    if (!section) {
+        return false;
+    }
+
+    RecordReader in(section, size);
+    T restored[N];
+    for (size_t i = 0; i < N; i++) {
+        restored[i].deserialize(&in);
+    }
+    if (!in.isComplete()) {
+        return false;
+    }
+    for (size_t i = 0; i < N; i++) {
+        objects[i] = restored[i];
+    }
+    return true;
+}
+
+/**
+ * Restore one object from one section
+ * Fields the section does not hold keep their current values.
+ */
+template <typename T>
+static bool restoreSection(const uint8_t* buffer, uint16_t length, uint8_t tag,
+                           T& object) {
+    uint16_t size;
+    const uint8_t* section = recordFindSection(buffer, length, tag, &size);
+    if (!section) {
+        return false;
+    }
+
+    RecordReader in(section, size);
+    T restored = object;
+    restored.deserialize(&in);
+    if (!in.isComplete()) {
+        return false;
+    }
+    object = restored;
+    return true;
+}
+
+/**
+ * Restore the model from a tagged-section record
+ * Sections that are missing or have an unexpected size keep their
+ * current values, so reset() first to fall back to defaults.
+ */
+void LearningModel::deserialize(const uint8_t* buffer, uint16_t length) {
+    uint16_t size;
+    const uint8_t* section;
+
+    section = recordFindSection(buffer, length, SECTION_BASELINE, &size);
+    if (section) {
+        RecordReader in(section, size);
+        SensorBaseline baseline;
+        getBaseline(&in, &baseline);
+        if (in.isComplete()) {
+            baseline_ = baseline;
+        }
+    }
+
+    // Hourly patterns from older records are resampled into slots. The
+    // pattern tables are too large to copy on the stack, so their size
+    // is checked before they are read in place.
+    bool migrated = false;
+    section = recordFindSection(buffer, length, SECTION_PATTERN_SLOTS, &size);
+    if (section && size == NUM_SEASONS * PATTERN_SLOTS * PATTERN_SLOT_BYTES) {
+        RecordReader in(section, size);
+        for (int season = 0; season < NUM_SEASONS; season++) {
+            for (int slot = 0; slot < PATTERN_SLOTS; slot++) {
+                PackedPattern& pattern = dailyPatterns_[season][slot];
+                pattern.tempOffset = (int16_t)in.getU16();
+                pattern.humidityOffset = (int16_t)in.getU16();
+                pattern.activityLevel = in.getU8();
+                pattern.sampleCount = in.getU8();
+            }
+        }
+    } else {
+        section = recordFindSection(buffer, length, SECTION_DAILY_PATTERNS, &size);
+        if (section && size == 24 * NUM_SEASONS * HOURLY_PATTERN_BYTES) {
+            RecordReader in(section, size);
+            DailyPattern hourly[24][NUM_SEASONS];
+            for (int hour = 0; hour < 24; hour++) {
+                for (int season = 0; season < NUM_SEASONS; season++) {
+                    DailyPattern& pattern = hourly[hour][season];
+                    pattern.activityLevel = in.getFloat();
+                    pattern.tempOffset = in.getFloat();
+                    pattern.humidityOffset = in.getFloat();
+                    pattern.sampleCount = in.getU16();
+                    in.skip(2);
+                }
+            }
+            migrateHourlyPatterns(hourly);
+            migrated = true;
+        }
+    }
+
+    section = recordFindSection(buffer, length, SECTION_COUNTERS, &size);
+    if (section) {
+        RecordReader in(section, size);
+        uint16_t sampleCount = in.getU16();
+        uint8_t season = in.getU8();
+        uint8_t established = in.getU8();
+        if (in.isComplete()) {
+            sampleCount_ = sampleCount;
+            season_ = season;
+            established_ = established != 0;
+        }
+    }
+
+    // Detectors saved before motion was gravity-removed activity are
+    // restarted from the restored baseline rather than flagging every
+    // sample as a motion anomaly
+    if (!restoreSection(buffer, length, SECTION_JOINT_ACTIVITY, jointDetector_) &&
+        recordFindSection(buffer, length, SECTION_JOINT_DETECTOR, &size)) {
+        initJointDetector();
+    }
+
+    restoreSection(buffer, length, SECTION_QUANTILES, residualSketches_);
+    restoreSection(buffer, length, SECTION_FORECASTS, forecasters_);
+    restoreSection(buffer, length, SECTION_AUDIO_PROFILE, audioProfile_);
+    restoreSection(buffer, length, SECTION_THERMOREGULATION, thermoregulation_);
+    restoreSection(buffer, length, SECTION_WEIGHT_DRIFT, weightDrift_);
+    restoreSection(buffer, length, SECTION_DAILY_WEIGHT, dailyWeight_);
+    restoreSection(buffer, length, SECTION_MOTION_BASELINE, motionScorer_);
+
+    seedStats();
+    dirty_ = migrated ? LEARNING_DIRTY_DAILY_PATTERNS : 0;
+}
+
+/**
+ * Restore the model from the pre-slot LEARN.DAT fields
+ * Old firmware only saved after a baseline existed.
+ */
+void LearningModel::restoreLegacy(const SensorBaseline& baseline,
+                                  const DailyPattern patterns[24][NUM_SEASONS],
+                                  uint16_t sampleCount, uint8_t season) {
+    baseline_ = baseline;
+    migrateHourlyPatterns(patterns);
+    sampleCount_ = sampleCount;
+    season_ = season;
+    established_ = true;
+    seedStats();
+    dirty_ = LEARNING_DIRTY_DAILY_PATTERNS;
+}
+
+/**
+ * Initialize the statistics with restored baseline values
+ */
+void LearningModel::seedStats() {
+    featureStats_.setStats(FEATURE_TEMP, baseline_.tempMean, baseline_.tempStdDev);
+    featureStats_.setStats(FEATURE_HUMIDITY, baseline_.humidityMean, baseline_.humidityStdDev);
+    featureStats_.setStats(FEATURE_PRESSURE, baseline_.pressureMean, baseline_.pressureStdDev);
+    featureStats_.setStats(FEATURE_WEIGHT, baseline_.weightMean, baseline_.weightStdDev);
+
+    for (int i = 0; i < NUM_AUDIO_BANDS; i++) {
+        featureStats_.setStats(FEATURE_AUDIO_B1 + i, baseline_.audioEnergy[i],
+                               baseline_.audioStdDev[i]);
+    }
+
+    // Motion from the activity scorer's restored baseline, which learns
+    // the same burst RMS; without one it warms up from the samples
+    if (motionScorer_.isReady()) {
+        float motionMean, motionStdDev;
+        motionScorer_.typicalActivity(&motionMean, &motionStdDev);
+        featureStats_.setStats(FEATURE_MOTION, motionMean, motionStdDev);
+    }
+}
+
+/**
+ * Get the LEARNING_DIRTY_* sections changed since the last clearDirty()
+ */
+uint16_t LearningModel::dirtySections() const {
+    return dirty_;
+}
+
+/**
+ * Mark all sections as saved
+ */
+void LearningModel::clearDirty() {
+    dirty_ = 0;
+}
+
+/**
+ * Get the learned baseline
+ */
+const SensorBaseline& LearningModel::baseline() const {
+    return baseline_;
+}
+
+/**
+ * Get learning status
+ */
+bool LearningModel::isBaselineEstablished() const {
+    return established_;
+}
+
+/**
+ * Get samples processed so far
+ */
+uint16_t LearningModel::sampleCount() const {
+    return sampleCount_;
+}
+
+/**
+ * Get the season used for daily pattern lookups
+ */
+uint8_t LearningModel::season() const {
+    return season_;
+}
+
+/**
+ * Set the season used for daily pattern lookups until the next sample
+ */
+void LearningModel::setSeason(uint8_t season) {
+    season_ = season % NUM_SEASONS;
+}
+
+/**
+ * Get learning progress percentage
+ */
+uint8_t LearningModel::progress() const {
+    if (established_) return 100;
+
+    uint32_t percent = ((uint32_t)sampleCount_ * 100) / params_->samplesMin;
+    return (percent < 99) ? percent : 99;
+}
\ No newline at end of file
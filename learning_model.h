@@ -0,0 +1,266 @@
+/**
+ * Hive Monitor System - Learning Model Header
+ *
+ * Header file for the per-colony learning model. All state that the
+ * adaptive learning module keeps about one colony lives in a single
+ * LearningModel object, so the device can keep one instance while the
+ * replay and benchmark tools hold and update thousands. The model is
+ * saved as tagged record sections, each written field by field.
+ */
+
+#ifndef LEARNING_MODEL_H
+#define LEARNING_MODEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "learning_stats.h"
+#include "anomaly_detection.h"
+#include "forecasting.h"
+
+// Number of audio frequency bands
+#define NUM_AUDIO_BANDS 4
+
+// Learning record format version (bump when a section layout changes)
+#define LEARNING_STATE_VERSION 3
+
+// Persisted sections changed since the last save (LearningModel::dirtySections)
+#define LEARNING_DIRTY_BASELINE        0x01
+#define LEARNING_DIRTY_DAILY_PATTERNS  0x02
+#define LEARNING_DIRTY_COUNTERS        0x04
+#define LEARNING_DIRTY_JOINT_DETECTOR  0x08
+#define LEARNING_DIRTY_QUANTILES       0x10
+#define LEARNING_DIRTY_FORECASTS       0x20
+#define LEARNING_DIRTY_AUDIO_PROFILE   0x40
+#define LEARNING_DIRTY_THERMOREGULATION 0x80
+#define LEARNING_DIRTY_WEIGHT_DRIFT    0x100
+#define LEARNING_DIRTY_DAILY_WEIGHT    0x200
+#define LEARNING_DIRTY_MOTION_BASELINE 0x400
+
+// Events reported by LearningModel::update
+#define LEARNING_EVENT_ESTABLISHED     0x01  // Baseline established by this sample
+#define LEARNING_EVENT_ADAPTED         0x02  // Baseline adapted by this sample
+#define LEARNING_EVENT_JOINT_ANOMALY   0x04  // Sample is a joint anomaly
+#define LEARNING_EVENT_DAY_COMPLETE    0x08  // Sample closed a day's weight summary
+
+// Features scored jointly by the multivariate anomaly detector
+enum JointFeature {
+    FEATURE_TEMP,
+    FEATURE_HUMIDITY,
+    FEATURE_PRESSURE,
+    FEATURE_WEIGHT,
+    FEATURE_AUDIO_B1,
+    FEATURE_AUDIO_B2,
+    FEATURE_AUDIO_B3,
+    FEATURE_AUDIO_B4,
+    FEATURE_MOTION,
+    FEATURE_LIGHT,
+    NUM_JOINT_FEATURES
+};
+
+// Structure to hold baseline sensor data
+typedef struct {
+    float tempMean;          // Mean temperature
+    float tempStdDev;        // Temperature standard deviation
+    float humidityMean;      // Mean humidity
+    float humidityStdDev;    // Humidity standard deviation
+    float pressureMean;      // Mean barometric pressure
+    float pressureStdDev;    // Pressure standard deviation
+    float weightMean;        // Mean hive weight
+    float weightStdDev;      // Weight standard deviation
+    float weightDailyDelta;  // Normal daily weight fluctuation
+    float audioEnergy[NUM_AUDIO_BANDS];  // Mean energy in each freq band
+    float audioStdDev[NUM_AUDIO_BANDS];  // StdDev in each freq band
+} SensorBaseline;
+
+// Hourly time-of-day pattern as kept by older firmware (migration only)
+typedef struct {
+    float activityLevel;    // Relative activity level (0.0-1.0)
+    float tempOffset;       // Temperature offset from baseline
+    float humidityOffset;   // Humidity offset from baseline
+    uint16_t sampleCount;   // Number of samples for this time period
+} DailyPattern;
+
+// Time-of-day pattern slots (15 minutes each)
+#define PATTERN_SLOTS          96
+#define PATTERN_SLOT_SECONDS   (86400UL / PATTERN_SLOTS)
+
+// Fixed-point scales of the packed pattern fields (LSB = 1/scale)
+#define PATTERN_TEMP_SCALE      512.0f   // 0.002 °C, ±64 °C
+#define PATTERN_HUMIDITY_SCALE  256.0f   // 0.004 %, ±128 %
+#define PATTERN_ACTIVITY_SCALE  64.0f    // 0.016, 0-4
+
+// Packed time-of-day pattern slot (6 bytes)
+typedef struct {
+    int16_t tempOffset;      // Temperature offset from baseline (PATTERN_TEMP_SCALE)
+    int16_t humidityOffset;  // Humidity offset from baseline (PATTERN_HUMIDITY_SCALE)
+    uint8_t activityLevel;   // Relative activity level (PATTERN_ACTIVITY_SCALE)
+    uint8_t sampleCount;     // Samples in this slot, saturating
+} PackedPattern;
+
+// One wake's readings as seen by the learning model
+typedef struct {
+    uint32_t time;                       // Unix time of the readings (s)
+    uint8_t month;                       // Month (1-12)
+    float temperature;                   // Brood temperature (°C)
+    float ambientTemperature;            // Ambient temperature (°C), NAN if unavailable
+    float humidity;                      // Relative humidity (%)
+    float pressure;                      // Barometric pressure (hPa)
+    float weight;                        // Hive weight, temperature compensated (kg)
+    float rawWeight;                     // Load cell reading before compensation (kg)
+    float audioEnergy[NUM_AUDIO_BANDS];  // Energy in each freq band
+    float motion;                        // Acceleration RMS, gravity removed (g)
+    float light;                         // Light level (lux)
+} LearningSample;
+
+// Tunable learning parameters, shared by all models that point to them
+typedef struct {
+    uint16_t samplesMin;             // Samples needed for a valid baseline
+    uint16_t updateInterval;         // Adapt the baseline every N samples
+    float adaptationRate;            // Baseline adaptation rate per interval
+    float tempAnomalyThreshold;      // Z-score for temperature anomalies
+    float humidityAnomalyThreshold;  // Z-score for humidity anomalies
+    float audioHumAnomalyThreshold;  // Z-score for normal hum anomalies (fallback)
+    float audioAnomalyThreshold;     // Z-score for other audio band anomalies (fallback)
+    float weightAnomalyThreshold;    // Z-score for weight anomalies
+    float weightChangeThreshold;     // Std deviations for a sudden weight change
+    float jointAnomalyThreshold;     // Squared Mahalanobis distance
+    float quantileLow;               // Lower percentile for learned thresholds
+    float quantileHigh;              // Upper percentile for learned thresholds
+    float quantileMargin;            // Widening of the learned percentile band
+    uint16_t quantileHorizon;        // Percentile sketch memory (samples)
+    float forecastAlpha;             // Holt-Winters level smoothing
+    float forecastBeta;              // Holt-Winters trend smoothing
+    float forecastGamma;             // Holt-Winters seasonal smoothing
+} LearningParams;
+
+// Parameters from config.h
+extern const LearningParams learningDefaultParams;
+
+// Seasons tracked by the daily patterns
+#define NUM_SEASONS 4
+
+// Percentile sketches of residuals from the learned expectation
+#define SKETCH_TEMP      0
+#define SKETCH_HUMIDITY  1
+#define SKETCH_AUDIO     2     // One per audio band from here
+#define NUM_SKETCHES     (SKETCH_AUDIO + NUM_AUDIO_BANDS)
+
+// Seasonal forecasters
+#define FORECAST_TEMP    0
+#define FORECAST_WEIGHT  1
+#define NUM_FORECASTS    2
+
+// Learned state of one colony (~4 KB). Hot per-sample state comes
+// first and the daily pattern table, of which a sample touches a single
+// entry, last. Parameters are referenced, not copied, so many colonies
+// can share one set.
+class LearningModel {
+public:
+    LearningModel() : params_(&learningDefaultParams) { reset(); }
+
+    void init(const LearningParams* params);
+    void reset();
+    uint8_t update(const LearningSample& sample);
+    static void updateBatch(LearningModel* models, const LearningSample* samples,
+                            size_t count, uint8_t* events);
+
+    // Baseline maintenance
+    void updateBaseline();
+    void updateDailyPattern(uint8_t slot, uint8_t season, float activity,
+                            float temp, float humidity);
+
+    // Anomaly detection
+    bool isTemperatureAnomaly(float temperature, uint32_t time) const;
+    bool isHumidityAnomaly(float humidity, uint32_t time) const;
+    bool isAudioAnomaly(const float* audioLevels, uint32_t time) const;
+    bool isWeightAnomaly(float weight, float previousWeight, uint32_t time) const;
+    bool isJointAnomaly() const;
+    float jointAnomalyScore(float* contributions) const;
+
+    // Forecasts
+    float forecastTemperature(uint32_t time) const;
+    float forecastWeight(uint32_t time) const;
+    float weightDailyOffset(uint32_t time) const;
+    float weightTemperatureCorrection(float temperature, float rate) const;
+    void expectedAudioEnergy(uint32_t time, float levels[NUM_AUDIO_BANDS]) const;
+
+    // Colony condition
+    float thermoregulationScore() const;
+    const DailyWeightSummary& dailyWeightSummary() const;
+
+    // Motion activity, one accelerometer burst per window
+    void addMotionSample(float ax, float ay, float az, float dt);
+    float endMotionWindow();
+    const MotionActivityScorer& motionActivity() const;
+
+    // Adapted thresholds
+    void tempThresholds(float* lowThreshold, float* highThreshold, uint32_t time) const;
+    void humidityThresholds(float* lowThreshold, float* highThreshold, uint32_t time) const;
+    void audioThresholds(float thresholds[NUM_AUDIO_BANDS], uint32_t time) const;
+
+    // Serialization
+    uint16_t serialize(uint8_t* buffer, uint16_t capacity) const;
+    void deserialize(const uint8_t* buffer, uint16_t length);
+    void restoreLegacy(const SensorBaseline& baseline,
+                       const DailyPattern patterns[24][NUM_SEASONS],
+                       uint16_t sampleCount, uint8_t season);
+    uint16_t dirtySections() const;
+    void clearDirty();
+
+    // Status
+    const SensorBaseline& baseline() const;
+    bool isBaselineEstablished() const;
+    uint16_t sampleCount() const;
+    uint8_t season() const;
+    uint8_t progress() const;
+    void setSeason(uint8_t season);
+
+private:
+    bool isSketchReady(uint8_t sketch) const;
+    void sketchBounds(uint8_t sketch, float expected, float* low, float* high) const;
+    bool isForecastReady(uint8_t series) const;
+    bool isAudioProfileReady() const;
+    float forecastZScore(uint8_t series, float value, uint32_t time, float minStdDev) const;
+    void seedStats();
+    void initJointDetector();
+    void learnWeightDrift(const LearningSample& sample);
+    void patternOffsets(uint32_t time, float* tempOffset, float* humidityOffset) const;
+    void migrateHourlyPatterns(const DailyPattern hourly[24][NUM_SEASONS]);
+
+    const LearningParams* params_;   // Shared tunables
+    uint16_t sampleCount_;           // Samples processed so far
+    uint8_t season_;                 // Season of the latest sample
+    bool established_;               // Baseline established
+    uint16_t dirty_;                 // LEARNING_DIRTY_* sections changed since the last save
+    float jointScore_;               // Joint anomaly score of the latest sample
+
+    // Exponentially weighted statistics for incremental calculations,
+    // one per JointFeature
+    EWStatsBlock featureStats_;
+
+    SensorBaseline baseline_;
+    float jointContributions_[NUM_JOINT_FEATURES];
+    MahalanobisDetector jointDetector_;
+    HoltWintersForecaster forecasters_[NUM_FORECASTS];
+    DailyHarmonicModel audioProfile_;  // Time-of-day audio energy per band
+    QuantileSketch residualSketches_[NUM_SKETCHES];
+    ThermoregulationTracker thermoregulation_;
+    RecursiveLeastSquares weightDrift_;  // Night weight steps against temperature
+    DailyWeightAnalyzer dailyWeight_;
+    MotionActivityScorer motionScorer_;  // Burst activity against the hive's own rest
+    DailyWeightSummary lastDay_;     // Latest completed day (not persisted)
+
+    // Previous wake, for the drift regression's differences
+    uint32_t driftTime_;             // Unix time (s), 0 if none
+    float driftWeight_;              // Raw weight (kg)
+    float driftTemp_;                // Load cell temperature (°C)
+    float driftRate_;                // Temperature rate of change (°C/h)
+
+    // Daily patterns storage (season by 15-minute slot)
+    PackedPattern dailyPatterns_[NUM_SEASONS][PATTERN_SLOTS];
+};
+
+// Function prototypes
+uint8_t getSeason(uint8_t month);
+
+#endif // LEARNING_MODEL_H
\ No newline at end of file
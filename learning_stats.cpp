@@ -0,0 +1,937 @@
+/**
+ * Hive Monitor System - Learning Statistics Module
+ *
+ * Streaming statistics for the adaptive learning module. Everything
+ * here runs in O(1) time and fixed memory per sample, in float32, so
+ * it suits the nRF52840's single-precision FPU.
+ */
+
+#include "learning_stats.h"
+#include <math.h>
+
+/**
+ * Set the half-life (in samples) after which a sample's weight halves
+ */
+void EWStats::setHalfLife(float halfLifeSamples) {
+    if (halfLifeSamples < 1.0f) {
+        halfLifeSamples = 1.0f;
+    }
+    alpha_ = 1.0f - powf(0.5f, 1.0f / halfLifeSamples);
+}
+
+/**
+ * Add a sample to exponentially weighted statistics
+ * Non-finite values (a failed sensor read) are ignored.
+ */
+void EWStats::addSample(float value) {
+    if (!isfinite(value)) {
+        return;
+    }
+    if (count_ < UINT16_MAX) {
+        count_++;
+    }
+
+    // Use the exact running mean until the 1/n weight drops below alpha
+    float weight = 1.0f / count_;
+    if (weight < alpha_) {
+        weight = alpha_;
+    }
+
+    // Incremental EW mean/variance (West 1979); both terms stay bounded
+    // so there is no catastrophic cancellation in float32
+    float delta = value - mean_;
+    float increment = weight * delta;
+    mean_ += increment;
+    var_ = (1.0f - weight) * (var_ + delta * increment);
+}
+
+/**
+ * Reset statistics (half-life is kept)
+ */
+void EWStats::reset() {
+    mean_ = 0.0f;
+    var_ = 0.0f;
+    count_ = 0;
+}
+
+/**
+ * Set statistics to known values
+ * The restored state counts as fully warmed up, so new samples are
+ * blended in at the configured half-life rather than overriding it.
+ */
+void EWStats::setStats(float mean, float stdDev) {
+    mean_ = mean;
+    var_ = stdDev * stdDev;
+    count_ = UINT16_MAX;
+}
+
+/**
+ * Get current mean
+ */
+float EWStats::mean() const {
+    return (count_ > 0) ? mean_ : 0.0f;
+}
+
+/**
+ * Get current variance
+ */
+float EWStats::variance() const {
+    return (count_ > 1) ? var_ : 0.0f;
+}
+
+/**
+ * Get current standard deviation
+ */
+float EWStats::standardDeviation() const {
+    return sqrtf(variance());
+}
+
+/**
+ * Get sample count (saturates at UINT16_MAX)
+ */
+uint16_t EWStats::count() const {
+    return count_;
+}
+
+/**
+ * Write the statistics to a record section
+ * The reserved bytes keep the layout of records written before the
+ * fields were serialized one by one.
+ */
+void EWStats::serialize(RecordWriter* out) const {
+    out->putFloat(alpha_);
+    out->putFloat(mean_);
+    out->putFloat(var_);
+    out->putU16(count_);
+    out->putReserved(2);
+}
+
+/**
+ * Read the statistics from a record section
+ */
+void EWStats::deserialize(RecordReader* in) {
+    alpha_ = in->getFloat();
+    mean_ = in->getFloat();
+    var_ = in->getFloat();
+    count_ = in->getU16();
+    in->skip(2);
+}
+
+/**
+ * Initialize a block of features, each with a one-sample half-life
+ */
+void EWStatsBlock::init(uint8_t features) {
+    size_ = (features > EW_BLOCK_MAX_FEATURES) ? EW_BLOCK_MAX_FEATURES : features;
+    for (uint8_t i = 0; i < EW_BLOCK_MAX_FEATURES; i++) {
+        alpha_[i] = 1.0f;
+    }
+    reset();
+}
+
+/**
+ * Set the half-life (in samples) of one feature
+ */
+void EWStatsBlock::setHalfLife(uint8_t feature, float halfLifeSamples) {
+    if (halfLifeSamples < 1.0f) {
+        halfLifeSamples = 1.0f;
+    }
+    alpha_[feature] = 1.0f - powf(0.5f, 1.0f / halfLifeSamples);
+    updateFloor(feature);
+}
+
+/**
+ * Recompute a feature's smallest weight from its half-life and state
+ * A restored EWStats sits at the saturated count, so 1/UINT16_MAX.
+ */
+void EWStatsBlock::updateFloor(uint8_t feature) {
+    const float saturated = 1.0f / UINT16_MAX;
+    float alpha = alpha_[feature];
+    floor_[feature] = (counting_[feature] == 0.0f && saturated > alpha) ? saturated : alpha;
+}
+
+/**
+ * Add one sample to every feature (values[0..size()-1])
+ * A non-finite value leaves its feature unchanged; the block's count
+ * still advances, so that feature's warm-up weight is slightly low.
+ */
+void EWStatsBlock::addSample(const float* values) {
+    if (count_ < UINT16_MAX) {
+        count_++;
+    }
+
+    // One divide for the block; weight = max(1/n, alpha) as in EWStats
+    const float inverseCount = 1.0f / count_;
+
+    for (int i = 0; i < size_; i++) {
+        if (!isfinite(values[i])) {
+            continue;
+        }
+        float weight = inverseCount * counting_[i];
+        weight = (weight < floor_[i]) ? floor_[i] : weight;
+        float delta = values[i] - mean_[i];
+        float increment = weight * delta;
+        mean_[i] += increment;
+        var_[i] = (1.0f - weight) * (var_[i] + delta * increment);
+    }
+}
+
+/**
+ * Reset statistics (half-lives are kept)
+ */
+void EWStatsBlock::reset() {
+    count_ = 0;
+    for (uint8_t i = 0; i < EW_BLOCK_MAX_FEATURES; i++) {
+        counting_[i] = 1.0f;
+        floor_[i] = alpha_[i];
+        mean_[i] = 0.0f;
+        var_[i] = 0.0f;
+    }
+}
+
+/**
+ * Set one feature's statistics to known values
+ */
+void EWStatsBlock::setStats(uint8_t feature, float mean, float stdDev) {
+    counting_[feature] = 0.0f;
+    updateFloor(feature);
+    mean_[feature] = mean;
+    var_[feature] = stdDev * stdDev;
+}
+
+/**
+ * Get one feature's mean
+ */
+float EWStatsBlock::mean(uint8_t feature) const {
+    return (count(feature) > 0) ? mean_[feature] : 0.0f;
+}
+
+/**
+ * Get one feature's variance
+ */
+float EWStatsBlock::variance(uint8_t feature) const {
+    return (count(feature) > 1) ? var_[feature] : 0.0f;
+}
+
+/**
+ * Get one feature's standard deviation
+ */
+float EWStatsBlock::standardDeviation(uint8_t feature) const {
+    return sqrtf(variance(feature));
+}
+
+/**
+ * Get one feature's sample count (saturates at UINT16_MAX)
+ */
+uint16_t EWStatsBlock::count(uint8_t feature) const {
+    return (counting_[feature] == 0.0f) ? UINT16_MAX : count_;
+}
+
+/**
+ * Get the number of features in the block
+ */
+uint8_t EWStatsBlock::size() const {
+    return size_;
+}
+
+/**
+ * Initialize a quantile sketch for the given low/high percentiles
+ */
+void QuantileSketch::init(float lowQuantile, float highQuantile, uint16_t horizonSamples) {
+    lowQuantile_ = lowQuantile;
+    highQuantile_ = highQuantile;
+    horizon_ = (horizonSamples < 2 * QUANTILE_MARKERS) ? 2 * QUANTILE_MARKERS : horizonSamples;
+    reset();
+}
+
+/**
+ * Reset the sketch (percentiles and horizon are kept)
+ */
+void QuantileSketch::reset() {
+    count_ = 0;
+    for (uint8_t i = 0; i < QUANTILE_MARKERS; i++) {
+        heights_[i] = 0.0f;
+        positions_[i] = i + 1;
+    }
+}
+
+/**
+ * Target quantile of each marker
+ */
+float QuantileSketch::targetQuantile(uint8_t marker) const {
+    switch (marker) {
+        case 0: return 0.0f;
+        case 1: return lowQuantile_ / 2;
+        case 2: return lowQuantile_;
+        case 3: return 0.5f;
+        case 4: return highQuantile_;
+        case 5: return (1.0f + highQuantile_) / 2;
+        default: return 1.0f;
+    }
+}
+
+/**
+ * Add a sample to the sketch
+ * Non-finite values are ignored.
+ */
+void QuantileSketch::addSample(float value) {
+    if (!isfinite(value)) {
+        return;
+    }
+
+    // Fill the markers with the first samples, kept sorted
+    if (count_ < QUANTILE_MARKERS) {
+        uint8_t i = count_;
+        while (i > 0 && heights_[i - 1] > value) {
+            heights_[i] = heights_[i - 1];
+            i--;
+        }
+        heights_[i] = value;
+        count_++;
+        return;
+    }
+
+    if (count_ < UINT16_MAX) {
+        count_++;
+    }
+
+    // Find the cell the sample falls in, extending the extremes
+    uint8_t cell;
+    if (value < heights_[0]) {
+        heights_[0] = value;
+        cell = 0;
+    } else if (value >= heights_[QUANTILE_MARKERS - 1]) {
+        heights_[QUANTILE_MARKERS - 1] = value;
+        cell = QUANTILE_MARKERS - 2;
+    } else {
+        cell = 0;
+        while (value >= heights_[cell + 1]) {
+            cell++;
+        }
+    }
+
+    for (uint8_t i = cell + 1; i < QUANTILE_MARKERS; i++) {
+        positions_[i] += 1.0f;
+    }
+
+    // Age the sketch: halve all ranks, keeping markers at least 1 apart
+    if (positions_[QUANTILE_MARKERS - 1] > horizon_) {
+        for (uint8_t i = 1; i < QUANTILE_MARKERS; i++) {
+            positions_[i] = 1.0f + (positions_[i] - 1.0f) * 0.5f;
+            if (positions_[i] < positions_[i - 1] + 1.0f) {
+                positions_[i] = positions_[i - 1] + 1.0f;
+            }
+        }
+    }
+
+    // Move inner markers toward their desired ranks
+    float total = positions_[QUANTILE_MARKERS - 1];
+    for (uint8_t i = 1; i < QUANTILE_MARKERS - 1; i++) {
+        float desired = 1.0f + (total - 1.0f) * targetQuantile(i);
+        float offset = desired - positions_[i];
+
+        if ((offset >= 1.0f && positions_[i + 1] - positions_[i] > 1.0f) ||
+            (offset <= -1.0f && positions_[i - 1] - positions_[i] < -1.0f)) {
+            float step = (offset > 0) ? 1.0f : -1.0f;
+
+            // Piecewise-parabolic prediction, linear if it breaks ordering
+            float below = positions_[i] - positions_[i - 1];
+            float above = positions_[i + 1] - positions_[i];
+            float candidate = heights_[i] + step / (positions_[i + 1] - positions_[i - 1]) *
+                ((below + step) * (heights_[i + 1] - heights_[i]) / above +
+                 (above - step) * (heights_[i] - heights_[i - 1]) / below);
+
+            if (candidate <= heights_[i - 1] || candidate >= heights_[i + 1]) {
+                uint8_t neighbour = (step > 0) ? i + 1 : i - 1;
+                candidate = heights_[i] + step * (heights_[neighbour] - heights_[i]) /
+                            (positions_[neighbour] - positions_[i]);
+            }
+
+            heights_[i] = candidate;
+            positions_[i] += step;
+        }
+    }
+}
+
+/**
+ * Height of a marker, interpolating from sorted samples during warm-up
+ */
+float QuantileSketch::heightAt(uint8_t marker) const {
+    if (count_ == 0) {
+        return 0.0f;
+    }
+    if (count_ < QUANTILE_MARKERS) {
+        return heights_[(uint8_t)(targetQuantile(marker) * (count_ - 1) + 0.5f)];
+    }
+    return heights_[marker];
+}
+
+/**
+ * Get estimated low percentile
+ */
+float QuantileSketch::low() const {
+    return heightAt(2);
+}
+
+/**
+ * Get estimated median
+ */
+float QuantileSketch::median() const {
+    return heightAt(3);
+}
+
+/**
+ * Get estimated high percentile
+ */
+float QuantileSketch::high() const {
+    return heightAt(4);
+}
+
+/**
+ * Get sample count (saturates at UINT16_MAX)
+ */
+uint16_t QuantileSketch::count() const {
+    return count_;
+}
+
+/**
+ * Write the sketch to a record section
+ */
+void QuantileSketch::serialize(RecordWriter* out) const {
+    out->putFloat(lowQuantile_);
+    out->putFloat(highQuantile_);
+    out->putU16(horizon_);
+    out->putU16(count_);
+    out->putFloats(heights_, QUANTILE_MARKERS);
+    out->putFloats(positions_, QUANTILE_MARKERS);
+}
+
+/**
+ * Read the sketch from a record section
+ */
+void QuantileSketch::deserialize(RecordReader* in) {
+    lowQuantile_ = in->getFloat();
+    highQuantile_ = in->getFloat();
+    horizon_ = in->getU16();
+    count_ = in->getU16();
+    in->getFloats(heights_, QUANTILE_MARKERS);
+    in->getFloats(positions_, QUANTILE_MARKERS);
+}
+
+/**
+ * Initialize the tracker with band half-lives (samples) and the target band
+ */
+void ThermoregulationTracker::init(float fastHalfLife, float slowHalfLife,
+                                   float target, float tolerance) {
+    target_ = target;
+    tolerance_ = (tolerance > 0.01f) ? tolerance : 0.01f;
+    broodFast_.setHalfLife(fastHalfLife);
+    broodSlow_.setHalfLife(slowHalfLife);
+    ambientFast_.setHalfLife(fastHalfLife);
+    ambientSlow_.setHalfLife(slowHalfLife);
+    reset();
+}
+
+/**
+ * Add one wake's nest and ambient temperatures
+ * ambientTemp may be NAN when no ambient reading is available.
+ */
+void ThermoregulationTracker::addSample(float broodTemp, float ambientTemp) {
+    if (isnan(broodTemp)) {
+        return;
+    }
+    broodFast_.addSample(broodTemp);
+    broodSlow_.addSample(broodFast_.mean());
+
+    if (!isnan(ambientTemp)) {
+        ambientFast_.addSample(ambientTemp);
+        ambientSlow_.addSample(ambientFast_.mean());
+    }
+}
+
+/**
+ * Reset statistics (half-lives and target are kept)
+ */
+void ThermoregulationTracker::reset() {
+    broodFast_.reset();
+    broodSlow_.reset();
+    ambientFast_.reset();
+    ambientSlow_.reset();
+}
+
+/**
+ * Thermoregulation quality from 0 (none) to 1 (tight, brood likely)
+ */
+float ThermoregulationTracker::score() const {
+    // Nest level: full marks anywhere within tolerance of the target
+    float excess = fmaxf(fabsf(broodFast_.mean() - target_) - tolerance_, 0.0f) / tolerance_;
+    float levelScore = 1.0f / (1.0f + excess * excess);
+
+    // Nest stability on its own
+    float spread = broodStdDev() / tolerance_;
+    float stabilityScore = 1.0f / (1.0f + spread * spread);
+
+    // Damping of ambient swings, trusted as far as the ambient swings at all
+    float ambientVar = ambientFast_.variance() + ambientSlow_.variance();
+    float ambientWeight = ambientVar / (ambientVar + tolerance_ * tolerance_);
+    float gain = attenuation() / 0.2f;  // A regulated nest passes ~20% or less
+    float attenuationScore = 1.0f / (1.0f + gain * gain);
+
+    return levelScore * (ambientWeight * attenuationScore +
+                         (1.0f - ambientWeight) * stabilityScore);
+}
+
+/**
+ * Nest temperature standard deviation over the sub-hour and diurnal bands
+ */
+float ThermoregulationTracker::broodStdDev() const {
+    return sqrtf(broodFast_.variance() + broodSlow_.variance());
+}
+
+/**
+ * Ratio of nest to ambient temperature swings (0 with no ambient swings)
+ */
+float ThermoregulationTracker::attenuation() const {
+    float ambientVar = ambientFast_.variance() + ambientSlow_.variance();
+    if (ambientVar <= 0.0f) {
+        return 0.0f;
+    }
+    return sqrtf((broodFast_.variance() + broodSlow_.variance()) / ambientVar);
+}
+
+/**
+ * Get nest sample count (saturates at UINT16_MAX)
+ */
+uint16_t ThermoregulationTracker::count() const {
+    return broodFast_.count();
+}
+
+/**
+ * Write the tracker to a record section
+ */
+void ThermoregulationTracker::serialize(RecordWriter* out) const {
+    out->putFloat(target_);
+    out->putFloat(tolerance_);
+    broodFast_.serialize(out);
+    broodSlow_.serialize(out);
+    ambientFast_.serialize(out);
+    ambientSlow_.serialize(out);
+}
+
+/**
+ * Read the tracker from a record section
+ */
+void ThermoregulationTracker::deserialize(RecordReader* in) {
+    target_ = in->getFloat();
+    tolerance_ = in->getFloat();
+    broodFast_.deserialize(in);
+    broodSlow_.deserialize(in);
+    ambientFast_.deserialize(in);
+    ambientSlow_.deserialize(in);
+}
+
+/**
+ * Set dawn and dusk and start over
+ */
+void DailyWeightAnalyzer::init(uint8_t dawnHour, uint8_t duskHour, uint8_t departureHours,
+                               float rangeHalfLifeDays) {
+    dawnSecond_ = dawnHour * 3600UL;
+    duskSecond_ = duskHour * 3600UL;
+    departureSeconds_ = departureHours * 3600UL;
+    dailyRange_.setHalfLife(rangeHalfLifeDays);
+    reset();
+}
+
+/**
+ * Add one weight reading
+ * Returns true when the reading starts a new day; the finished day is
+ * then written to completed.
+ */
+bool DailyWeightAnalyzer::addSample(uint32_t time, float weight,
+                                    DailyWeightSummary* completed) {
+    if (isnan(weight)) {
+        return false;
+    }
+
+    uint32_t dayStart = time - time % 86400UL;
+    bool finished = false;
+    if (dayStart != today_.dayStart) {
+        if (today_.samples > 0 && dayStart > today_.dayStart) {
+            finishDay(completed);
+            finished = true;
+
+            // Yesterday's dusk only carries over to the next calendar day
+            if (dayStart - completed->dayStart > 86400UL) {
+                previousDusk_ = NAN;
+            }
+        }
+        startDay(dayStart);
+    }
+
+    if (today_.samples == 0) {
+        today_.openWeight = weight;
+        today_.minWeight = weight;
+        today_.maxWeight = weight;
+        today_.minTime = time;
+        today_.maxTime = time;
+    }
+    if (today_.samples < UINT16_MAX) {
+        today_.samples++;
+    }
+    today_.closeWeight = weight;
+
+    if (weight < today_.minWeight) {
+        today_.minWeight = weight;
+        today_.minTime = time;
+    }
+    if (weight > today_.maxWeight) {
+        today_.maxWeight = weight;
+        today_.maxTime = time;
+    }
+
+    uint32_t second = time - dayStart;
+    if (today_.dawnTime == 0 && second >= dawnSecond_) {
+        today_.dawnWeight = weight;
+        today_.dawnTime = time;
+        departureLow_ = weight;
+    } else if (today_.dawnTime != 0 && time - today_.dawnTime <= departureSeconds_) {
+        departureLow_ = fminf(departureLow_, weight);
+    }
+    if (today_.duskTime == 0 && second >= duskSecond_) {
+        today_.duskWeight = weight;
+        today_.duskTime = time;
+    }
+
+    return finished;
+}
+
+/**
+ * Forget the day in progress and all history (dawn and dusk are kept)
+ */
+void DailyWeightAnalyzer::reset() {
+    startDay(0);
+    previousDusk_ = NAN;
+    dailyRange_.reset();
+}
+
+/**
+ * Exponentially weighted average of the daily weight range (kg)
+ */
+float DailyWeightAnalyzer::typicalRange() const {
+    return dailyRange_.mean();
+}
+
+/**
+ * Get the number of completed days (saturates at UINT16_MAX)
+ */
+uint16_t DailyWeightAnalyzer::days() const {
+    return dailyRange_.count();
+}
+
+/**
+ * Write the analyzer, including the day in progress, to a record section
+ * The reserved bytes keep the layout of records written before the
+ * fields were serialized one by one.
+ */
+void DailyWeightAnalyzer::serialize(RecordWriter* out) const {
+    out->putU32(dawnSecond_);
+    out->putU32(duskSecond_);
+    out->putU32(departureSeconds_);
+    out->putU32(today_.dayStart);
+    out->putU16(today_.samples);
+    out->putReserved(2);
+    out->putFloat(today_.openWeight);
+    out->putFloat(today_.closeWeight);
+    out->putFloat(today_.minWeight);
+    out->putFloat(today_.maxWeight);
+    out->putU32(today_.minTime);
+    out->putU32(today_.maxTime);
+    out->putFloat(today_.dawnWeight);
+    out->putU32(today_.dawnTime);
+    out->putFloat(today_.duskWeight);
+    out->putU32(today_.duskTime);
+    out->putFloat(today_.dailyGain);
+    out->putFloat(today_.overnightLoss);
+    out->putFloat(today_.departureDip);
+    out->putFloat(today_.netFlow);
+    out->putFloat(departureLow_);
+    out->putFloat(previousDusk_);
+    dailyRange_.serialize(out);
+}
+
+/**
+ * Read the analyzer from a record section
+ */
+void DailyWeightAnalyzer::deserialize(RecordReader* in) {
+    dawnSecond_ = in->getU32();
+    duskSecond_ = in->getU32();
+    departureSeconds_ = in->getU32();
+    today_.dayStart = in->getU32();
+    today_.samples = in->getU16();
+    in->skip(2);
+    today_.openWeight = in->getFloat();
+    today_.closeWeight = in->getFloat();
+    today_.minWeight = in->getFloat();
+    today_.maxWeight = in->getFloat();
+    today_.minTime = in->getU32();
+    today_.maxTime = in->getU32();
+    today_.dawnWeight = in->getFloat();
+    today_.dawnTime = in->getU32();
+    today_.duskWeight = in->getFloat();
+    today_.duskTime = in->getU32();
+    today_.dailyGain = in->getFloat();
+    today_.overnightLoss = in->getFloat();
+    today_.departureDip = in->getFloat();
+    today_.netFlow = in->getFloat();
+    departureLow_ = in->getFloat();
+    previousDusk_ = in->getFloat();
+    dailyRange_.deserialize(in);
+}
+
+/**
+ * Clear the day in progress
+ */
+void DailyWeightAnalyzer::startDay(uint32_t dayStart) {
+    today_.dayStart = dayStart;
+    today_.samples = 0;
+    today_.openWeight = NAN;
+    today_.closeWeight = NAN;
+    today_.minWeight = NAN;
+    today_.maxWeight = NAN;
+    today_.minTime = 0;
+    today_.maxTime = 0;
+    today_.dawnWeight = NAN;
+    today_.dawnTime = 0;
+    today_.duskWeight = NAN;
+    today_.duskTime = 0;
+    today_.dailyGain = NAN;
+    today_.overnightLoss = NAN;
+    today_.departureDip = NAN;
+    today_.netFlow = NAN;
+    departureLow_ = NAN;
+}
+
+/**
+ * Derive the day's metrics and carry its dusk reading forward
+ */
+void DailyWeightAnalyzer::finishDay(DailyWeightSummary* completed) {
+    *completed = today_;
+    completed->dailyGain = today_.closeWeight - today_.openWeight;
+    completed->overnightLoss = previousDusk_ - today_.dawnWeight;  // NAN if either is
+    completed->departureDip = today_.dawnWeight - departureLow_;
+    completed->netFlow = today_.duskWeight - today_.dawnWeight;
+
+    dailyRange_.addSample(today_.maxWeight - today_.minWeight);
+    previousDusk_ = today_.duskWeight;
+}
+
+// Smallest RMS and jerk taken into the log scores (g, g/s)
+#define MOTION_RMS_FLOOR   1e-5f
+#define MOTION_JERK_FLOOR  1e-3f
+
+/**
+ * Set up the motion activity scorer
+ * restHalfLife and baselineHalfLife are in windows, restTolerance in g.
+ * minStdDev floors the baseline spread in natural-log units (0.1 is
+ * about 10 %); windows scoring above learnLimit are not learned once
+ * the baseline is ready.
+ */
+void MotionActivityScorer::init(float restHalfLife, float restTolerance, float baselineHalfLife,
+                                float minStdDev, float learnLimit, uint16_t minWindows) {
+    if (restHalfLife < 1.0f) {
+        restHalfLife = 1.0f;
+    }
+    restAlpha_ = 1.0f - powf(0.5f, 1.0f / restHalfLife);
+    restTolerance_ = restTolerance;
+    minStdDev_ = (minStdDev > 0.001f) ? minStdDev : 0.001f;
+    learnLimit_ = learnLimit;
+    minWindows_ = (minWindows > 0) ? minWindows : 1;
+    rmsBaseline_.setHalfLife(baselineHalfLife);
+    jerkBaseline_.setHalfLife(baselineHalfLife);
+    reset();
+}
+
+/**
+ * Add one accelerometer sample (g) taken dt seconds after the previous
+ * Until a rest vector has been learned the first sample stands in for
+ * it.
+ */
+void MotionActivityScorer::addSample(float ax, float ay, float az, float dt) {
+    if (!restSet_) {
+        rest_[0] = ax;
+        rest_[1] = ay;
+        rest_[2] = az;
+        restSet_ = true;
+    }
+
+    float dx = ax - rest_[0];
+    float dy = ay - rest_[1];
+    float dz = az - rest_[2];
+    sum_[0] += dx;
+    sum_[1] += dy;
+    sum_[2] += dz;
+    sumSquares_ += dx * dx + dy * dy + dz * dz;
+
+    if (samples_ > 0 && dt > 0.0f) {
+        float jx = (ax - last_[0]) / dt;
+        float jy = (ay - last_[1]) / dt;
+        float jz = (az - last_[2]) / dt;
+        jerkSquares_ += jx * jx + jy * jy + jz * jz;
+    }
+
+    last_[0] = ax;
+    last_[1] = ay;
+    last_[2] = az;
+    samples_++;
+}
+
+/**
+ * Close the window: score it, learn from it and start the next one
+ * Returns the z-score, the larger of the RMS and jerk scores, or 0
+ * while the baseline is still being learned or the window was empty.
+ */
+float MotionActivityScorer::endWindow() {
+    if (samples_ == 0) {
+        return 0.0f;
+    }
+
+    // Window mean, and whether it repeats the previous window's
+    float mean[3];
+    bool repeated = lastMeanSet_;
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        mean[axis] = rest_[axis] + sum_[axis] / samples_;
+        if (fabsf(mean[axis] - lastMean_[axis]) > restTolerance_) {
+            repeated = false;
+        }
+    }
+
+    // Move the rest vector by offset, before scoring when the hive has
+    // settled at a new rest and after it otherwise. The squares are
+    // shifted with sum((d - o)^2) = sum(d^2) - 2 o.sum(d) + n o^2.
+    float offset[3];
+    float weight = repeated ? 1.0f : restAlpha_;
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        offset[axis] = weight * (mean[axis] - rest_[axis]);
+    }
+    if (repeated) {
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            sumSquares_ += offset[axis] * (samples_ * offset[axis] - 2.0f * sum_[axis]);
+        }
+    }
+
+    rms_ = sqrtf(fmaxf(sumSquares_, 0.0f) / samples_);
+    jerk_ = (samples_ > 1) ? sqrtf(jerkSquares_ / (samples_ - 1)) : 0.0f;
+    float logRms = logf(fmaxf(rms_, MOTION_RMS_FLOOR));
+    float logJerk = logf(fmaxf(jerk_, MOTION_JERK_FLOOR));
+
+    zScore_ = 0.0f;
+    if (isReady()) {
+        float rmsZ = (logRms - rmsBaseline_.mean()) /
+                     fmaxf(rmsBaseline_.standardDeviation(), minStdDev_);
+        float jerkZ = (logJerk - jerkBaseline_.mean()) /
+                      fmaxf(jerkBaseline_.standardDeviation(), minStdDev_);
+        zScore_ = fmaxf(rmsZ, jerkZ);
+    }
+
+    if (!isReady() || zScore_ < learnLimit_) {
+        rmsBaseline_.addSample(logRms);
+        jerkBaseline_.addSample(logJerk);
+    }
+
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        rest_[axis] += offset[axis];
+        lastMean_[axis] = mean[axis];
+        sum_[axis] = 0.0f;
+    }
+    lastMeanSet_ = true;
+    sumSquares_ = 0.0f;
+    jerkSquares_ = 0.0f;
+    samples_ = 0;
+    return zScore_;
+}
+
+/**
+ * Forget the rest vector, the baselines and the window in progress
+ */
+void MotionActivityScorer::reset() {
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        rest_[axis] = 0.0f;
+        lastMean_[axis] = 0.0f;
+        last_[axis] = 0.0f;
+        sum_[axis] = 0.0f;
+    }
+    restSet_ = false;
+    lastMeanSet_ = false;
+    sumSquares_ = 0.0f;
+    jerkSquares_ = 0.0f;
+    samples_ = 0;
+    rms_ = 0.0f;
+    jerk_ = 0.0f;
+    zScore_ = 0.0f;
+    rmsBaseline_.reset();
+    jerkBaseline_.reset();
+}
+
+/**
+ * Get the dynamic acceleration RMS of the last window (g)
+ */
+float MotionActivityScorer::rms() const {
+    return rms_;
+}
+
+/**
+ * Get the jerk RMS of the last window (g/s)
+ */
+float MotionActivityScorer::jerk() const {
+    return jerk_;
+}
+
+/**
+ * Get the z-score of the last window
+ */
+float MotionActivityScorer::zScore() const {
+    return zScore_;
+}
+
+/**
+ * Check whether enough windows have been seen to score against
+ */
+bool MotionActivityScorer::isReady() const {
+    return rmsBaseline_.count() >= minWindows_;
+}
+
+/**
+ * Get the mean and standard deviation of the activity RMS (g) that the
+ * log-unit baseline describes, taking the RMS as log-normal
+ */
+void MotionActivityScorer::typicalActivity(float* mean, float* stdDev) const {
+    float logVar = rmsBaseline_.variance();
+    *mean = expf(rmsBaseline_.mean() + 0.5f * logVar);
+    *stdDev = *mean * sqrtf(expm1f(logVar));
+}
+
+/**
+ * Write the learned rest vector and baselines to a record section
+ */
+void MotionActivityScorer::serialize(RecordWriter* out) const {
+    out->putFloats(rest_, 3);
+    out->putFloats(lastMean_, 3);
+    out->putU8(restSet_ ? 1 : 0);
+    out->putU8(lastMeanSet_ ? 1 : 0);
+    out->putReserved(2);
+    rmsBaseline_.serialize(out);
+    jerkBaseline_.serialize(out);
+}
+
+/**
+ * Read the learned rest vector and baselines from a record section
+ * The tunables and the window in progress are left as they are.
+ */
+void MotionActivityScorer::deserialize(RecordReader* in) {
+    in->getFloats(rest_, 3);
+    in->getFloats(lastMean_, 3);
+    restSet_ = in->getU8() != 0;
+    lastMeanSet_ = in->getU8() != 0;
+    in->skip(2);
+    rmsBaseline_.deserialize(in);
+    jerkBaseline_.deserialize(in);
+}
\ No newline at end of file
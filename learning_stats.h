@@ -0,0 +1,255 @@
+/**
+ * Hive Monitor System - Learning Statistics Header
+ *
+ * Header file for the streaming statistics used by the adaptive
+ * learning module. These classes avoid Arduino dependencies so they
+ * can also be built for host-side tools.
+ */
+
+#ifndef LEARNING_STATS_H
+#define LEARNING_STATS_H
+
+#include <stdint.h>
+#include "record_sections.h"
+
+// Exponentially weighted mean and variance with a configurable half-life.
+// Updates are O(1) and never need periodic resets: old samples fade out
+// continuously. Early samples use a 1/n weight so the first estimates
+// match the exact running mean instead of being biased toward zero.
+class EWStats {
+public:
+    EWStats() : alpha_(0.0f), mean_(0.0f), var_(0.0f), count_(0) {}
+
+    void setHalfLife(float halfLifeSamples);
+    void addSample(float value);
+    void reset();
+    void setStats(float mean, float stdDev);
+    void serialize(RecordWriter* out) const;
+    void deserialize(RecordReader* in);
+
+    float mean() const;
+    float variance() const;
+    float standardDeviation() const;
+    uint16_t count() const;
+
+private:
+    float alpha_;     // Per-sample weight of the newest value
+    float mean_;      // Weighted mean
+    float var_;       // Weighted (population) variance
+    uint16_t count_;  // Samples seen, saturating
+};
+
+// Largest number of features in one EWStatsBlock
+#define EW_BLOCK_MAX_FEATURES 10
+
+// Exponentially weighted statistics for a block of features that all
+// receive a sample at the same time, stored as a structure of arrays.
+// Results are identical to one EWStats per feature, but the 1/n warm-up
+// weight is computed with a single divide per sample and the per-feature
+// loop has no branches, so the compiler can vectorize it on hosts that
+// update many colonies. Features restored with setStats() count as fully
+// warmed up, exactly as EWStats::setStats does.
+class EWStatsBlock {
+public:
+    EWStatsBlock() : size_(0), count_(0) {}
+
+    void init(uint8_t features);
+    void setHalfLife(uint8_t feature, float halfLifeSamples);
+    void addSample(const float* values);
+    void reset();
+    void setStats(uint8_t feature, float mean, float stdDev);
+
+    float mean(uint8_t feature) const;
+    float variance(uint8_t feature) const;
+    float standardDeviation(uint8_t feature) const;
+    uint16_t count(uint8_t feature) const;
+    uint8_t size() const;
+
+private:
+    void updateFloor(uint8_t feature);
+
+    uint8_t size_;                           // Features in use
+    uint16_t count_;                         // Samples since reset, saturating
+    float alpha_[EW_BLOCK_MAX_FEATURES];     // Per-sample weight of the newest value
+    float counting_[EW_BLOCK_MAX_FEATURES];  // 1 while the 1/n weight applies, 0 once restored
+    float floor_[EW_BLOCK_MAX_FEATURES];     // Smallest weight: alpha, or 1/UINT16_MAX if restored
+    float mean_[EW_BLOCK_MAX_FEATURES];      // Weighted means
+    float var_[EW_BLOCK_MAX_FEATURES];       // Weighted (population) variances
+};
+
+// Markers in a quantile sketch: min, low/2, low, median, high, (1+high)/2, max
+#define QUANTILE_MARKERS 7
+
+// Streaming quantile estimator (extended P-squared algorithm).
+// Tracks a low percentile, the median and a high percentile in fixed
+// memory with O(1) work per sample and no stored samples. Marker
+// positions are halved once the count passes the horizon, so older
+// samples gradually lose weight and the sketch follows seasonal drift.
+class QuantileSketch {
+public:
+    QuantileSketch() : lowQuantile_(0.0f), highQuantile_(1.0f), horizon_(0), count_(0) {}
+
+    void init(float lowQuantile, float highQuantile, uint16_t horizonSamples);
+    void addSample(float value);
+    void reset();
+    void serialize(RecordWriter* out) const;
+    void deserialize(RecordReader* in);
+
+    float low() const;
+    float median() const;
+    float high() const;
+    uint16_t count() const;
+
+private:
+    float targetQuantile(uint8_t marker) const;
+    float heightAt(uint8_t marker) const;
+
+    float lowQuantile_;                   // Low percentile tracked (e.g. 0.01)
+    float highQuantile_;                  // High percentile tracked (e.g. 0.99)
+    uint16_t horizon_;                    // Sample weight at which positions are halved
+    uint16_t count_;                      // Samples seen, saturating
+    float heights_[QUANTILE_MARKERS];     // Marker heights (quantile estimates)
+    float positions_[QUANTILE_MARKERS];   // Marker positions (1-based ranks)
+};
+
+// Brood-nest thermoregulation tracker. A queenright colony with brood
+// holds the nest at 34-35 degC and damps outside swings; losing that is
+// an early sign of a broodless or queenless colony. Each series is split
+// into a sub-hour band (variance around a fast mean) and a diurnal band
+// (variance of the fast mean around a slow one). The score combines how
+// close the nest is to the target with how strongly it attenuates the
+// ambient swings, falling back to the nest's own stability while the
+// ambient series is flat or missing. O(1) work and 72 bytes of state.
+class ThermoregulationTracker {
+public:
+    ThermoregulationTracker() : target_(0.0f), tolerance_(1.0f) {}
+
+    void init(float fastHalfLife, float slowHalfLife, float target, float tolerance);
+    void addSample(float broodTemp, float ambientTemp);
+    void reset();
+    void serialize(RecordWriter* out) const;
+    void deserialize(RecordReader* in);
+
+    float score() const;
+    float broodStdDev() const;
+    float attenuation() const;
+    uint16_t count() const;
+
+private:
+    float target_;          // Nest temperature with brood (degC)
+    float tolerance_;       // Deviation from target that is still regulated (degC)
+    EWStats broodFast_;     // Nest level and sub-hour variance
+    EWStats broodSlow_;     // Nest daily level and diurnal variance
+    EWStats ambientFast_;   // Ambient level and sub-hour variance
+    EWStats ambientSlow_;   // Ambient daily level and diurnal variance
+};
+
+// One day's hive weight metrics, emitted at the midnight rollover
+typedef struct {
+    uint32_t dayStart;     // Unix time of the day's midnight
+    uint16_t samples;      // Readings seen during the day
+    float openWeight;      // First reading of the day (kg)
+    float closeWeight;     // Last reading of the day (kg)
+    float minWeight;       // Lowest reading (kg)
+    float maxWeight;       // Highest reading (kg)
+    uint32_t minTime;      // Unix time of the lowest reading
+    uint32_t maxTime;      // Unix time of the highest reading
+    float dawnWeight;      // First reading at or after dawn (kg), NAN if none
+    uint32_t dawnTime;     // Unix time of the dawn reading, 0 if none
+    float duskWeight;      // First reading at or after dusk (kg), NAN if none
+    uint32_t duskTime;     // Unix time of the dusk reading, 0 if none
+    float dailyGain;       // Close minus open (kg)
+    float overnightLoss;   // Previous dusk minus dawn, consumption (kg), NAN if unknown
+    float departureDip;    // Dawn minus the low while foragers leave (kg), NAN if unknown
+    float netFlow;         // Dusk minus dawn, the day's nectar flow (kg), NAN if unknown
+} DailyWeightSummary;
+
+// Streaming per-day hive weight analyzer. Each reading updates the
+// day's open, close, extremes and the first readings after dawn and
+// dusk; the first reading of a new day closes the previous one into a
+// DailyWeightSummary. Overnight loss needs yesterday's dusk reading,
+// which is the only state carried between days besides an EW average
+// of the daily range. No stored samples and about 100 bytes of state.
+class DailyWeightAnalyzer {
+public:
+    DailyWeightAnalyzer() : dawnSecond_(0), duskSecond_(0), departureSeconds_(0) {}
+
+    void init(uint8_t dawnHour, uint8_t duskHour, uint8_t departureHours,
+              float rangeHalfLifeDays);
+    bool addSample(uint32_t time, float weight, DailyWeightSummary* completed);
+    void reset();
+    void serialize(RecordWriter* out) const;
+    void deserialize(RecordReader* in);
+
+    float typicalRange() const;
+    uint16_t days() const;
+
+private:
+    void startDay(uint32_t dayStart);
+    void finishDay(DailyWeightSummary* completed);
+
+    uint32_t dawnSecond_;        // Dawn as seconds after midnight
+    uint32_t duskSecond_;        // Dusk as seconds after midnight
+    uint32_t departureSeconds_;  // Window after dawn searched for the departure dip
+    DailyWeightSummary today_;   // Day in progress (derived fields unset)
+    float departureLow_;         // Lowest reading in the departure window (kg)
+    float previousDusk_;         // Yesterday's dusk reading (kg), NAN if none
+    EWStats dailyRange_;         // Daily max minus min (kg), one sample per day
+};
+
+// Streaming motion activity scorer. Gravity is removed with a rest
+// vector learned from earlier windows, so a static hive reads near zero
+// whatever its attitude, and each window of accelerometer samples is
+// reduced to the RMS of the remaining acceleration and of its jerk.
+// The rest vector follows the window means slowly, and jumps to a new
+// mean when two consecutive windows agree on it, so a hive lifted
+// during a window scores high while one set down at a new angle only
+// does so once.
+// Both are scored in log units against per-hive EW baselines; windows
+// scoring above the learning limit are kept out of the baselines so a
+// disturbance does not teach itself as normal. O(1) work per sample
+// and about 130 bytes of state, of which the rest vector and the
+// baselines are persisted; the tunables come from init().
+class MotionActivityScorer {
+public:
+    MotionActivityScorer() : restAlpha_(1.0f), restTolerance_(0.0f), minStdDev_(0.1f),
+                             learnLimit_(0.0f), minWindows_(1) { reset(); }
+
+    void init(float restHalfLife, float restTolerance, float baselineHalfLife,
+              float minStdDev, float learnLimit, uint16_t minWindows);
+    void addSample(float ax, float ay, float az, float dt);
+    float endWindow();
+    void reset();
+
+    float rms() const;
+    float jerk() const;
+    float zScore() const;
+    bool isReady() const;
+    void typicalActivity(float* mean, float* stdDev) const;
+
+    void serialize(RecordWriter* out) const;
+    void deserialize(RecordReader* in);
+
+private:
+    float restAlpha_;        // Per-window weight of the newest rest estimate
+    float restTolerance_;    // Window means closer than this are the same rest (g)
+    float minStdDev_;        // Floor on the baseline spread (log units)
+    float learnLimit_;       // Windows scoring above this do not train the baseline
+    uint16_t minWindows_;    // Windows before z-scores are reported
+    float rest_[3];          // Learned rest acceleration (g)
+    bool restSet_;           // Rest vector learned or seeded
+    float lastMean_[3];      // Mean of the previous window (g)
+    bool lastMeanSet_;       // A window has been closed
+    float last_[3];          // Previous sample, for the jerk (g)
+    float sum_[3];           // Window sum of acceleration minus rest (g)
+    float sumSquares_;       // Window sum of squared acceleration minus rest (g^2)
+    float jerkSquares_;      // Window sum of squared jerk ((g/s)^2)
+    uint16_t samples_;       // Samples in the window
+    float rms_;              // Dynamic acceleration RMS of the last window (g)
+    float jerk_;             // Jerk RMS of the last window (g/s)
+    float zScore_;           // Score of the last window
+    EWStats rmsBaseline_;    // log(rms) across windows
+    EWStats jerkBaseline_;   // log(jerk) across windows
+};
+
+#endif // LEARNING_STATS_H
\ No newline at end of file
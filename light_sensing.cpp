@@ -11,12 +11,167 @@
 #include <Wire.h>
 #include <Adafruit_APDS9960.h>
 
+// APDS-9960 registers used directly (not in the library)
+#define APDS9960_ADDRESS      0x39
+#define APDS9960_ENABLE       0x80
+#define APDS9960_ATIME        0x81
+#define APDS9960_WTIME        0x83
+#define APDS9960_PERS         0x8C
+
+#define APDS9960_ENABLE_WEN   0x08  // ENABLE: wait between cycles
+#define APDS9960_CYCLE_MS     2.78f // ATIME and WTIME step
+#define APDS9960_CYCLE_COUNTS 1025  // Clear channel full scale per integration cycle
+
+// Gain times integration cycles of the setting LIGHT_LUX_PER_COUNT
+// refers to (the library default of 4x gain and 11.1 ms)
+#define LIGHT_REFERENCE_SENSITIVITY 16.0f
+
+// Gain and integration settings in order of sensitivity. The gain is
+// raised first since it costs no sensor-on time; only a dark hive
+// lengthens the integration.
+typedef struct {
+  apds9960AGain_t gain;
+  uint8_t gainFactor;   // Nominal gain
+  uint16_t cycles;      // Integration cycles of 2.78 ms
+} LightRange;
+
+static const LightRange lightRanges[] = {
+  { APDS9960_AGAIN_1X,   1,   1 },
+  { APDS9960_AGAIN_4X,   4,   1 },
+  { APDS9960_AGAIN_16X, 16,   1 },
+  { APDS9960_AGAIN_64X, 64,   1 },
+  { APDS9960_AGAIN_64X, 64,   4 },
+  { APDS9960_AGAIN_64X, 64,  16 },
+  { APDS9960_AGAIN_64X, 64,  64 },
+  { APDS9960_AGAIN_64X, 64, 256 }
+};
+
+#define NUM_LIGHT_RANGES (sizeof(lightRanges) / sizeof(lightRanges[0]))
+
 // Sensor object
 Adafruit_APDS9960 apds;
 
 // Current light data
 LightData lightData;
 
+// Setting in use (starting at the reference sensitivity) and the level
+// of the last scheduled reading, which picks the next one's setting
+uint8_t lightRange = 2;
+float lastLightLevel = NAN;
+
+// Lid state seen by the light interrupt, and the status it holds for
+// the next reading
+bool lidOpen = false;
+uint32_t lidOpenedAt = 0;
+LightStatus lightEventStatus = LIGHT_ENCLOSED;
+
+// Lid closing found by a scheduled reading rather than the interrupt
+LightEvent readingEvent;
+bool readingEventPending = false;
+
+// The last scheduled reading got colour data from the sensor
+bool lightReadingValid = false;
+
+/**
+ * Read one APDS-9960 register
+ */
+static uint8_t readAPDS9960Register(uint8_t reg) {
+  Wire.beginTransmission(APDS9960_ADDRESS);
+  Wire.write(reg);
+  if (Wire.endTransmission(false) != 0 ||
+      Wire.requestFrom((uint8_t)APDS9960_ADDRESS, (uint8_t)1) != 1) {
+    return 0;
+  }
+  return Wire.read();
+}
+
+/**
+ * Write one APDS-9960 register
+ */
+static bool writeAPDS9960Register(uint8_t reg, uint8_t value) {
+  Wire.beginTransmission(APDS9960_ADDRESS);
+  Wire.write(reg);
+  Wire.write(value);
+  return Wire.endTransmission() == 0;
+}
+
+/**
+ * Clear channel count at which a light setting saturates
+ */
+static uint16_t getLightFullScale(uint8_t range) {
+  uint32_t fullScale = (uint32_t)APDS9960_CYCLE_COUNTS * lightRanges[range].cycles;
+  return fullScale > 0xFFFF ? 0xFFFF : (uint16_t)fullScale;
+}
+
+/**
+ * Clear channel counts per lux for a light setting
+ */
+static float getLightCountsPerLux(uint8_t range) {
+  float sensitivity = (float)lightRanges[range].gainFactor * lightRanges[range].cycles;
+  return sensitivity / (LIGHT_REFERENCE_SENSITIVITY * LIGHT_LUX_PER_COUNT);
+}
+
+/**
+ * Convert a light level to clear channel counts, kept below full scale
+ */
+static uint16_t luxToLightCounts(float lux, uint8_t range) {
+  float counts = lux * getLightCountsPerLux(range);
+  uint16_t limit = getLightFullScale(range) - 1;
+  return counts >= limit ? limit : (uint16_t)counts;
+}
+
+/**
+ * Pick the light setting for an expected light level
+ * Returns the least sensitive setting, and so the shortest integration,
+ * that reads the level with at least minCounts; the most sensitive one
+ * if none does.
+ */
+static uint8_t selectLightRange(float lux, uint16_t minCounts) {
+  for (uint8_t range = 0; range < NUM_LIGHT_RANGES; range++) {
+    if (lux * getLightCountsPerLux(range) >= minCounts) {
+      return range;
+    }
+  }
+  return NUM_LIGHT_RANGES - 1;
+}
+
+/**
+ * Switch the light sensor to a gain and integration setting
+ * Restarting the light engine discards the cycle in progress, so the
+ * next data comes from the new setting. The wait between cycles is only
+ * wanted while the interrupt watches the lid.
+ */
+static void applyLightRange(uint8_t range, bool wait) {
+  apds.enableColor(false);
+  apds.setADCGain(lightRanges[range].gain);
+  writeAPDS9960Register(APDS9960_ATIME, (uint8_t)(256 - lightRanges[range].cycles));
+  apds.enableColor(true);
+  
+  // The library rewrites ENABLE from its own copy, which has no WEN
+  uint8_t enable = readAPDS9960Register(APDS9960_ENABLE);
+  enable = wait ? (enable | APDS9960_ENABLE_WEN) : (enable & ~APDS9960_ENABLE_WEN);
+  writeAPDS9960Register(APDS9960_ENABLE, enable);
+  lightRange = range;
+}
+
+/**
+ * Wait for a completed light cycle
+ * Right after power-up or a configuration change the first integration
+ * is still running, so the data is waited for rather than skipped.
+ */
+static bool waitForColorData() {
+  unsigned long timeout = (unsigned long)(lightRanges[lightRange].cycles * APDS9960_CYCLE_MS) +
+                          LIGHT_WAIT_MS + 20;
+  unsigned long start = millis();
+  while (!apds.colorDataReady()) {
+    if (millis() - start > timeout) {
+      return false;
+    }
+    delay(5);
+  }
+  return true;
+}
+
 /**
  * Initialize light sensor
  */
@@ -27,17 +182,45 @@ bool setupLightSensor() {
     return false;
   }
   
-  // Enable light sensing
-  apds.enableColor(true);
+  // Idle between light cycles while the interrupt watches; it only
+  // needs a few readings a second and the sensor draws far less waiting
+  uint8_t waitSteps = constrain((int)lroundf(LIGHT_WAIT_MS / APDS9960_CYCLE_MS), 1, 256);
+  writeAPDS9960Register(APDS9960_WTIME, (uint8_t)(256 - waitSteps));
+  
+  // Persistence filter for the light interrupt (proximity bits kept)
+  uint8_t persistence = readAPDS9960Register(APDS9960_PERS);
+  writeAPDS9960Register(APDS9960_PERS, (persistence & 0xF0) | (LIGHT_WAKE_PERSISTENCE & 0x0F));
   
   Serial.println("APDS9960 light sensor initialized");
   return true;
 }
 
+/**
+ * Print a lid transition
+ */
+static void printLightEvent(const LightEvent& event) {
+  Serial.print("Light event: ");
+  Serial.print(getLightEventName(event.type));
+  Serial.print(" (light ");
+  Serial.print(event.level);
+  Serial.print(" lux");
+  if (event.type == LIGHT_EVENT_CLOSED) {
+    Serial.print(", open ");
+    Serial.print(event.duration);
+    Serial.print(" s");
+  }
+  Serial.println(")");
+}
+
 /**
  * Read data from light sensor
+ * The gain and integration are chosen from the previous reading. A
+ * reading that saturates, or that is too coarse while a more sensitive
+ * setting is left, is taken again up to LIGHT_RANGE_ATTEMPTS times.
  */
-void readLightSensor() {
+void readLightSensor(uint32_t time) {
+  readingEventPending = false;
+  
   // Default values
   lightData.lightLevel = 0;
   lightData.red = 0;
@@ -46,13 +229,54 @@ void readLightSensor() {
   lightData.clear = 0;
   lightData.status = LIGHT_ENCLOSED;
   
-  // Check if color data is available
-  if (apds.colorDataReady()) {
-    // Read the light sensor data
+  uint8_t range = isnan(lastLightLevel) ? lightRange
+                                        : selectLightRange(lastLightLevel, LIGHT_TARGET_COUNTS);
+  bool ready = false;
+  for (uint8_t attempt = 0; attempt < LIGHT_RANGE_ATTEMPTS; attempt++) {
+    applyLightRange(range, false);
+    ready = waitForColorData();
+    if (!ready) {
+      break;
+    }
     apds.getColorData(&lightData.red, &lightData.green, &lightData.blue, &lightData.clear);
     
-    // The clear channel provides overall brightness
-    lightData.lightLevel = lightData.clear;
+    // A saturated reading only bounds the level, so start again from
+    // the least sensitive setting
+    if (lightData.clear >= getLightFullScale(range)) {
+      if (range == 0) {
+        break;
+      }
+      range = 0;
+    } else if (lightData.clear < LIGHT_TARGET_COUNTS && range < NUM_LIGHT_RANGES - 1) {
+      range = selectLightRange(lightData.clear / getLightCountsPerLux(range), LIGHT_TARGET_COUNTS);
+    } else {
+      break;
+    }
+  }
+  
+  // Sensor-on time only while reading; the light interrupt restarts it
+  apds.enableColor(false);
+  
+  lightReadingValid = ready;
+  if (ready) {
+    // The clear channel provides overall brightness, scaled to lux so
+    // readings at different settings compare
+    lightData.lightLevel = lightData.clear / getLightCountsPerLux(lightRange);
+    lastLightLevel = lightData.lightLevel;
+    
+    // The interrupt misses the lid closing while it is not armed
+    // (critical battery, or LIGHT_EVENTS_PER_SLEEP used up), so a dark
+    // reading closes it here. It closed some time before this reading.
+    if (lidOpen && lightData.lightLevel < LIGHT_CLOSE_THRESHOLD) {
+      lidOpen = false;
+      readingEvent.type = LIGHT_EVENT_CLOSED;
+      readingEvent.time = time;
+      readingEvent.openedAt = lidOpenedAt;
+      readingEvent.duration = time - lidOpenedAt;
+      readingEvent.level = lightData.lightLevel;
+      readingEventPending = true;
+      printLightEvent(readingEvent);
+    }
     
     // Determine if lid is open based on threshold
     if (lightData.lightLevel > LIGHT_THRESHOLD) {
@@ -61,9 +285,17 @@ void readLightSensor() {
       lightData.status = LIGHT_ENCLOSED;
     }
     
+    // A lid opened since the last reading still counts for this one
+    if (lightEventStatus == LIGHT_OPEN || lidOpen) {
+      lightData.status = LIGHT_OPEN;
+    }
+    
     // Print light data
     Serial.println("Light Sensor Readings:");
-    Serial.print("Light Level: "); Serial.println(lightData.lightLevel);
+    Serial.print("Light Level: "); Serial.print(lightData.lightLevel); Serial.println(" lux");
+    Serial.print("Light Range: ");
+    Serial.print(lightRanges[lightRange].gainFactor); Serial.print("x, ");
+    Serial.print(lightRanges[lightRange].cycles * APDS9960_CYCLE_MS); Serial.println(" ms");
     Serial.print("RGBC Values: ");
     Serial.print(lightData.red); Serial.print(", ");
     Serial.print(lightData.green); Serial.print(", ");
@@ -75,6 +307,7 @@ void readLightSensor() {
   } else {
     Serial.println("Light sensor data not ready");
   }
+  lightEventStatus = LIGHT_ENCLOSED;
 }
 
 /**
@@ -91,9 +324,105 @@ LightStatus getLightStatus() {
   return lightData.status;
 }
 
+/**
+ * Check if the last scheduled reading produced a light level
+ */
+bool isLightReadingValid() {
+  return lightReadingValid;
+}
+
 /**
  * Check if the hive lid may have been removed
  */
 bool isLidRemoved() {
   return (lightData.status == LIGHT_OPEN);
+}
+
+/**
+ * Prepare the light interrupt for deep sleep
+ * While the lid is closed the interrupt fires when the light rises past
+ * LIGHT_THRESHOLD; while it is open, when the light falls below
+ * LIGHT_CLOSE_THRESHOLD. The gap between them keeps passing clouds from
+ * waking the system repeatedly. The sensor watches with the shortest
+ * integration that resolves LIGHT_CLOSE_THRESHOLD with LIGHT_WAKE_COUNTS.
+ */
+void armLightWake(bool enabled) {
+  if (!LIGHT_WAKE_ENABLE) {
+    return;
+  }
+  
+  if (enabled) {
+    uint8_t range = selectLightRange(LIGHT_CLOSE_THRESHOLD, LIGHT_WAKE_COUNTS);
+    if (lidOpen) {
+      apds.setIntLimits(luxToLightCounts(LIGHT_CLOSE_THRESHOLD, range), 0xFFFF);
+    } else {
+      apds.setIntLimits(0, luxToLightCounts(LIGHT_THRESHOLD, range));
+    }
+    apds.clearInterrupt();
+    apds.enableColorInterrupt();
+    applyLightRange(range, true);
+  } else {
+    apds.disableColorInterrupt();
+    apds.clearInterrupt();
+    apds.enableColor(false);
+  }
+}
+
+/**
+ * Classify the light change that woke the system
+ * Returns false when the light has already returned to where it was,
+ * so there is no transition to log.
+ */
+bool captureLightEvent(uint32_t time, LightEvent* event) {
+  uint16_t red, green, blue, clear;
+  if (!waitForColorData()) {
+    Serial.println("Light sensor data not ready");
+    return false;
+  }
+  apds.getColorData(&red, &green, &blue, &clear);
+  apds.clearInterrupt();
+  float level = clear / getLightCountsPerLux(lightRange);
+  
+  if (!lidOpen && level > LIGHT_THRESHOLD) {
+    lidOpen = true;
+    lidOpenedAt = time;
+    lightEventStatus = LIGHT_OPEN;
+    event->type = LIGHT_EVENT_OPENED;
+    event->duration = 0;
+  } else if (lidOpen && level < LIGHT_CLOSE_THRESHOLD) {
+    lidOpen = false;
+    event->type = LIGHT_EVENT_CLOSED;
+    event->duration = time - lidOpenedAt;
+  } else {
+    return false;
+  }
+  event->time = time;
+  event->openedAt = lidOpenedAt;
+  event->level = level;
+  
+  printLightEvent(*event);
+  return true;
+}
+
+/**
+ * Get the lid closing found by the latest scheduled reading
+ * Returns false when that reading found no transition.
+ */
+bool getReadingLightEvent(LightEvent* event) {
+  if (!readingEventPending) {
+    return false;
+  }
+  *event = readingEvent;
+  return true;
+}
+
+/**
+ * Get a light event type as a string
+ */
+const char* getLightEventName(LightEventType type) {
+  switch (type) {
+    case LIGHT_EVENT_OPENED: return "Lid opened";
+    case LIGHT_EVENT_CLOSED: return "Lid closed";
+    default: return "Unknown";
+  }
 }
\ No newline at end of file
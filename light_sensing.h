@@ -18,7 +18,7 @@ enum LightStatus {
 
 // Structure to hold light data
 typedef struct {
-  uint16_t lightLevel;  // Overall brightness
+  float lightLevel;     // Overall brightness (lux)
   uint16_t red;         // Red channel
   uint16_t green;       // Green channel
   uint16_t blue;        // Blue channel
@@ -26,11 +26,31 @@ typedef struct {
   LightStatus status;   // Current status
 } LightData;
 
+// Lid transitions caught by the light interrupt
+enum LightEventType {
+  LIGHT_EVENT_OPENED,  // Light rose past LIGHT_THRESHOLD
+  LIGHT_EVENT_CLOSED   // Light fell back below LIGHT_CLOSE_THRESHOLD
+};
+
+// Light event captured after a light interrupt
+typedef struct {
+  LightEventType type;  // Transition
+  uint32_t time;        // Unix time of the transition
+  uint32_t openedAt;    // Unix time the lid was opened
+  uint32_t duration;    // Seconds the lid was open (closing events only)
+  float level;          // Light level that triggered the event (lux)
+} LightEvent;
+
 // Function prototypes
 bool setupLightSensor();
-void readLightSensor();
+void readLightSensor(uint32_t time);
 LightData getLightData();
 LightStatus getLightStatus();
+bool isLightReadingValid();
 bool isLidRemoved();
+void armLightWake(bool enabled);
+bool captureLightEvent(uint32_t time, LightEvent* event);
+bool getReadingLightEvent(LightEvent* event);
+const char* getLightEventName(LightEventType type);
 
 #endif // LIGHT_SENSING_H
\ No newline at end of file
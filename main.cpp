@@ -29,6 +29,7 @@
 #include "weight_sensing.h"
 #include "data_logging.h"
 #include "power_management.h"
+#include "learning.h"
 
 // Pin definitions
 #define SD_CS_PIN        5
@@ -42,6 +43,10 @@ void setupSystem();
 void blinkLED(int times);
 void performMeasurementCycle();
 void logAllSensorData();
+void updateLearning();
+void sleepUntilNextWake();
+void handleMotionEvent();
+void handleLightEvent();
 
 /**
  * Setup function - runs once at startup
@@ -75,15 +80,101 @@ void loop() {
   // Take readings from all sensors
   performMeasurementCycle();
   
+  // Fuse subsystem statuses into the colony state
+  updateColonyState();
+  
+  // Trace a weight event at full HX711 rate while it is still under way,
+  // before the SD card is used this wake
+  bool weightBurstCaptured = isWeightBurstPending() && captureWeightBurst();
+  
   // Log data to SD card
   logAllSensorData();
+  if (weightBurstCaptured) {
+    logWeightBurst(getWeightBurst());
+  }
+  
+  // Feed the learning model and persist its state once per wake
+  if (ENABLE_LEARNING) {
+    updateLearning();
+  }
   
   // Enter low power sleep
   Serial.println("Entering low power sleep mode...");
   Serial.flush(); // Make sure all serial data is sent
   
   // Sleep for configured interval
-  enterSleep(WAKE_INTERVAL_MINUTES);
+  sleepUntilNextWake();
+}
+
+/**
+ * Sleep until the next scheduled wake
+ * Motion and light interrupts end the sleep early; each event is
+ * captured, classified and logged before going back to sleep for the
+ * rest of the interval. After MOTION_EVENTS_PER_SLEEP motion events (a
+ * hive being moved, a storm) or LIGHT_EVENTS_PER_SLEEP light events
+ * that source is ignored until the next scheduled wake.
+ */
+void sleepUntilNextWake() {
+  uint32_t seconds = getSleepMinutes(WAKE_INTERVAL_MINUTES) * 60UL;
+  uint32_t wakeTime = rtc.now().unixtime() + seconds;
+  uint8_t motionEvents = 0;
+  uint8_t lightEvents = 0;
+  
+  bool motionWake = MOTION_WAKE_ENABLE && getBatteryStatus() != BATTERY_CRITICAL;
+  bool lightWake = LIGHT_WAKE_ENABLE && getBatteryStatus() != BATTERY_CRITICAL;
+  armMotionWake(motionWake);
+  armLightWake(lightWake);
+  
+  uint8_t reason;
+  while ((reason = enterSleep(seconds)) != WAKE_TIMER) {
+    if (reason & WAKE_MOTION) {
+      handleMotionEvent();
+      if (++motionEvents >= MOTION_EVENTS_PER_SLEEP) {
+        Serial.println("Motion wake disabled until the next scheduled wake");
+        motionWake = false;
+      }
+    }
+    if (reason & WAKE_LIGHT) {
+      handleLightEvent();
+      if (++lightEvents >= LIGHT_EVENTS_PER_SLEEP) {
+        Serial.println("Light wake disabled until the next scheduled wake");
+        lightWake = false;
+      }
+    }
+    
+    uint32_t now = rtc.now().unixtime();
+    if (now >= wakeTime) {
+      break;
+    }
+    seconds = wakeTime - now;
+    
+    armMotionWake(motionWake);
+    armLightWake(lightWake);
+  }
+  
+  // Scheduled readings poll the light sensor instead
+  armLightWake(false);
+}
+
+/**
+ * Capture, classify and log the motion that woke the system
+ */
+void handleMotionEvent() {
+  MotionEvent event;
+  if (captureMotionEvent(&event)) {
+    logMotionEvent(rtc.now(), event);
+  }
+}
+
+/**
+ * Timestamp and log the lid opening or closing that woke the system
+ */
+void handleLightEvent() {
+  DateTime now = rtc.now();
+  LightEvent event;
+  if (captureLightEvent(now.unixtime(), &event)) {
+    logLightEvent(now, event);
+  }
 }
 
 /**
@@ -119,9 +210,24 @@ void setupSystem() {
   setupDataLogging(SD_CS_PIN, &rtc);
   setupPowerManagement();
   
+  // Hive knocks and tips wake the system straight away
+  if (MOTION_WAKE_ENABLE) {
+    enableMotionWake(MOTION_INT_PIN);
+  }
+  
+  // So does the hive lid being lifted or put back
+  if (LIGHT_WAKE_ENABLE) {
+    enableLightWake(LIGHT_INT_PIN);
+  }
+  
   // Load configuration (if available)
   loadConfigFromSD();
   
+  // Restore learned colony baseline
+  if (ENABLE_LEARNING) {
+    setupLearning();
+  }
+  
   // Initialize BLE if enabled
   if (ENABLE_BLE) {
     setupBLE();
@@ -145,11 +251,14 @@ void performMeasurementCycle() {
   // Read battery voltage first
   readBatteryVoltage();
   
+  // HX711 conversions fill in the background while the others are read
+  startWeightAcquisition();
+  
   // Read from each sensor module
   readEnvSensors();
   analyzeAudio();
   readMotionSensors();
-  readLightSensor();
+  readLightSensor(now.unixtime());
   readWeightSensor();
   
   // Print summary to serial
@@ -186,18 +295,56 @@ void logAllSensorData() {
   // Log environmental data specifically
   logEnvironmentalData(now, envData);
   
-  // Log weight data specifically
-  logWeightData(now, weight, getWeightStatus());
+  // Log weight data specifically, one file per scale
+  for (uint8_t channel = 0; channel < getWeightChannelCount(); channel++) {
+    WeightReading reading;
+    if (getWeightReading(channel, &reading)) {
+      logWeightData(now, channel, reading);
+    }
+  }
   
   // Log motion data
   logMotionData(now, motionData, getMotionStatus());
   
-  // Log light data
+  // Log light data, and a lid closing the light interrupt missed
   logLightData(now, lightData);
+  LightEvent lightEvent;
+  if (getReadingLightEvent(&lightEvent)) {
+    logLightEvent(now, lightEvent);
+  }
   
   Serial.println("Data logging complete!");
 }
 
+/**
+ * Update the learning model with this wake's readings
+ */
+void updateLearning() {
+  DateTime now = rtc.now();
+  float audioEnergy[4];
+  getAudioEnergyValues(audioEnergy);
+  
+  updateLearningModel(getEnvData(), audioEnergy, getMotionData(),
+                      getLightData(), getWeight(), getRawWeight(), now);
+  
+  // Single coalesced write; JSON only while a phone can read it
+  commitLearningState(ENABLE_BLE && Bluefruit.connected());
+}
+
+/**
+ * Get current time from the RTC (used by the learning module)
+ */
+DateTime getRTCTime() {
+  return rtc.now();
+}
+
+/**
+ * Check if the RTC is running (used by the learning module)
+ */
+bool rtcIsRunning() {
+  return rtc.initialized() && !rtc.lostPower();
+}
+
 /**
  * Blink the LED a specified number of times
  */
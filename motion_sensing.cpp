@@ -8,10 +8,34 @@
 
 #include "motion_sensing.h"
 #include "config.h"
+#include "spectrum.h"
+#include "orientation.h"
+#include "learning.h"
 #include <Wire.h>
 #include <Adafruit_LSM6DS33.h>
 #include <Adafruit_LIS3MDL.h>
 
+// LSM6DS33 registers used directly for FIFO batching (not in the library)
+#define LSM6DS33_ADDRESS          0x6A
+#define LSM6DS33_FIFO_CTRL3       0x08
+#define LSM6DS33_FIFO_CTRL5       0x0A
+#define LSM6DS33_FIFO_STATUS1     0x3A
+#define LSM6DS33_FIFO_DATA_OUT_L  0x3E
+
+#define LSM6DS33_FIFO_GYRO_XL     0x09  // FIFO_CTRL3: gyro and accelerometer, no decimation
+#define LSM6DS33_FIFO_1666HZ_FIFO 0x41  // FIFO_CTRL5: 1.66 kHz, stop when full
+#define LSM6DS33_FIFO_BYPASS      0x00  // FIFO_CTRL5: FIFO off and cleared
+#define LSM6DS33_ACCEL_G_PER_LSB  0.000061f    // At +-2 g
+#define LSM6DS33_GYRO_RAD_PER_LSB 0.00015272f  // 8.75 mdps at 250 dps
+
+// Samples per I2C burst from the FIFO (12 bytes each, within the Wire buffer)
+#define LSM6DS33_FIFO_BURST_SAMPLES 5
+
+// Burst samples averaged for the orientation alignment, and the largest
+// change between wakes (degrees) that still counts as a steady pose
+#define ORIENTATION_ALIGN_SAMPLES  16
+#define ORIENTATION_STEADY_DEGREES 2.0f
+
 // Sensor objects
 Adafruit_LSM6DS33 lsm6ds33; // Accelerometer and gyroscope
 Adafruit_LIS3MDL lis3mdl;   // Magnetometer
@@ -20,12 +44,37 @@ Adafruit_LIS3MDL lis3mdl;   // Magnetometer
 MotionData motionData;
 MotionStatus motionStatus = MOTION_NOMINAL;
 
+// Highest status of the motion events since the last reading
+MotionStatus motionEventStatus = MOTION_NOMINAL;
+bool gyroRunning = false;
+
+// FIFO burst: gyro X/Y/Z then accelerometer X/Y/Z per sample, raw
+int16_t motionBurst[MOTION_BURST_SAMPLES][6];
+
+// Comb vibration RMS in each band (g), and the FFT buffers
+float vibrationEnergy[NUM_VIBRATION_BANDS] = {0};
+float vibrationReal[MOTION_BURST_SAMPLES];
+float vibrationImag[MOTION_BURST_SAMPLES];
+
+// Orientation filter and reference pose, kept from wake to wake
+OrientationFilter orientationFilter;
+float orientationReference[4];
+float orientationPrevious[4];
+bool orientationReferenceSet = false;
+uint8_t orientationSettledWakes = 0;
+
+static void scoreMotionActivity();
+static void analyzeVibration();
+static void trackOrientation();
+
 /**
  * Initialize motion sensors
  */
 bool setupMotionSensors() {
   bool success = true;
   
+  orientationFilter.setGains(ORIENTATION_KP, ORIENTATION_KI);
+  
   // Initialize accelerometer/gyro
   if (!lsm6ds33.begin_I2C()) {
     Serial.println("Failed to find LSM6DS33 accelerometer/gyro");
@@ -40,6 +89,14 @@ bool setupMotionSensors() {
     // Configure gyro
     lsm6ds33.setGyroRange(LSM6DS_GYRO_RANGE_250_DPS);
     lsm6ds33.setGyroDataRate(LSM6DS_RATE_52_HZ);
+    gyroRunning = true;
+    
+    // Wake-up interrupt on high-passed acceleration, routed to INT1
+    if (MOTION_WAKE_ENABLE) {
+      uint8_t threshold = constrain((int)lroundf(MOTION_WAKE_THRESHOLD * 32.0f), 1, 63);
+      lsm6ds33.enableWakeup(true, MOTION_WAKE_DURATION, threshold);
+      lsm6ds33.configInt1(false, false, false, false, true);
+    }
   }
   
   // Initialize magnetometer
@@ -63,6 +120,13 @@ bool setupMotionSensors() {
  * Read data from motion sensors
  */
 void readMotionSensors() {
+  // The gyro is shut down while asleep
+  if (!gyroRunning) {
+    lsm6ds33.setGyroDataRate(LSM6DS_RATE_52_HZ);
+    gyroRunning = true;
+    delay(LSM6DS_GYRO_TURN_ON_MS);
+  }
+  
   // Clear previous data
   motionData.accelX = 0.0f;
   motionData.accelY = 0.0f;
@@ -73,6 +137,11 @@ void readMotionSensors() {
   motionData.magX = 0.0f;
   motionData.magY = 0.0f;
   motionData.magZ = 0.0f;
+  motionData.tilt = 0.0f;
+  motionData.heading = 0.0f;
+  motionData.activity = 0.0f;
+  motionData.jerk = 0.0f;
+  motionData.activityScore = 0.0f;
   
   // Read accelerometer and gyroscope
   sensors_event_t accel;
@@ -103,22 +172,42 @@ void readMotionSensors() {
     Serial.println("Failed to read magnetometer");
   }
   
-  // Calculate motion magnitude
-  float motionMagnitude = sqrt(motionData.accelX * motionData.accelX + 
-                              motionData.accelY * motionData.accelY + 
-                              motionData.accelZ * motionData.accelZ);
+  // Activity, comb vibration and orientation from a high-rate FIFO capture
+  captureMotionBurst();
   
-  // Classify motion status based on magnitude
-  if (motionMagnitude > MOTION_ALERT_THRESHOLD) {
+  // Classify against the hive's learned activity once there is one,
+  // and against fixed levels until then
+  bool alert, warning;
+  if (isMotionActivityLearned()) {
+    alert = motionData.activityScore > MOTION_ALERT_ZSCORE;
+    warning = motionData.activityScore > MOTION_WARNING_ZSCORE;
+  } else {
+    alert = motionData.activity > MOTION_ALERT_THRESHOLD;
+    warning = motionData.activity > MOTION_WARNING_THRESHOLD;
+  }
+  
+  if (alert) {
     motionStatus = MOTION_ALERT;
     Serial.println("Motion ALERT detected!");
-  } else if (motionMagnitude > MOTION_WARNING_THRESHOLD) {
+  } else if (warning) {
     motionStatus = MOTION_WARNING;
     Serial.println("Motion warning detected");
   } else {
     motionStatus = MOTION_NOMINAL;
   }
   
+  // A hive tilted or turned since the reference may be being moved
+  if (hasOrientationChanged()) {
+    motionStatus = MOTION_ALERT;
+    Serial.println("Orientation change detected!");
+  }
+  
+  // Events caught between readings still count for this one
+  if (motionEventStatus > motionStatus) {
+    motionStatus = motionEventStatus;
+  }
+  motionEventStatus = MOTION_NOMINAL;
+  
   // Print motion data
   Serial.println("Motion Sensor Readings:");
   Serial.print("Accel X/Y/Z (G): ");
@@ -161,13 +250,370 @@ MotionStatus getMotionStatus() {
 
 /**
  * Check for significant orientation change
+ * Compares the latest fused orientation with the reference pose, so
+ * the hive being turned on its stand or carried off counts as well as
+ * it being tilted.
  */
 bool hasOrientationChanged() {
-  // Check if Z acceleration has changed significantly from ~1G
-  // which would indicate the hive has been tilted
-  if (abs(motionData.accelZ - 1.0f) > 0.3f) {
-    return true;
+  if (!orientationReferenceSet) {
+    return false;
   }
   
-  return false;
+  return motionData.tilt > ORIENTATION_TILT_THRESHOLD ||
+         fabsf(motionData.heading) > ORIENTATION_HEADING_THRESHOLD;
+}
+
+/**
+ * Prepare the motion sensors for deep sleep
+ * The gyro draws most of the LSM6DS33's current, so it is shut down;
+ * the accelerometer keeps running to drive the wake-up interrupt.
+ */
+void armMotionWake(bool enabled) {
+  lsm6ds33.setGyroDataRate(LSM6DS_RATE_SHUTDOWN);
+  gyroRunning = false;
+  
+  if (MOTION_WAKE_ENABLE) {
+    uint8_t threshold = constrain((int)lroundf(MOTION_WAKE_THRESHOLD * 32.0f), 1, 63);
+    lsm6ds33.enableWakeup(enabled, MOTION_WAKE_DURATION, threshold);
+  }
+}
+
+/**
+ * Capture and classify the motion that triggered a wake-up interrupt
+ * Records MOTION_EVENT_SAMPLES accelerometer samples, then compares
+ * the settled orientation (last quarter of the capture) with the
+ * orientation at the last scheduled reading.
+ */
+bool captureMotionEvent(MotionEvent* event) {
+  float peak = 0.0f;
+  float sumSquares = 0.0f;
+  float settledX = 0.0f, settledY = 0.0f, settledZ = 0.0f;
+  int captured = 0;
+  int settledCount = 0;
+  
+  for (int i = 0; i < MOTION_EVENT_SAMPLES; i++) {
+    sensors_event_t accel;
+    sensors_event_t gyro;
+    sensors_event_t temp;
+    if (lsm6ds33.getEvent(&accel, &gyro, &temp)) {
+      float x = accel.acceleration.x / 9.8f;
+      float y = accel.acceleration.y / 9.8f;
+      float z = accel.acceleration.z / 9.8f;
+      float deviation = fabsf(sqrtf(x * x + y * y + z * z) - 1.0f);
+      peak = fmaxf(peak, deviation);
+      sumSquares += deviation * deviation;
+      captured++;
+      
+      if (i >= MOTION_EVENT_SAMPLES * 3 / 4) {
+        settledX += x;
+        settledY += y;
+        settledZ += z;
+        settledCount++;
+      }
+    }
+    delay(1000 / LSM6DS_ACCEL_RATE_HZ);
+  }
+  
+  if (captured == 0) {
+    Serial.println("Failed to read accelerometer for motion event");
+    return false;
+  }
+  
+  event->peak = peak;
+  event->rms = sqrtf(sumSquares / captured);
+  
+  // Angle between the settled and the previously read gravity vectors
+  event->tilt = 0.0f;
+  float previous = sqrtf(motionData.accelX * motionData.accelX +
+                         motionData.accelY * motionData.accelY +
+                         motionData.accelZ * motionData.accelZ);
+  float settled = sqrtf(settledX * settledX + settledY * settledY + settledZ * settledZ);
+  if (settledCount > 0 && previous > 0.0f && settled > 0.0f) {
+    float cosine = (settledX * motionData.accelX + settledY * motionData.accelY +
+                    settledZ * motionData.accelZ) / (settled * previous);
+    event->tilt = acosf(constrain(cosine, -1.0f, 1.0f)) * 180.0f / PI;
+  }
+  
+  // Classify, and hold the status for the next scheduled reading
+  MotionStatus status;
+  if (event->tilt > MOTION_TILT_THRESHOLD) {
+    event->type = MOTION_EVENT_TIPPED;
+    status = MOTION_ALERT;
+  } else if (event->peak > MOTION_IMPACT_THRESHOLD) {
+    event->type = MOTION_EVENT_IMPACT;
+    status = MOTION_ALERT;
+  } else {
+    event->type = MOTION_EVENT_DISTURBANCE;
+    status = MOTION_WARNING;
+  }
+  if (status > motionEventStatus) {
+    motionEventStatus = status;
+  }
+  
+  Serial.print("Motion event: ");
+  Serial.print(getMotionEventName(event->type));
+  Serial.print(" (peak ");
+  Serial.print(event->peak, 2);
+  Serial.print(" g, tilt ");
+  Serial.print(event->tilt, 1);
+  Serial.println(" deg)");
+  return true;
+}
+
+/**
+ * Get the name of a motion event type
+ */
+const char* getMotionEventName(MotionEventType type) {
+  switch (type) {
+    case MOTION_EVENT_DISTURBANCE: return "Disturbance";
+    case MOTION_EVENT_IMPACT: return "Impact";
+    case MOTION_EVENT_TIPPED: return "Tipped";
+    default: return "Unknown";
+  }
+}
+
+/**
+ * Write one LSM6DS33 register
+ */
+static bool writeLSM6DS33Register(uint8_t reg, uint8_t value) {
+  Wire.beginTransmission(LSM6DS33_ADDRESS);
+  Wire.write(reg);
+  Wire.write(value);
+  return Wire.endTransmission() == 0;
+}
+
+/**
+ * Read consecutive LSM6DS33 registers in one I2C transaction
+ * Reads starting at FIFO_DATA_OUT_L keep returning FIFO words, so a
+ * burst drains several samples at once.
+ */
+static bool readLSM6DS33Registers(uint8_t reg, uint8_t* buffer, uint8_t length) {
+  Wire.beginTransmission(LSM6DS33_ADDRESS);
+  Wire.write(reg);
+  if (Wire.endTransmission(false) != 0) {
+    return false;
+  }
+  if (Wire.requestFrom((uint8_t)LSM6DS33_ADDRESS, length) != length) {
+    return false;
+  }
+  for (uint8_t i = 0; i < length; i++) {
+    buffer[i] = Wire.read();
+  }
+  return true;
+}
+
+/**
+ * Capture a burst of accelerometer and gyro samples through the FIFO
+ * Both run at 1.66 kHz into the LSM6DS33 FIFO while the CPU idles, then
+ * the window is drained in multi-sample I2C bursts and handed to the
+ * activity scorer, the vibration analysis and the orientation filter.
+ * Per-sample polling would need a status and a data read for every
+ * sample with the CPU awake throughout the window.
+ */
+bool captureMotionBurst() {
+  // Clear the FIFO, then batch gyro and accelerometer samples at 1.66 kHz
+  lsm6ds33.setAccelDataRate(LSM6DS_RATE_1_66K_HZ);
+  lsm6ds33.setGyroDataRate(LSM6DS_RATE_1_66K_HZ);
+  writeLSM6DS33Register(LSM6DS33_FIFO_CTRL5, LSM6DS33_FIFO_BYPASS);
+  writeLSM6DS33Register(LSM6DS33_FIFO_CTRL3, LSM6DS33_FIFO_GYRO_XL);
+  writeLSM6DS33Register(LSM6DS33_FIFO_CTRL5, LSM6DS33_FIFO_1666HZ_FIFO);
+  
+  delay((unsigned long)(MOTION_BURST_SAMPLES * 1000.0f / MOTION_BURST_RATE_HZ) + 10);
+  
+  unsigned long drainStart = micros();
+  uint16_t transactions = 0;
+  
+  // Unread 16-bit words, six per sample
+  uint8_t status[2];
+  uint16_t available = 0;
+  if (readLSM6DS33Registers(LSM6DS33_FIFO_STATUS1, status, 2)) {
+    available = (status[0] | ((status[1] & 0x0F) << 8)) / 6;
+  }
+  transactions++;
+  
+  uint16_t count = (available < MOTION_BURST_SAMPLES) ? available : MOTION_BURST_SAMPLES;
+  uint16_t read = 0;
+  while (read < count) {
+    uint8_t samples = count - read;
+    if (samples > LSM6DS33_FIFO_BURST_SAMPLES) {
+      samples = LSM6DS33_FIFO_BURST_SAMPLES;
+    }
+    uint8_t bytes[LSM6DS33_FIFO_BURST_SAMPLES * 12];
+    transactions++;
+    if (!readLSM6DS33Registers(LSM6DS33_FIFO_DATA_OUT_L, bytes, samples * 12)) {
+      break;
+    }
+    for (uint8_t i = 0; i < samples; i++) {
+      for (uint8_t word = 0; word < 6; word++) {
+        motionBurst[read + i][word] = (int16_t)(bytes[i * 12 + word * 2] |
+                                                (bytes[i * 12 + word * 2 + 1] << 8));
+      }
+    }
+    read += samples;
+  }
+  unsigned long drainTime = micros() - drainStart;
+  
+  // Back to the low-rate accelerometer that drives the wake-up interrupt
+  writeLSM6DS33Register(LSM6DS33_FIFO_CTRL5, LSM6DS33_FIFO_BYPASS);
+  lsm6ds33.setAccelDataRate(LSM6DS_RATE_52_HZ);
+  lsm6ds33.setGyroDataRate(LSM6DS_RATE_52_HZ);
+  
+  Serial.print("Motion burst: ");
+  Serial.print(read);
+  Serial.print(" samples in ");
+  Serial.print(transactions);
+  Serial.print(" I2C reads, drain ");
+  Serial.print(drainTime);
+  Serial.println(" us");
+  
+  if (read < MOTION_BURST_SAMPLES) {
+    Serial.println("Motion burst short, skipping analysis");
+    return false;
+  }
+  
+  scoreMotionActivity();
+  if (VIBRATION_ENABLE) {
+    analyzeVibration();
+  }
+  if (ORIENTATION_ENABLE) {
+    trackOrientation();
+  }
+  return true;
+}
+
+/**
+ * Score the burst's motion activity against the learned baseline
+ * The baseline is part of the learning model, so it is saved with the
+ * rest of the learned state.
+ */
+static void scoreMotionActivity() {
+  const float dt = 1.0f / MOTION_BURST_RATE_HZ;
+  for (uint16_t i = 0; i < MOTION_BURST_SAMPLES; i++) {
+    addMotionActivitySample(motionBurst[i][3] * LSM6DS33_ACCEL_G_PER_LSB,
+                            motionBurst[i][4] * LSM6DS33_ACCEL_G_PER_LSB,
+                            motionBurst[i][5] * LSM6DS33_ACCEL_G_PER_LSB, dt);
+  }
+  motionData.activityScore = endMotionActivityWindow(&motionData.activity, &motionData.jerk);
+  
+  Serial.print("Motion activity: ");
+  Serial.print(motionData.activity * 1000.0f, 2);
+  Serial.print(" mg RMS, jerk ");
+  Serial.print(motionData.jerk, 2);
+  Serial.print(" g/s");
+  if (isMotionActivityLearned()) {
+    Serial.print(", z ");
+    Serial.print(motionData.activityScore, 2);
+  }
+  Serial.println();
+}
+
+/**
+ * Reduce the burst to comb vibration band energies
+ * Each accelerometer axis is analysed separately; the bands hold the
+ * RMS over all three axes.
+ */
+static void analyzeVibration() {
+  unsigned long analysisStart = micros();
+  static const float bandEdges[NUM_VIBRATION_BANDS + 1] = VIBRATION_BAND_EDGES;
+  float power[NUM_VIBRATION_BANDS] = {0};
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    for (uint16_t i = 0; i < MOTION_BURST_SAMPLES; i++) {
+      vibrationReal[i] = motionBurst[i][3 + axis] * LSM6DS33_ACCEL_G_PER_LSB;
+    }
+    float energy[NUM_VIBRATION_BANDS];
+    computeBandEnergy(vibrationReal, vibrationImag, MOTION_BURST_SAMPLES, MOTION_BURST_RATE_HZ,
+                      bandEdges, NUM_VIBRATION_BANDS, energy);
+    for (uint8_t band = 0; band < NUM_VIBRATION_BANDS; band++) {
+      power[band] += energy[band] * energy[band];
+    }
+  }
+  for (uint8_t band = 0; band < NUM_VIBRATION_BANDS; band++) {
+    vibrationEnergy[band] = sqrtf(power[band]);
+  }
+  unsigned long analysisTime = micros() - analysisStart;
+  
+  Serial.print("Vibration (mg RMS): ");
+  for (uint8_t band = 0; band < NUM_VIBRATION_BANDS; band++) {
+    Serial.print(vibrationEnergy[band] * 1000.0f, 2);
+    Serial.print((band + 1 < NUM_VIBRATION_BANDS) ? ", " : "");
+  }
+  Serial.print(" (");
+  Serial.print(analysisTime);
+  Serial.println(" us)");
+}
+
+/**
+ * Run the orientation filter over the burst
+ * The filter is aligned to gravity and the magnetic field, then every
+ * burst sample is fused with the latest magnetometer reading. Tilt and
+ * heading are measured from the reference orientation, which is taken
+ * on the first wake and moved to a new pose once the hive has sat
+ * steadily in it for ORIENTATION_SETTLE_WAKES wakes.
+ */
+static void trackOrientation() {
+  unsigned long fusionStart = micros();
+  
+  // Align on the mean of the first samples to average out vibration
+  float ax = 0.0f, ay = 0.0f, az = 0.0f;
+  for (uint8_t i = 0; i < ORIENTATION_ALIGN_SAMPLES; i++) {
+    ax += motionBurst[i][3];
+    ay += motionBurst[i][4];
+    az += motionBurst[i][5];
+  }
+  if (!orientationFilter.align(ax, ay, az, motionData.magX, motionData.magY, motionData.magZ)) {
+    Serial.println("Orientation alignment failed");
+    return;
+  }
+  
+  const float dt = 1.0f / MOTION_BURST_RATE_HZ;
+  for (uint16_t i = 0; i < MOTION_BURST_SAMPLES; i++) {
+    orientationFilter.update(motionBurst[i][0] * LSM6DS33_GYRO_RAD_PER_LSB,
+                             motionBurst[i][1] * LSM6DS33_GYRO_RAD_PER_LSB,
+                             motionBurst[i][2] * LSM6DS33_GYRO_RAD_PER_LSB,
+                             motionBurst[i][3], motionBurst[i][4], motionBurst[i][5],
+                             motionData.magX, motionData.magY, motionData.magZ, dt);
+  }
+  unsigned long fusionTime = micros() - fusionStart;
+  
+  float current[4];
+  orientationFilter.quaternion(current);
+  if (!orientationReferenceSet) {
+    memcpy(orientationReference, current, sizeof(orientationReference));
+    memcpy(orientationPrevious, current, sizeof(orientationPrevious));
+    orientationReferenceSet = true;
+  }
+  
+  motionData.tilt = orientationFilter.tiltFrom(orientationReference);
+  motionData.heading = orientationFilter.headingChangeFrom(orientationReference);
+  
+  // Adopt a new pose once it has held steady for long enough
+  bool steady = orientationFilter.tiltFrom(orientationPrevious) < ORIENTATION_STEADY_DEGREES &&
+                fabsf(orientationFilter.headingChangeFrom(orientationPrevious)) < ORIENTATION_STEADY_DEGREES;
+  if (hasOrientationChanged() && steady) {
+    if (++orientationSettledWakes >= ORIENTATION_SETTLE_WAKES) {
+      memcpy(orientationReference, current, sizeof(orientationReference));
+      orientationSettledWakes = 0;
+      Serial.println("Orientation reference moved to the current pose");
+    }
+  } else {
+    orientationSettledWakes = 0;
+  }
+  memcpy(orientationPrevious, current, sizeof(orientationPrevious));
+  
+  Serial.print("Orientation: tilt ");
+  Serial.print(motionData.tilt, 1);
+  Serial.print(" deg, heading ");
+  Serial.print(motionData.heading, 1);
+  Serial.print(" deg (");
+  Serial.print(fusionTime);
+  Serial.println(" us)");
+}
+
+/**
+ * Get the comb vibration RMS in each band (g)
+ */
+void getVibrationEnergyValues(float* energyValues) {
+  for (int i = 0; i < NUM_VIBRATION_BANDS; i++) {
+    energyValues[i] = vibrationEnergy[i];
+  }
 }
\ No newline at end of file
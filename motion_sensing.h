@@ -21,6 +21,11 @@ typedef struct {
   float magX;     // X-axis magnetic field in uT
   float magY;     // Y-axis magnetic field in uT
   float magZ;     // Z-axis magnetic field in uT
+  float tilt;     // Tilt from the reference orientation in degrees
+  float heading;  // Heading change from the reference in degrees (+ anticlockwise)
+  float activity; // Acceleration RMS with gravity removed in G
+  float jerk;     // Jerk RMS in G per second
+  float activityScore;  // Activity z-score against the learned baseline
 } MotionData;
 
 // Motion status enumeration
@@ -30,11 +35,42 @@ enum MotionStatus {
   MOTION_ALERT     // Significant movement or impact
 };
 
+// Kinds of motion event caught by the wake-up interrupt
+enum MotionEventType {
+  MOTION_EVENT_DISTURBANCE,  // Knock or vibration, hive still upright
+  MOTION_EVENT_IMPACT,       // Hard knock
+  MOTION_EVENT_TIPPED        // Hive left at a different angle
+};
+
+// Motion event captured after a wake-up interrupt
+typedef struct {
+  MotionEventType type;  // Classification
+  float peak;            // Largest deviation of |a| from 1 g (g)
+  float rms;             // RMS deviation of |a| from 1 g (g)
+  float tilt;            // Settled orientation change since the last reading (degrees)
+} MotionEvent;
+
+// Accelerometer data rate and gyro turn-on time
+#define LSM6DS_ACCEL_RATE_HZ   52
+#define LSM6DS_GYRO_TURN_ON_MS 80
+
+// FIFO burst rate, shared by vibration and orientation.
+// Vibration bands:
+// V1 20-100 Hz (shaking signals, handling), V2 100-250 Hz (fanning, hum),
+// V3 250-550 Hz (whooping, piping), V4 550-800 Hz (piping harmonics)
+#define MOTION_BURST_RATE_HZ   1666.0f
+#define NUM_VIBRATION_BANDS    4
+
 // Function prototypes
 bool setupMotionSensors();
 void readMotionSensors();
 MotionData getMotionData();
 MotionStatus getMotionStatus();
 bool hasOrientationChanged();
+void armMotionWake(bool enabled);
+bool captureMotionEvent(MotionEvent* event);
+const char* getMotionEventName(MotionEventType type);
+bool captureMotionBurst();
+void getVibrationEnergyValues(float* energyValues);
 
 #endif // MOTION_SENSING_H
\ No newline at end of file
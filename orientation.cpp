@@ -0,0 +1,226 @@
+/**
+ * Hive Monitor System - Orientation Module
+ *
+ * Quaternion orientation from the 9-DoF sensors. The filter is started
+ * from an accelerometer and magnetometer alignment and then refined by
+ * a burst of gyro-integrated updates, so a static hive converges within
+ * one wake; the gyro bias estimate is carried from wake to wake.
+ */
+
+#include "orientation.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/**
+ * Reset to the identity orientation and forget the gyro bias
+ */
+void OrientationFilter::reset() {
+    q_[0] = 1.0f;
+    q_[1] = 0.0f;
+    q_[2] = 0.0f;
+    q_[3] = 0.0f;
+    kp_ = 1.0f;
+    ki_ = 0.0f;
+    bias_[0] = 0.0f;
+    bias_[1] = 0.0f;
+    bias_[2] = 0.0f;
+}
+
+/**
+ * Set the proportional and integral feedback gains
+ */
+void OrientationFilter::setGains(float kp, float ki) {
+    kp_ = kp;
+    ki_ = ki;
+}
+
+/**
+ * Set the orientation directly from gravity and the magnetic field
+ * Builds the north-west-up axes in body coordinates and converts the
+ * rotation matrix to a quaternion. Returns false, leaving the estimate
+ * unchanged, if either vector is zero or they are parallel.
+ */
+bool OrientationFilter::align(float ax, float ay, float az, float mx, float my, float mz) {
+    float an = sqrtf(ax * ax + ay * ay + az * az);
+    if (an <= 0.0f) {
+        return false;
+    }
+    float ux = ax / an, uy = ay / an, uz = az / an;
+
+    // West = up x magnetic field, north = west x up
+    float wx = uy * mz - uz * my;
+    float wy = uz * mx - ux * mz;
+    float wz = ux * my - uy * mx;
+    float wn = sqrtf(wx * wx + wy * wy + wz * wz);
+    if (wn <= 1e-6f * sqrtf(mx * mx + my * my + mz * mz) || wn <= 0.0f) {
+        return false;
+    }
+    wx /= wn; wy /= wn; wz /= wn;
+    float nx = wy * uz - wz * uy;
+    float ny = wz * ux - wx * uz;
+    float nz = wx * uy - wy * ux;
+
+    // Rows of the body-to-earth matrix are the earth axes in body frame
+    float r00 = nx, r01 = ny, r02 = nz;
+    float r10 = wx, r11 = wy, r12 = wz;
+    float r20 = ux, r21 = uy, r22 = uz;
+
+    float trace = r00 + r11 + r22;
+    if (trace > 0.0f) {
+        float s = 2.0f * sqrtf(1.0f + trace);
+        q_[0] = 0.25f * s;
+        q_[1] = (r21 - r12) / s;
+        q_[2] = (r02 - r20) / s;
+        q_[3] = (r10 - r01) / s;
+    } else if (r00 > r11 && r00 > r22) {
+        float s = 2.0f * sqrtf(1.0f + r00 - r11 - r22);
+        q_[0] = (r21 - r12) / s;
+        q_[1] = 0.25f * s;
+        q_[2] = (r01 + r10) / s;
+        q_[3] = (r02 + r20) / s;
+    } else if (r11 > r22) {
+        float s = 2.0f * sqrtf(1.0f + r11 - r00 - r22);
+        q_[0] = (r02 - r20) / s;
+        q_[1] = (r01 + r10) / s;
+        q_[2] = 0.25f * s;
+        q_[3] = (r12 + r21) / s;
+    } else {
+        float s = 2.0f * sqrtf(1.0f + r22 - r00 - r11);
+        q_[0] = (r10 - r01) / s;
+        q_[1] = (r02 + r20) / s;
+        q_[2] = (r12 + r21) / s;
+        q_[3] = 0.25f * s;
+    }
+    return true;
+}
+
+/**
+ * Advance the estimate by one sample
+ * Gyro in rad/s, accelerometer and magnetometer in any units (only
+ * their directions are used), dt in seconds. A zero magnetometer
+ * vector falls back to gravity-only correction, which leaves heading
+ * to the gyro.
+ */
+void OrientationFilter::update(float gx, float gy, float gz, float ax, float ay, float az,
+                               float mx, float my, float mz, float dt) {
+    float q0 = q_[0], q1 = q_[1], q2 = q_[2], q3 = q_[3];
+
+    float an = sqrtf(ax * ax + ay * ay + az * az);
+    if (an > 0.0f) {
+        ax /= an; ay /= an; az /= an;
+
+        // Gravity direction predicted by the estimate (halved)
+        float vx = q1 * q3 - q0 * q2;
+        float vy = q0 * q1 + q2 * q3;
+        float vz = q0 * q0 - 0.5f + q3 * q3;
+
+        // Error is the cross product of measured and predicted directions
+        float ex = ay * vz - az * vy;
+        float ey = az * vx - ax * vz;
+        float ez = ax * vy - ay * vx;
+
+        float mn = sqrtf(mx * mx + my * my + mz * mz);
+        if (mn > 0.0f) {
+            mx /= mn; my /= mn; mz /= mn;
+
+            // Field in the earth frame, flattened onto north and up
+            float hx = 2.0f * (mx * (0.5f - q2 * q2 - q3 * q3) + my * (q1 * q2 - q0 * q3) +
+                               mz * (q1 * q3 + q0 * q2));
+            float hy = 2.0f * (mx * (q1 * q2 + q0 * q3) + my * (0.5f - q1 * q1 - q3 * q3) +
+                               mz * (q2 * q3 - q0 * q1));
+            float bx = sqrtf(hx * hx + hy * hy);
+            float bz = 2.0f * (mx * (q1 * q3 - q0 * q2) + my * (q2 * q3 + q0 * q1) +
+                               mz * (0.5f - q1 * q1 - q2 * q2));
+
+            // Field direction predicted by the estimate (halved)
+            float wx = bx * (0.5f - q2 * q2 - q3 * q3) + bz * (q1 * q3 - q0 * q2);
+            float wy = bx * (q1 * q2 - q0 * q3) + bz * (q0 * q1 + q2 * q3);
+            float wz = bx * (q0 * q2 + q1 * q3) + bz * (0.5f - q1 * q1 - q2 * q2);
+
+            ex += my * wz - mz * wy;
+            ey += mz * wx - mx * wz;
+            ez += mx * wy - my * wx;
+        }
+
+        if (ki_ > 0.0f) {
+            bias_[0] += 2.0f * ki_ * ex * dt;
+            bias_[1] += 2.0f * ki_ * ey * dt;
+            bias_[2] += 2.0f * ki_ * ez * dt;
+        }
+        gx += 2.0f * kp_ * ex;
+        gy += 2.0f * kp_ * ey;
+        gz += 2.0f * kp_ * ez;
+    }
+    gx += bias_[0];
+    gy += bias_[1];
+    gz += bias_[2];
+
+    // Integrate the quaternion rate
+    gx *= 0.5f * dt;
+    gy *= 0.5f * dt;
+    gz *= 0.5f * dt;
+    q_[0] = q0 + (-q1 * gx - q2 * gy - q3 * gz);
+    q_[1] = q1 + (q0 * gx + q2 * gz - q3 * gy);
+    q_[2] = q2 + (q0 * gy - q1 * gz + q3 * gx);
+    q_[3] = q3 + (q0 * gz + q1 * gy - q2 * gx);
+
+    float qn = sqrtf(q_[0] * q_[0] + q_[1] * q_[1] + q_[2] * q_[2] + q_[3] * q_[3]);
+    q_[0] /= qn;
+    q_[1] /= qn;
+    q_[2] /= qn;
+    q_[3] /= qn;
+}
+
+/**
+ * Get the current orientation quaternion (w, x, y, z)
+ */
+void OrientationFilter::quaternion(float q[4]) const {
+    q[0] = q_[0];
+    q[1] = q_[1];
+    q[2] = q_[2];
+    q[3] = q_[3];
+}
+
+/**
+ * Angle between the up direction now and at a reference orientation
+ * Compares the earth's up axis as seen from the body, so turning about
+ * the vertical does not count as tilt. Degrees, 0-180.
+ */
+float OrientationFilter::tiltFrom(const float reference[4]) const {
+    const float* q = q_;
+    const float* r = reference;
+    float ux = 2.0f * (q[1] * q[3] - q[0] * q[2]);
+    float uy = 2.0f * (q[2] * q[3] + q[0] * q[1]);
+    float uz = 1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2]);
+    float rx = 2.0f * (r[1] * r[3] - r[0] * r[2]);
+    float ry = 2.0f * (r[2] * r[3] + r[0] * r[1]);
+    float rz = 1.0f - 2.0f * (r[1] * r[1] + r[2] * r[2]);
+
+    float cosine = ux * rx + uy * ry + uz * rz;
+    if (cosine > 1.0f) cosine = 1.0f;
+    if (cosine < -1.0f) cosine = -1.0f;
+    return acosf(cosine) * (float)(180.0 / M_PI);
+}
+
+/**
+ * Change in heading since a reference orientation
+ * Heading is the compass direction of the body x axis projected onto
+ * the horizontal; positive is anticlockwise seen from above. Degrees,
+ * -180 to 180.
+ */
+float OrientationFilter::headingChangeFrom(const float reference[4]) const {
+    const float* q = q_;
+    const float* r = reference;
+    float heading = atan2f(2.0f * (q[1] * q[2] + q[0] * q[3]),
+                           1.0f - 2.0f * (q[2] * q[2] + q[3] * q[3]));
+    float referenceHeading = atan2f(2.0f * (r[1] * r[2] + r[0] * r[3]),
+                                    1.0f - 2.0f * (r[2] * r[2] + r[3] * r[3]));
+
+    float change = (heading - referenceHeading) * (float)(180.0 / M_PI);
+    if (change > 180.0f) change -= 360.0f;
+    if (change < -180.0f) change += 360.0f;
+    return change;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+/**
+ * Hive Monitor System - Orientation Header
+ *
+ * Header file for the quaternion orientation filter that fuses the
+ * gyro, accelerometer and magnetometer. Readings come in as plain
+ * float vectors, the gyro in rad/s and the others in any unit since
+ * they are normalised, so the filter does not depend on the driver.
+ */
+
+#ifndef ORIENTATION_H
+#define ORIENTATION_H
+
+#include <stdint.h>
+
+// Mahony complementary filter on the unit quaternion. The earth frame
+// is north-west-up; the proportional term pulls the estimate toward the
+// measured gravity and magnetic north, the integral term learns the
+// gyro bias. Each update is a fixed ~150 flops with one square root
+// per normalisation, so a FIFO burst of any length costs a known time.
+class OrientationFilter {
+public:
+    OrientationFilter() { reset(); }
+
+    void reset();
+    void setGains(float kp, float ki);
+    bool align(float ax, float ay, float az, float mx, float my, float mz);
+    void update(float gx, float gy, float gz, float ax, float ay, float az,
+                float mx, float my, float mz, float dt);
+
+    void quaternion(float q[4]) const;
+    float tiltFrom(const float reference[4]) const;
+    float headingChangeFrom(const float reference[4]) const;
+
+private:
+    float q_[4];         // Body-to-earth rotation (w, x, y, z)
+    float kp_;           // Proportional gain (1/s)
+    float ki_;           // Integral gain (1/s^2)
+    float bias_[3];      // Integral feedback, the negated gyro bias (rad/s)
+};
+
+#endif // ORIENTATION_H
\ No newline at end of file
@@ -7,13 +7,32 @@
 
 #include "power_management.h"
 #include "config.h"
+#include "weight_sensing.h"
 #include <Arduino.h>
+#include <Wire.h>
 #include <ArduinoLowPower.h>
 
 // Battery variables
 float batteryVoltage = 0.0f;
 BatteryStatus batteryStatus = BATTERY_NORMAL;
 
+// WAKE_* flags raised by wake interrupts during the current sleep
+volatile uint8_t wakeFlags = WAKE_TIMER;
+
+/**
+ * Motion interrupt while asleep
+ */
+static void motionWakeISR() {
+  wakeFlags |= WAKE_MOTION;
+}
+
+/**
+ * Light interrupt while asleep
+ */
+static void lightWakeISR() {
+  wakeFlags |= WAKE_LIGHT;
+}
+
 /**
  * Initialize power management
  */
@@ -88,9 +107,9 @@ BatteryStatus getBatteryStatus() {
 }
 
 /**
- * Enter sleep mode for power conservation
+ * Sleep interval adjusted for the battery state
  */
-void enterSleep(uint16_t minutes) {
+uint16_t getSleepMinutes(uint16_t minutes) {
   // If battery is low, extend sleep time to conserve power
   uint16_t sleepMinutes = minutes;
   
@@ -106,27 +125,59 @@ void enterSleep(uint16_t minutes) {
     Serial.println(" minutes");
   }
   
-  // Calculate sleep time in milliseconds
-  uint32_t sleepTime = sleepMinutes * 60 * 1000;
-  
+  return sleepMinutes;
+}
+
+/**
+ * Enter deep sleep for power conservation
+ * Returns WAKE_TIMER when the interval elapsed, otherwise the WAKE_*
+ * flags of the interrupts that ended the sleep early.
+ */
+uint8_t enterSleep(uint32_t seconds) {
   // Make sure all peripherals are powered down
   powerDownPeripherals();
   
   // Enter deep sleep
   Serial.print("Entering deep sleep for ");
-  Serial.print(sleepMinutes);
-  Serial.println(" minutes...");
+  Serial.print(seconds);
+  Serial.println(" s...");
   
   Serial.flush(); // Make sure all serial data is sent
   
   // Use low power library to put device into deep sleep
-  LowPower.deepSleep(sleepTime);
+  wakeFlags = WAKE_TIMER;
+  LowPower.deepSleep(seconds * 1000UL);
+  
+  noInterrupts();
+  uint8_t reason = wakeFlags;
+  wakeFlags = WAKE_TIMER;
+  interrupts();
   
   // Code will continue from here after waking
-  Serial.println("Waking from deep sleep");
+  Serial.println((reason == WAKE_TIMER) ? "Waking from deep sleep" :
+                                          "Woken early by sensor interrupt");
   
   // Power up peripherals
   powerUpPeripherals();
+  
+  return reason;
+}
+
+/**
+ * Let a motion interrupt (rising edge) end deep sleep early
+ */
+void enableMotionWake(uint8_t pin) {
+  pinMode(pin, INPUT);
+  LowPower.attachInterruptWakeup(pin, motionWakeISR, RISING);
+}
+
+/**
+ * Let a light interrupt end deep sleep early
+ * The APDS-9960 INT output is open drain and active low.
+ */
+void enableLightWake(uint8_t pin) {
+  pinMode(pin, INPUT_PULLUP);
+  LowPower.attachInterruptWakeup(pin, lightWakeISR, FALLING);
 }
 
 /**
@@ -145,6 +196,9 @@ void powerDownPeripherals() {
   // Disable sensors via I2C
   Wire.end();
   
+  // Stop the HX711s converting all night
+  setWeightSensorPower(false);
+  
   // Disable unused pins
   if (ENABLE_STATUS_LED) {
     pinMode(LED_PIN, INPUT);
@@ -158,6 +212,9 @@ void powerUpPeripherals() {
   // Re-initialize I2C
   Wire.begin();
   
+  // Power the HX711s back up; they settle during the first conversion
+  setWeightSensorPower(true);
+  
   // Set up LED pin
   if (ENABLE_STATUS_LED) {
     pinMode(LED_PIN, OUTPUT);
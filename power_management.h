@@ -17,6 +17,11 @@ enum BatteryStatus {
   BATTERY_CRITICAL  // Critical battery, extreme power saving
 };
 
+// Wake reasons reported by enterSleep (bit flags)
+#define WAKE_TIMER   0x00  // Sleep interval elapsed
+#define WAKE_MOTION  0x01  // Accelerometer motion interrupt
+#define WAKE_LIGHT   0x02  // Light sensor threshold interrupt
+
 // Pin definitions
 #define VBAT_PIN A7
 #define LED_PIN  13
@@ -31,7 +36,10 @@ void setupPowerManagement();
 void readBatteryVoltage();
 float getBatteryVoltage();
 BatteryStatus getBatteryStatus();
-void enterSleep(uint16_t minutes);
+uint16_t getSleepMinutes(uint16_t minutes);
+uint8_t enterSleep(uint32_t seconds);
+void enableMotionWake(uint8_t pin);
+void enableLightWake(uint8_t pin);
 void powerDownPeripherals();
 void powerUpPeripherals();
 
@@ -0,0 +1,251 @@
+/**
+ * Hive Monitor System - Record Sections Module
+ *
+ * Tagged-section payload encoding and CRC-32 for records kept by the
+ * record store. Each section is [tag u8][length u16 LE][bytes], so a
+ * reader can skip sections it does not know and keep defaults for
+ * sections that are missing. RecordWriter and RecordReader encode the
+ * fields inside a section one at a time.
+ */
+
+#include "record_sections.h"
+#include <string.h>
+
+// CRC-32 (IEEE 802.3, reflected) nibble table - 64 bytes of flash
+static const uint32_t crcTable[16] = {
+  0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL,
+  0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+  0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL,
+  0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL
+};
+
+/**
+ * Update a running CRC-32 with a block of data
+ * Start with crc = 0; the pre/post inversion is handled internally.
+ */
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length) {
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc = crcTable[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+    crc = crcTable[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+/**
+ * Find a tagged section in a payload buffer
+ */
+const uint8_t* recordFindSection(const uint8_t* buffer, uint16_t length,
+                                 uint8_t tag, uint16_t* sectionLength) {
+  uint16_t offset = 0;
+  while ((uint32_t)offset + SECTION_HEADER_SIZE <= length) {
+    uint16_t size = buffer[offset + 1] | (buffer[offset + 2] << 8);
+    if ((uint32_t)offset + SECTION_HEADER_SIZE + size > length) {
+      break;
+    }
+
+    if (buffer[offset] == tag) {
+      *sectionLength = size;
+      return buffer + offset + SECTION_HEADER_SIZE;
+    }
+    offset += SECTION_HEADER_SIZE + size;
+  }
+  return NULL;
+}
+
+/**
+ * Start writing a record payload into a buffer
+ */
+RecordWriter::RecordWriter(uint8_t* buffer, uint16_t capacity)
+    : buffer_(buffer), capacity_(capacity), length_(0), sectionStart_(0), valid_(true) {}
+
+/**
+ * Make room for count bytes, or mark the record invalid
+ */
+bool RecordWriter::reserve(uint16_t count) {
+  if (!valid_ || (uint32_t)length_ + count > capacity_) {
+    valid_ = false;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Open a section; its length is filled in by endSection()
+ */
+void RecordWriter::beginSection(uint8_t tag) {
+  if (!reserve(SECTION_HEADER_SIZE)) {
+    return;
+  }
+  sectionStart_ = length_;
+  buffer_[length_] = tag;
+  length_ += SECTION_HEADER_SIZE;
+}
+
+/**
+ * Close the open section
+ */
+void RecordWriter::endSection() {
+  if (!valid_) {
+    return;
+  }
+  uint16_t size = length_ - sectionStart_ - SECTION_HEADER_SIZE;
+  buffer_[sectionStart_ + 1] = size & 0xFF;
+  buffer_[sectionStart_ + 2] = size >> 8;
+}
+
+/**
+ * Write an unsigned byte
+ */
+void RecordWriter::putU8(uint8_t value) {
+  if (reserve(1)) {
+    buffer_[length_++] = value;
+  }
+}
+
+/**
+ * Write a 16-bit unsigned value
+ */
+void RecordWriter::putU16(uint16_t value) {
+  if (reserve(2)) {
+    buffer_[length_++] = value & 0xFF;
+    buffer_[length_++] = value >> 8;
+  }
+}
+
+/**
+ * Write a 32-bit unsigned value
+ */
+void RecordWriter::putU32(uint32_t value) {
+  if (reserve(4)) {
+    for (uint8_t i = 0; i < 4; i++) {
+      buffer_[length_++] = (value >> (8 * i)) & 0xFF;
+    }
+  }
+}
+
+/**
+ * Write an IEEE 754 single-precision value
+ */
+void RecordWriter::putFloat(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  putU32(bits);
+}
+
+/**
+ * Write an array of floats
+ */
+void RecordWriter::putFloats(const float* values, uint16_t count) {
+  for (uint16_t i = 0; i < count; i++) {
+    putFloat(values[i]);
+  }
+}
+
+/**
+ * Write zero bytes reserved for alignment or later use
+ */
+void RecordWriter::putReserved(uint16_t count) {
+  for (uint16_t i = 0; i < count; i++) {
+    putU8(0);
+  }
+}
+
+/**
+ * Get the payload length written so far
+ */
+uint16_t RecordWriter::length() const {
+  return length_;
+}
+
+/**
+ * Check that everything written so far fitted
+ */
+bool RecordWriter::isValid() const {
+  return valid_;
+}
+
+/**
+ * Start reading a section found by recordFindSection()
+ */
+RecordReader::RecordReader(const uint8_t* data, uint16_t length)
+    : data_(data), length_(length), offset_(0), overrun_(false) {}
+
+/**
+ * Check that count more bytes are left, or mark the section overrun
+ */
+bool RecordReader::take(uint16_t count) {
+  if (overrun_ || (uint32_t)offset_ + count > length_) {
+    overrun_ = true;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Read an unsigned byte
+ */
+uint8_t RecordReader::getU8() {
+  return take(1) ? data_[offset_++] : 0;
+}
+
+/**
+ * Read a 16-bit unsigned value
+ */
+uint16_t RecordReader::getU16() {
+  if (!take(2)) {
+    return 0;
+  }
+  uint16_t value = data_[offset_] | (data_[offset_ + 1] << 8);
+  offset_ += 2;
+  return value;
+}
+
+/**
+ * Read a 32-bit unsigned value
+ */
+uint32_t RecordReader::getU32() {
+  if (!take(4)) {
+    return 0;
+  }
+  uint32_t value = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    value |= (uint32_t)data_[offset_++] << (8 * i);
+  }
+  return value;
+}
+
+/**
+ * Read an IEEE 754 single-precision value
+ */
+float RecordReader::getFloat() {
+  uint32_t bits = getU32();
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/**
+ * Read an array of floats
+ */
+void RecordReader::getFloats(float* values, uint16_t count) {
+  for (uint16_t i = 0; i < count; i++) {
+    values[i] = getFloat();
+  }
+}
+
+/**
+ * Skip reserved bytes
+ */
+void RecordReader::skip(uint16_t count) {
+  if (take(count)) {
+    offset_ += count;
+  }
+}
+
+/**
+ * Check that the section was read exactly to its end
+ */
+bool RecordReader::isComplete() const {
+  return !overrun_ && offset_ == length_;
+}
\ No newline at end of file
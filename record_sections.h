@@ -0,0 +1,82 @@
+/**
+ * Hive Monitor System - Record Sections Header
+ *
+ * Header file for the tagged-section payload format and CRC used by the
+ * record store. Kept free of Arduino and SD dependencies so host-side
+ * tools can read and write the same records.
+ */
+
+#ifndef RECORD_SECTIONS_H
+#define RECORD_SECTIONS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Section header inside a payload: 1 byte tag + 2 byte length
+#define SECTION_HEADER_SIZE 3
+
+// Function prototypes
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length);
+
+// Tagged sections inside a record payload ([tag][length][bytes]...),
+// written with RecordWriter
+const uint8_t* recordFindSection(const uint8_t* buffer, uint16_t length,
+                                 uint8_t tag, uint16_t* sectionLength);
+
+// Writes tagged sections field by field, little endian, so a record's
+// layout is fixed by the code that writes it rather than by how the
+// compiler lays out a class. Once anything does not fit, nothing more is
+// written and isValid() turns false.
+class RecordWriter {
+public:
+  RecordWriter(uint8_t* buffer, uint16_t capacity);
+
+  void beginSection(uint8_t tag);
+  void endSection();
+
+  void putU8(uint8_t value);
+  void putU16(uint16_t value);
+  void putU32(uint32_t value);
+  void putFloat(float value);
+  void putFloats(const float* values, uint16_t count);
+  void putReserved(uint16_t count);
+
+  uint16_t length() const;
+  bool isValid() const;
+
+private:
+  bool reserve(uint16_t count);
+
+  uint8_t* buffer_;        // Record payload
+  uint16_t capacity_;      // Payload buffer size
+  uint16_t length_;        // Bytes written
+  uint16_t sectionStart_;  // Offset of the open section's header
+  bool valid_;             // Everything written so far fitted
+};
+
+// Reads one section's fields in the order they were written. Reading
+// past the end yields zeros and marks the section incomplete; a section
+// is only trusted if it was read exactly to its end.
+class RecordReader {
+public:
+  RecordReader(const uint8_t* data, uint16_t length);
+
+  uint8_t getU8();
+  uint16_t getU16();
+  uint32_t getU32();
+  float getFloat();
+  void getFloats(float* values, uint16_t count);
+  void skip(uint16_t count);
+
+  bool isComplete() const;
+
+private:
+  bool take(uint16_t count);
+
+  const uint8_t* data_;    // Section bytes
+  uint16_t length_;        // Section length
+  uint16_t offset_;        // Bytes read
+  bool overrun_;           // A read went past the end
+};
+
+#endif // RECORD_SECTIONS_H
\ No newline at end of file
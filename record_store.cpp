@@ -0,0 +1,179 @@
+/**
+ * Hive Monitor System - Record Store Module
+ *
+ * This module implements a two-slot (A/B) record store on the SD card.
+ * Records are written alternately into two fixed-size slots at fixed
+ * offsets, each prefixed by a header with version, sequence number,
+ * length and CRC. Loading reads only the two headers and the payload
+ * of the newest valid slot, so boot time does not grow with uptime.
+ */
+
+#include "record_store.h"
+#include <SD.h>
+
+// Open mode for in-place updates. FILE_WRITE includes O_APPEND, which
+// would force every write to the end of the file.
+#define RECORD_FILE_MODE (O_READ | O_WRITE | O_CREAT)
+
+/**
+ * Compute the CRC stored in a slot header
+ */
+static uint32_t recordCrc(const RecordHeader* header, const uint8_t* data) {
+  uint32_t crc = 0;
+  crc = crc32Update(crc, (const uint8_t*)&header->version, sizeof(header->version));
+  crc = crc32Update(crc, (const uint8_t*)&header->length, sizeof(header->length));
+  crc = crc32Update(crc, (const uint8_t*)&header->sequence, sizeof(header->sequence));
+  return crc32Update(crc, data, header->length);
+}
+
+/**
+ * Initialize a record store handle
+ */
+void recordStoreInit(RecordStore* store, const char* filename, uint16_t slotSize) {
+  store->filename = filename;
+  store->slotSize = slotSize;
+  store->sequence = 0;
+  store->activeSlot = -1;
+}
+
+/**
+ * Get the maximum payload size of a slot
+ */
+uint16_t recordStoreCapacity(const RecordStore* store) {
+  return store->slotSize - sizeof(RecordHeader);
+}
+
+/**
+ * Read a slot header, returning false if the slot is absent or malformed
+ */
+static bool readSlotHeader(File& file, const RecordStore* store, uint8_t slot,
+                           RecordHeader* header) {
+  uint32_t offset = (uint32_t)slot * store->slotSize;
+  if (file.size() < offset + sizeof(RecordHeader) || !file.seek(offset)) {
+    return false;
+  }
+
+  if (file.read((uint8_t*)header, sizeof(RecordHeader)) != sizeof(RecordHeader)) {
+    return false;
+  }
+
+  return header->magic == RECORD_STORE_MAGIC &&
+         header->length <= recordStoreCapacity(store);
+}
+
+/**
+ * Load the newest valid record
+ * Only the two headers and one payload are read; if the newest payload
+ * fails its CRC (torn write), the older slot is used instead.
+ */
+bool recordStoreLoad(RecordStore* store, uint16_t* version,
+                     uint8_t* data, uint16_t maxLength, uint16_t* length) {
+  store->activeSlot = -1;
+  store->sequence = 0;
+
+  if (!SD.exists(store->filename)) {
+    return false;
+  }
+
+  File file = SD.open(store->filename, FILE_READ);
+  if (!file) {
+    Serial.print("Failed to open record file: ");
+    Serial.println(store->filename);
+    return false;
+  }
+
+  RecordHeader headers[RECORD_STORE_SLOTS];
+  bool present[RECORD_STORE_SLOTS];
+  for (uint8_t slot = 0; slot < RECORD_STORE_SLOTS; slot++) {
+    present[slot] = readSlotHeader(file, store, slot, &headers[slot]);
+
+    // Never reuse a sequence number, even from a damaged slot
+    if (present[slot] && (int32_t)(headers[slot].sequence - store->sequence) > 0) {
+      store->sequence = headers[slot].sequence;
+    }
+  }
+
+  // Newest slot first (wrap-safe sequence comparison)
+  uint8_t order[RECORD_STORE_SLOTS] = {0, 1};
+  if (present[1] && (!present[0] ||
+      (int32_t)(headers[1].sequence - headers[0].sequence) > 0)) {
+    order[0] = 1;
+    order[1] = 0;
+  }
+
+  for (uint8_t i = 0; i < RECORD_STORE_SLOTS; i++) {
+    uint8_t slot = order[i];
+    const RecordHeader* header = &headers[slot];
+    if (!present[slot] || header->length > maxLength) {
+      continue;
+    }
+
+    file.seek((uint32_t)slot * store->slotSize + sizeof(RecordHeader));
+    if (file.read(data, header->length) != header->length ||
+        recordCrc(header, data) != header->crc) {
+      Serial.print("Record slot ");
+      Serial.print(slot);
+      Serial.println(" failed CRC check");
+      continue;
+    }
+
+    *version = header->version;
+    *length = header->length;
+    store->activeSlot = slot;
+    file.close();
+    return true;
+  }
+
+  file.close();
+  return false;
+}
+
+/**
+ * Save a record into the slot not holding the newest valid record
+ */
+bool recordStoreSave(RecordStore* store, uint16_t version,
+                     const uint8_t* data, uint16_t length) {
+  if (length > recordStoreCapacity(store)) {
+    Serial.println("Record too large for slot");
+    return false;
+  }
+
+  uint8_t slot = (store->activeSlot == 0) ? 1 : 0;
+  uint32_t offset = (uint32_t)slot * store->slotSize;
+
+  RecordHeader header;
+  header.magic = RECORD_STORE_MAGIC;
+  header.version = version;
+  header.length = length;
+  header.sequence = store->sequence + 1;
+  header.crc = recordCrc(&header, data);
+
+  File file = SD.open(store->filename, RECORD_FILE_MODE);
+  if (!file) {
+    Serial.print("Failed to open record file for writing: ");
+    Serial.println(store->filename);
+    return false;
+  }
+
+  // Pad a new file so the second slot sits at its fixed offset
+  if (file.size() < offset) {
+    file.seek(file.size());
+    while (file.size() < offset) {
+      file.write((uint8_t)0);
+    }
+  }
+
+  bool ok = file.seek(offset) &&
+            file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+            file.write(data, length) == length;
+  file.close();
+
+  if (!ok) {
+    Serial.println("Failed to write record slot");
+    return false;
+  }
+
+  store->activeSlot = slot;
+  store->sequence = header.sequence;
+  return true;
+}
\ No newline at end of file
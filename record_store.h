@@ -0,0 +1,44 @@
+/**
+ * Hive Monitor System - Record Store Header
+ *
+ * Header file for the fixed-slot record store that keeps small binary
+ * state records on the SD card. Each file holds two slots (A/B) that are
+ * overwritten in place alternately, so the file size stays constant and
+ * an interrupted write never destroys the last good record.
+ */
+
+#ifndef RECORD_STORE_H
+#define RECORD_STORE_H
+
+#include <Arduino.h>
+#include "record_sections.h"
+
+#define RECORD_STORE_MAGIC   0x52564948UL  // "HIVR" in little-endian
+#define RECORD_STORE_SLOTS   2             // A/B slots per file
+
+// Header written at the start of every slot
+typedef struct {
+  uint32_t magic;     // RECORD_STORE_MAGIC
+  uint16_t version;   // Payload format version (owned by the caller)
+  uint16_t length;    // Payload length in bytes
+  uint32_t sequence;  // Monotonic write counter, newest slot wins
+  uint32_t crc;       // CRC-32 over version, length, sequence and payload
+} RecordHeader;
+
+// Handle for one record file
+typedef struct {
+  const char* filename;  // File on the SD card
+  uint16_t slotSize;     // Bytes reserved per slot, including the header
+  uint32_t sequence;     // Sequence number of the newest valid record
+  int8_t activeSlot;     // Slot holding the newest valid record, -1 if none
+} RecordStore;
+
+// Function prototypes
+void recordStoreInit(RecordStore* store, const char* filename, uint16_t slotSize);
+bool recordStoreLoad(RecordStore* store, uint16_t* version,
+                     uint8_t* data, uint16_t maxLength, uint16_t* length);
+bool recordStoreSave(RecordStore* store, uint16_t version,
+                     const uint8_t* data, uint16_t length);
+uint16_t recordStoreCapacity(const RecordStore* store);
+
+#endif // RECORD_STORE_H
\ No newline at end of file
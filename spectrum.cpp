@@ -0,0 +1,118 @@
+/**
+ * Hive Monitor System - Spectrum Module
+ *
+ * Band energies of a sampled signal from a Hann-windowed radix-2 FFT.
+ * Everything runs in place in float32 on caller-provided buffers, so
+ * the only memory is the capture itself and one scratch array of the
+ * same size.
+ */
+
+#include "spectrum.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/**
+ * In-place iterative radix-2 FFT
+ * size must be a power of two; returns false otherwise. Twiddles are
+ * advanced by a complex rotation per stage instead of calling sin/cos
+ * for every butterfly.
+ */
+bool fftTransform(float* real, float* imag, uint16_t size) {
+    if (size < 2 || (size & (size - 1)) != 0) {
+        return false;
+    }
+
+    // Bit-reversal permutation
+    for (uint16_t i = 1, j = 0; i < size; i++) {
+        uint16_t bit = size >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            float t = real[i]; real[i] = real[j]; real[j] = t;
+            t = imag[i]; imag[i] = imag[j]; imag[j] = t;
+        }
+    }
+
+    for (uint16_t length = 2; length <= size; length <<= 1) {
+        float angle = -2.0f * (float)M_PI / length;
+        float stepReal = cosf(angle);
+        float stepImag = sinf(angle);
+        uint16_t half = length >> 1;
+
+        for (uint16_t start = 0; start < size; start += length) {
+            float wReal = 1.0f;
+            float wImag = 0.0f;
+            for (uint16_t k = 0; k < half; k++) {
+                uint16_t a = start + k;
+                uint16_t b = a + half;
+                float tReal = real[b] * wReal - imag[b] * wImag;
+                float tImag = real[b] * wImag + imag[b] * wReal;
+                real[b] = real[a] - tReal;
+                imag[b] = imag[a] - tImag;
+                real[a] += tReal;
+                imag[a] += tImag;
+
+                float next = wReal * stepReal - wImag * stepImag;
+                wImag = wReal * stepImag + wImag * stepReal;
+                wReal = next;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * RMS amplitude of a signal in each frequency band
+ * bandEdges holds bands + 1 ascending frequencies (Hz); band i covers
+ * [bandEdges[i], bandEdges[i + 1]). The mean is removed and a Hann
+ * window applied before the transform, and the band powers are
+ * corrected for the window so a sine of amplitude A inside a band
+ * reads A / sqrt(2). samples is overwritten; scratch receives the
+ * imaginary parts. Returns false if size is not a power of two.
+ */
+bool computeBandEnergy(float* samples, float* scratch, uint16_t size, float sampleRate,
+                       const float* bandEdges, uint8_t bands, float* energy) {
+    if (size < 2 || (size & (size - 1)) != 0) {
+        return false;
+    }
+
+    float mean = 0.0f;
+    for (uint16_t i = 0; i < size; i++) {
+        mean += samples[i];
+    }
+    mean /= size;
+
+    for (uint16_t i = 0; i < size; i++) {
+        float window = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / size);
+        samples[i] = (samples[i] - mean) * window;
+        scratch[i] = 0.0f;
+    }
+
+    fftTransform(samples, scratch, size);
+
+    // One-sided power, Hann window mean square is 3/8
+    float binWidth = sampleRate / size;
+    float scale = 2.0f / ((float)size * size * 0.375f);
+    for (uint8_t band = 0; band < bands; band++) {
+        uint16_t first = (uint16_t)ceilf(bandEdges[band] / binWidth);
+        uint16_t last = (uint16_t)ceilf(bandEdges[band + 1] / binWidth);
+        if (first < 1) {
+            first = 1;
+        }
+        if (last > size / 2) {
+            last = size / 2;
+        }
+
+        float power = 0.0f;
+        for (uint16_t k = first; k < last; k++) {
+            power += samples[k] * samples[k] + scratch[k] * scratch[k];
+        }
+        energy[band] = sqrtf(power * scale);
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+/**
+ * Hive Monitor System - Spectrum Header
+ *
+ * Header file for the spectral band analysis used on high-rate sensor
+ * captures such as the accelerometer vibration window. Callers pass
+ * the samples and a scratch buffer, so nothing is allocated here.
+ */
+
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <stdint.h>
+
+// Function prototypes
+bool fftTransform(float* real, float* imag, uint16_t size);
+bool computeBandEnergy(float* samples, float* scratch, uint16_t size, float sampleRate,
+                       const float* bandEdges, uint8_t bands, float* energy);
+
+#endif // SPECTRUM_H
\ No newline at end of file
@@ -0,0 +1,104 @@
+/**
+ * Hive Monitor System - EW Statistics Benchmark
+ *
+ * Host-side benchmark of the per-feature learning statistics. Updates
+ * many colonies' feature vectors once with one EWStats object per
+ * feature, as LearningModel used to, and once with one EWStatsBlock per
+ * colony, as it does now, then compares every mean, variance and count
+ * bit for bit. Half of the colonies have some features restored with
+ * setStats(), so both warm-up paths are covered.
+ *
+ * Build from the repository root:
+ *   g++ -O2 -std=c++17 -I. tools/bench_ewstats.cpp learning_stats.cpp \
+ *       record_sections.cpp -o bench_ewstats
+ *
+ * Usage:
+ *   bench_ewstats [colonies] [samples]
+ *
+ * Prints the time per feature update of each layout and the number of
+ * mismatching results, and exits non-zero if there are any.
+ */
+
+#include "learning_stats.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// Features per colony, as in LearningModel
+#define BENCH_FEATURES 10
+
+/**
+ * Check two floats for bitwise equality
+ */
+static bool sameBits(float a, float b) {
+    return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+int main(int argc, char** argv) {
+    const int colonies = (argc > 1) ? atoi(argv[1]) : 2000;
+    const int samples = (argc > 2) ? atoi(argv[2]) : 2000;
+    if (colonies <= 0 || samples <= 0) {
+        fprintf(stderr, "usage: bench_ewstats [colonies] [samples]\n");
+        return 2;
+    }
+
+    std::vector<EWStats> single((size_t)colonies * BENCH_FEATURES);
+    std::vector<EWStatsBlock> blocks(colonies);
+    for (int c = 0; c < colonies; c++) {
+        blocks[c].init(BENCH_FEATURES);
+        for (int f = 0; f < BENCH_FEATURES; f++) {
+            float halfLife = 20.0f + f * 37.0f;
+            single[c * BENCH_FEATURES + f].setHalfLife(halfLife);
+            blocks[c].setHalfLife(f, halfLife);
+            if (f < 6 && (c % 2)) {
+                single[c * BENCH_FEATURES + f].setStats(3.0f, 1.0f);
+                blocks[c].setStats(f, 3.0f, 1.0f);
+            }
+        }
+    }
+
+    std::vector<float> values((size_t)colonies * BENCH_FEATURES);
+    srand(1);
+    double singleSeconds = 0.0, blockSeconds = 0.0;
+    size_t mismatches = 0;
+    for (int n = 0; n < samples; n++) {
+        for (size_t i = 0; i < values.size(); i++) {
+            values[i] = rand() / (float)RAND_MAX * 10.0f;
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (int c = 0; c < colonies; c++) {
+            for (int f = 0; f < BENCH_FEATURES; f++) {
+                single[c * BENCH_FEATURES + f].addSample(values[c * BENCH_FEATURES + f]);
+            }
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        for (int c = 0; c < colonies; c++) {
+            blocks[c].addSample(&values[c * BENCH_FEATURES]);
+        }
+        auto t2 = std::chrono::steady_clock::now();
+        singleSeconds += std::chrono::duration<double>(t1 - t0).count();
+        blockSeconds += std::chrono::duration<double>(t2 - t1).count();
+
+        for (int c = 0; c < colonies; c++) {
+            for (int f = 0; f < BENCH_FEATURES; f++) {
+                const EWStats& stats = single[c * BENCH_FEATURES + f];
+                if (!sameBits(stats.mean(), blocks[c].mean(f)) ||
+                    !sameBits(stats.variance(), blocks[c].variance(f)) ||
+                    stats.count() != blocks[c].count(f)) {
+                    mismatches++;
+                }
+            }
+        }
+    }
+
+    double updates = (double)colonies * BENCH_FEATURES * samples;
+    printf("%d colonies x %d features x %d samples\n", colonies, BENCH_FEATURES, samples);
+    printf("EWStats per feature:  %.1f ns/feature\n", singleSeconds * 1e9 / updates);
+    printf("EWStatsBlock:         %.1f ns/feature (%.2fx)\n",
+           blockSeconds * 1e9 / updates, singleSeconds / blockSeconds);
+    printf("Mismatches:           %zu\n", mismatches);
+    return mismatches ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,229 @@
+/**
+ * Hive Monitor System - EWStats Check
+ *
+ * Host-side check that the exponentially weighted statistics behind
+ * the learned baseline track drifting data the way exact windowed
+ * statistics do. An exponential weight with per-sample weight alpha has
+ * the same mean sample age, (1 - alpha) / alpha, as a sliding window of
+ * 2 / alpha - 1 samples, so on a linear ramp both lag by slope times
+ * that age, and on stationary noise both estimate the same variance.
+ * The window statistics are computed exactly in double precision.
+ *
+ * Build from the repository root:
+ *   g++ -O2 -std=c++17 -I. tools/check_ewstats.cpp learning_stats.cpp \
+ *       record_sections.cpp -o check_ewstats
+ *
+ * Usage:
+ *   check_ewstats
+ *
+ * Prints one line per check and exits non-zero if any fails.
+ */
+
+#include "learning_stats.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+// Half-life of the checks (samples): one day of 10-minute wakes
+#define CHECK_HALF_LIFE  144.0f
+
+// Samples per check, long enough for the window to fill many times
+#define CHECK_SAMPLES    20000
+
+static int failures = 0;
+
+/**
+ * Report one check
+ */
+static void report(const char* name, bool passed, const char* detail) {
+    printf("%-34s %s  %s\n", name, passed ? "PASS" : "FAIL", detail);
+    if (!passed) {
+        failures++;
+    }
+}
+
+/**
+ * Normal random number from a xorshift generator (Box-Muller)
+ */
+static double gaussian(uint32_t* state) {
+    double u[2];
+    for (int i = 0; i < 2; i++) {
+        *state ^= *state << 13;
+        *state ^= *state >> 17;
+        *state ^= *state << 5;
+        u[i] = (*state + 1.0) / 4294967297.0;
+    }
+    return sqrt(-2.0 * log(u[0])) * cos(6.283185307179586 * u[1]);
+}
+
+/**
+ * Exact mean and population variance over a sliding window
+ */
+class WindowStats {
+public:
+    explicit WindowStats(size_t length) : values_(length), next_(0), count_(0) {}
+
+    void addSample(double value) {
+        values_[next_] = value;
+        next_ = (next_ + 1) % values_.size();
+        if (count_ < values_.size()) {
+            count_++;
+        }
+    }
+
+    double mean() const {
+        double total = 0.0;
+        for (size_t i = 0; i < count_; i++) {
+            total += values_[i];
+        }
+        return total / count_;
+    }
+
+    double variance() const {
+        double m = mean();
+        double total = 0.0;
+        for (size_t i = 0; i < count_; i++) {
+            total += (values_[i] - m) * (values_[i] - m);
+        }
+        return total / count_;
+    }
+
+    bool isFull() const {
+        return count_ == values_.size();
+    }
+
+private:
+    std::vector<double> values_;
+    size_t next_;
+    size_t count_;
+};
+
+/**
+ * Per-sample weight for a half-life, as EWStats::setHalfLife computes it
+ */
+static double alphaFor(float halfLife) {
+    return 1.0 - pow(0.5, 1.0 / halfLife);
+}
+
+/**
+ * Window length with the same mean sample age as an exponential weight
+ */
+static size_t windowFor(float halfLife) {
+    return (size_t)lround(2.0 / alphaFor(halfLife) - 1.0);
+}
+
+/**
+ * During warm-up the 1/n weight gives the exact running mean and variance
+ */
+static void checkWarmUp() {
+    EWStats stats;
+    stats.setHalfLife(CHECK_HALF_LIFE);
+    uint32_t rng = 12345;
+    double total = 0.0, squares = 0.0, meanError = 0.0, varianceError = 0.0;
+    int warmUp = (int)(1.0 / alphaFor(CHECK_HALF_LIFE));
+    for (int n = 1; n <= warmUp; n++) {
+        double value = 20.0 + 2.0 * gaussian(&rng);
+        stats.addSample((float)value);
+        total += value;
+        squares += value * value;
+        double mean = total / n;
+        double variance = squares / n - mean * mean;
+        meanError = fmax(meanError, fabs(stats.mean() - mean) / mean);
+        if (n > 1) {
+            varianceError = fmax(varianceError, fabs(stats.variance() - variance) / variance);
+        }
+    }
+    char detail[96];
+    snprintf(detail, sizeof(detail), "%d samples, mean %.1e, variance %.1e relative",
+             warmUp, meanError, varianceError);
+    report("warm-up equals running stats", meanError < 1e-5 && varianceError < 1e-4, detail);
+}
+
+/**
+ * On a linear ramp the mean lags by slope times the mean sample age,
+ * the same lag as the equivalent window
+ */
+static void checkRamp() {
+    const double slope = 0.01;  // e.g. 10 g per wake of weight gain
+    EWStats stats;
+    stats.setHalfLife(CHECK_HALF_LIFE);
+    WindowStats window(windowFor(CHECK_HALF_LIFE));
+    double value = 0.0;
+    for (int i = 0; i < CHECK_SAMPLES; i++) {
+        value = 40.0 + slope * i;
+        stats.addSample((float)value);
+        window.addSample(value);
+    }
+    double alpha = alphaFor(CHECK_HALF_LIFE);
+    double expectedLag = slope * (1.0 - alpha) / alpha;
+    double lag = value - stats.mean();
+    double windowLag = value - window.mean();
+
+    char detail[96];
+    snprintf(detail, sizeof(detail), "lag %.4f, window %.4f, slope/alpha %.4f",
+             lag, windowLag, expectedLag);
+    report("ramp lag matches window",
+           fabs(lag - windowLag) < 0.01 * windowLag &&
+           fabs(lag - expectedLag) < 0.01 * expectedLag, detail);
+}
+
+/**
+ * After one half-life a step has been half absorbed
+ */
+static void checkStep() {
+    EWStats stats;
+    stats.setHalfLife(CHECK_HALF_LIFE);
+    stats.setStats(10.0f, 1.0f);
+    for (int i = 0; i < (int)CHECK_HALF_LIFE; i++) {
+        stats.addSample(20.0f);
+    }
+    double absorbed = (stats.mean() - 10.0) / 10.0;
+
+    char detail[96];
+    snprintf(detail, sizeof(detail), "%.4f of the step after one half-life", absorbed);
+    report("step half absorbed at half-life", fabs(absorbed - 0.5) < 0.002, detail);
+}
+
+/**
+ * On stationary noise the mean and variance agree with the window
+ * on average. A large offset with a small spread (barometric pressure
+ * in hPa) checks that float32 does not lose the variance.
+ */
+static void checkStationary(const char* name, double offset, double sigma) {
+    EWStats stats;
+    stats.setHalfLife(CHECK_HALF_LIFE);
+    WindowStats window(windowFor(CHECK_HALF_LIFE));
+    uint32_t rng = 987654321;
+    double ewVariance = 0.0, windowVariance = 0.0, meanError = 0.0;
+    int compared = 0;
+    for (int i = 0; i < CHECK_SAMPLES; i++) {
+        double value = offset + sigma * gaussian(&rng);
+        stats.addSample((float)value);
+        window.addSample(value);
+        if (window.isFull()) {
+            ewVariance += stats.variance();
+            windowVariance += window.variance();
+            meanError += fabs(stats.mean() - window.mean());
+            compared++;
+        }
+    }
+    double ratio = ewVariance / windowVariance;
+    double sigmaError = meanError / compared / sigma;
+
+    char detail[96];
+    snprintf(detail, sizeof(detail), "variance ratio %.4f, mean error %.3f sigma",
+             ratio, sigmaError);
+    report(name, fabs(ratio - 1.0) < 0.03 && sigmaError < 0.1, detail);
+}
+
+int main() {
+    printf("Half-life %.0f samples, equivalent window %zu samples\n",
+           CHECK_HALF_LIFE, windowFor(CHECK_HALF_LIFE));
+    checkWarmUp();
+    checkRamp();
+    checkStep();
+    checkStationary("stationary noise", 0.0, 1.0);
+    checkStationary("large offset, small spread", 1013.0, 0.05);
+    return failures ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+/**
+ * Hive Monitor System - Failed Reading Check
+ *
+ * Host-side regression check that a failed sensor read cannot poison
+ * the learned state. readEnvSensors() leaves humidity NAN when the
+ * SHT31 does not answer, and other readings can fail the same way. A
+ * synthetic hive is learned for several weeks while single readings
+ * are replaced by NAN; afterwards the joint score and the baseline must
+ * stay finite, a real disturbance must still be flagged, and the saved
+ * record must restore to a finite model.
+ *
+ * Build from the repository root:
+ *   g++ -O2 -std=c++17 -I. tools/check_nonfinite.cpp learning_model.cpp \
+ *       learning_stats.cpp anomaly_detection.cpp forecasting.cpp \
+ *       record_sections.cpp -o check_nonfinite
+ *
+ * Usage:
+ *   check_nonfinite
+ *
+ * Prints one line per check and exits non-zero if any fails.
+ */
+
+#include "learning_model.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+
+// Wakes learned, 10-minute interval (four weeks)
+#define CHECK_WAKES        4032
+#define CHECK_WAKE_SECONDS 600
+
+// Wake of the first failed reading, after the baseline is established
+#define CHECK_FIRST_NAN    2000
+
+// Wake of the injected disturbance
+#define CHECK_DISTURBANCE  3900
+
+static int failures = 0;
+
+/**
+ * Report one check
+ */
+static void report(const char* name, bool passed, const char* detail) {
+    printf("%-34s %s  %s\n", name, passed ? "PASS" : "FAIL", detail);
+    if (!passed) {
+        failures++;
+    }
+}
+
+/**
+ * Uniform random number in [-1, 1] from a xorshift generator
+ */
+static float noise(uint32_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return (*state / 4294967295.0f) * 2.0f - 1.0f;
+}
+
+/**
+ * Synthetic wake readings of a calm hive
+ */
+static LearningSample makeSample(int wake, uint32_t* rng) {
+    LearningSample sample;
+    sample.time = 1717200000UL + (uint32_t)wake * CHECK_WAKE_SECONDS;
+    sample.month = 6;
+    float day = (sample.time % 86400UL) / 86400.0f * 6.2831853f;
+    sample.temperature = 34.8f + 0.3f * sinf(day) + 0.1f * noise(rng);
+    sample.ambientTemperature = 18.0f + 6.0f * sinf(day - 1.5f) + 0.3f * noise(rng);
+    sample.humidity = 60.0f + 3.0f * sinf(day + 1.0f) + noise(rng);
+    sample.pressure = 1013.0f + 0.5f * noise(rng);
+    sample.weight = 40.0f + wake * 0.0005f + 0.01f * noise(rng);
+    sample.rawWeight = sample.weight;
+    for (int band = 0; band < NUM_AUDIO_BANDS; band++) {
+        sample.audioEnergy[band] = 0.5f + 0.2f * sinf(day + band) + 0.05f * noise(rng);
+    }
+    sample.motion = 0.005f + 0.001f * noise(rng);
+    sample.light = (sinf(day - 1.5f) > 0.0f) ? 3.0f : 0.0f;
+    return sample;
+}
+
+/**
+ * Replace one reading with NAN, cycling through every input
+ */
+static void failReading(LearningSample* sample, int failure) {
+    switch (failure % 8) {
+        case 0: sample->humidity = NAN; break;
+        case 1: sample->temperature = NAN; break;
+        case 2: sample->pressure = NAN; break;
+        case 3: sample->weight = NAN; sample->rawWeight = NAN; break;
+        case 4: sample->audioEnergy[failure % NUM_AUDIO_BANDS] = NAN; break;
+        case 5: sample->motion = NAN; break;
+        case 6: sample->light = NAN; break;
+        default: sample->ambientTemperature = NAN; break;
+    }
+}
+
+/**
+ * Check that every baseline field is finite
+ */
+static bool isBaselineFinite(const SensorBaseline& baseline) {
+    const float values[] = {
+        baseline.tempMean, baseline.tempStdDev, baseline.humidityMean,
+        baseline.humidityStdDev, baseline.pressureMean, baseline.pressureStdDev,
+        baseline.weightMean, baseline.weightStdDev, baseline.weightDailyDelta,
+        baseline.audioEnergy[0], baseline.audioEnergy[1],
+        baseline.audioEnergy[2], baseline.audioEnergy[3],
+        baseline.audioStdDev[0], baseline.audioStdDev[1],
+        baseline.audioStdDev[2], baseline.audioStdDev[3]
+    };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        if (!isfinite(values[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    static LearningModel model;
+    uint32_t rng = 2463534242UL;
+    int nonFiniteScores = 0;
+    int failedReadings = 0;
+    int nonFiniteForecasts = 0;
+    bool disturbanceFlagged = false;
+    float disturbanceScore = 0.0f;
+
+    for (int wake = 0; wake < CHECK_WAKES; wake++) {
+        LearningSample sample = makeSample(wake, &rng);
+        bool failed = wake == CHECK_FIRST_NAN ||
+                      (wake > CHECK_FIRST_NAN && wake % 97 == 0);
+        if (failed) {
+            failReading(&sample, failedReadings++);
+        }
+
+        // Warm brood with loud B3, as before a swarm
+        if (wake == CHECK_DISTURBANCE) {
+            sample.temperature += 1.5f;
+            sample.audioEnergy[2] *= 3.0f;
+        }
+
+        uint8_t events = model.update(sample);
+        if (wake > CHECK_FIRST_NAN && !failed &&
+            !isfinite(model.jointAnomalyScore(NULL))) {
+            nonFiniteScores++;
+        }
+        if (wake > CHECK_FIRST_NAN &&
+            (!isfinite(model.forecastTemperature(sample.time + CHECK_WAKE_SECONDS)) ||
+             !isfinite(model.forecastWeight(sample.time + CHECK_WAKE_SECONDS)))) {
+            nonFiniteForecasts++;
+        }
+        if (wake == CHECK_DISTURBANCE) {
+            disturbanceFlagged = (events & LEARNING_EVENT_JOINT_ANOMALY) != 0;
+            disturbanceScore = model.jointAnomalyScore(NULL);
+        }
+    }
+
+    char detail[96];
+    snprintf(detail, sizeof(detail), "%d failed readings, %d NaN scores after them",
+             failedReadings, nonFiniteScores);
+    report("joint score stays finite", nonFiniteScores == 0, detail);
+
+    snprintf(detail, sizeof(detail), "%d NaN forecasts", nonFiniteForecasts);
+    report("forecasts stay finite", nonFiniteForecasts == 0, detail);
+
+    snprintf(detail, sizeof(detail), "humidity %.2f +/- %.2f",
+             model.baseline().humidityMean, model.baseline().humidityStdDev);
+    report("baseline stays finite", isBaselineFinite(model.baseline()), detail);
+
+    snprintf(detail, sizeof(detail), "score %.1f at wake %d", disturbanceScore,
+             CHECK_DISTURBANCE);
+    report("disturbance still flagged", disturbanceFlagged, detail);
+
+    // The saved record restores to a model that scores a normal wake
+    static uint8_t record[4096];
+    uint16_t length = model.serialize(record, sizeof(record));
+    static LearningModel restored;
+    restored.deserialize(record, length);
+    restored.update(makeSample(CHECK_WAKES, &rng));
+    float restoredScore = restored.jointAnomalyScore(NULL);
+    snprintf(detail, sizeof(detail), "%u byte record, next score %.2f", length, restoredScore);
+    report("restored record is finite",
+           length > 0 && isBaselineFinite(restored.baseline()) && isfinite(restoredScore),
+           detail);
+
+    return failures ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,514 @@
+/**
+ * Hive Monitor System - Offline Replay Tool
+ *
+ * Host-side tool that runs logged sensor data through the learning model
+ * and its anomaly checks, so learning parameters can be tuned against
+ * past seasons instead of weeks in the field. Each hive is an SD card
+ * image (a directory holding the LOG_YYYYMMDD.CSV files written by
+ * logSensorData). Hives are fanned out over a thread pool, and every
+ * combination of the given parameter values is replayed in one pass.
+ *
+ * Build from the repository root:
+ *   g++ -O2 -std=c++17 -pthread -I. tools/replay.cpp learning_model.cpp \
+ *       learning_stats.cpp anomaly_detection.cpp forecasting.cpp \
+ *       record_sections.cpp -o replay
+ *
+ * Usage:
+ *   replay [options] <sd-image-dir>...
+ *   replay [options] --synthetic <hives>
+ *
+ * Options (lists are comma separated; all combinations are replayed):
+ *   --rate <list>         Baseline adaptation rate (LEARNING_ADAPTATION_RATE)
+ *   --samples-min <list>  Samples before the baseline is used (LEARNING_SAMPLES_MIN)
+ *   --temp-z <list>       Temperature anomaly z-score (TEMP_ANOMALY_THRESHOLD)
+ *   --humidity-z <list>   Humidity anomaly z-score (HUMIDITY_ANOMALY_THRESHOLD)
+ *   --weight-z <list>     Weight anomaly z-score (WEIGHT_ANOMALY_THRESHOLD)
+ *   --joint <list>        Joint anomaly distance (JOINT_ANOMALY_THRESHOLD)
+ *   --margin <list>       Learned percentile margin (QUANTILE_THRESHOLD_MARGIN)
+ *   --threads <n>         Worker threads (default: hardware concurrency)
+ *   --synthetic <hives>   Replay a generated year per hive instead of logs
+ *   --per-hive            Also print counts per hive
+ *
+ * Output is CSV on stdout, one row per configuration, with the number of
+ * wakes that raised each alert once the baseline was established.
+ */
+
+#include "learning_model.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Wake interval of the synthetic hives (s) and their length (wakes)
+#define SYNTHETIC_INTERVAL  600
+#define SYNTHETIC_WAKES     (365 * 24 * 3600 / SYNTHETIC_INTERVAL)
+#define SYNTHETIC_START     1704067200UL   // 2024-01-01T00:00:00Z
+
+// Columns of a LOG_*.CSV row
+enum LogColumn {
+    COL_TIMESTAMP, COL_TEMPERATURE, COL_HUMIDITY, COL_PRESSURE, COL_WEIGHT,
+    COL_LIGHT, COL_ACCEL_X, COL_ACCEL_Y, COL_ACCEL_Z,
+    COL_B1, COL_B2, COL_B3, COL_B4, COL_BATTERY, COL_STATUS,
+    COL_STATE, COL_STATE_P, COL_MOTION,
+    NUM_LOG_COLUMNS
+};
+
+// Alerts counted per replay
+enum AlertKind {
+    ALERT_TEMPERATURE, ALERT_HUMIDITY, ALERT_AUDIO, ALERT_WEIGHT, ALERT_JOINT,
+    NUM_ALERT_KINDS
+};
+
+static const char* alertNames[NUM_ALERT_KINDS] = {
+    "temperature", "humidity", "audio", "weight", "joint"
+};
+
+// Result of replaying one hive under one configuration
+typedef struct {
+    uint32_t samples;                    // Wakes replayed
+    uint32_t scored;                     // Wakes after the baseline was established
+    uint32_t alerts[NUM_ALERT_KINDS];    // Wakes raising each alert
+} ReplayCounts;
+
+// One hive's input
+typedef struct {
+    std::string name;                    // SD image directory or synthetic id
+    std::vector<LearningSample> samples; // Empty for synthetic hives
+} Hive;
+
+/**
+ * Days since 1970-01-01 for a civil date (proleptic Gregorian)
+ */
+static int32_t daysFromCivil(int32_t year, uint32_t month, uint32_t day) {
+    year -= month <= 2;
+    int32_t era = (year >= 0 ? year : year - 399) / 400;
+    uint32_t yearOfEra = (uint32_t)(year - era * 400);
+    uint32_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + (int32_t)dayOfEra - 719468;
+}
+
+/**
+ * Parse one LOG_*.CSV data row into a sample
+ * Returns false for the header and malformed rows.
+ */
+static bool parseLogRow(char* line, LearningSample* sample) {
+    char* fields[NUM_LOG_COLUMNS];
+    int count = 0;
+    for (char* field = strtok(line, ",\r\n"); field && count < NUM_LOG_COLUMNS;
+         field = strtok(NULL, ",\r\n")) {
+        fields[count++] = field;
+    }
+    if (count < COL_BATTERY) {
+        return false;
+    }
+
+    int year, month, day, hour, minute, second;
+    if (sscanf(fields[COL_TIMESTAMP], "%4d-%2d-%2dT%2d:%2d:%2d",
+               &year, &month, &day, &hour, &minute, &second) != 6) {
+        return false;
+    }
+
+    sample->time = (uint32_t)(daysFromCivil(year, month, day) * 86400L +
+                              hour * 3600L + minute * 60L + second);
+    sample->month = month;
+    sample->temperature = strtof(fields[COL_TEMPERATURE], NULL);
+    sample->ambientTemperature = NAN;  // Not logged
+    sample->humidity = strtof(fields[COL_HUMIDITY], NULL);
+    sample->pressure = strtof(fields[COL_PRESSURE], NULL);
+    sample->weight = strtof(fields[COL_WEIGHT], NULL);
+    sample->rawWeight = sample->weight;  // Only the compensated weight is logged
+    sample->light = strtof(fields[COL_LIGHT], NULL);
+
+    // Older logs have no activity column; the magnitude's distance from
+    // 1 g is the nearest stand-in
+    if (count > COL_MOTION) {
+        sample->motion = strtof(fields[COL_MOTION], NULL);
+    } else {
+        float x = strtof(fields[COL_ACCEL_X], NULL);
+        float y = strtof(fields[COL_ACCEL_Y], NULL);
+        float z = strtof(fields[COL_ACCEL_Z], NULL);
+        sample->motion = fabsf(sqrtf(x * x + y * y + z * z) - 1.0f);
+    }
+
+    for (int i = 0; i < NUM_AUDIO_BANDS; i++) {
+        sample->audioEnergy[i] = strtof(fields[COL_B1 + i], NULL);
+    }
+    return true;
+}
+
+/**
+ * Load all LOG_*.CSV files of an SD image in date order
+ */
+static bool loadHive(const fs::path& dir, Hive* hive) {
+    std::vector<fs::path> files;
+    std::error_code error;
+    for (const fs::directory_entry& entry : fs::directory_iterator(dir, error)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() == 16 && name.compare(0, 4, "LOG_") == 0 &&
+            name.compare(12, 4, ".CSV") == 0) {
+            files.push_back(entry.path());
+        }
+    }
+    if (error) {
+        fprintf(stderr, "Cannot read %s: %s\n", dir.c_str(), error.message().c_str());
+        return false;
+    }
+
+    // LOG_YYYYMMDD.CSV sorts by date
+    std::sort(files.begin(), files.end());
+
+    hive->name = dir.filename().string();
+    if (hive->name.empty()) {
+        hive->name = dir.parent_path().filename().string();
+    }
+
+    char line[512];
+    for (const fs::path& path : files) {
+        FILE* file = fopen(path.c_str(), "r");
+        if (!file) {
+            fprintf(stderr, "Cannot open %s\n", path.c_str());
+            continue;
+        }
+        while (fgets(line, sizeof(line), file)) {
+            LearningSample sample;
+            if (parseLogRow(line, &sample)) {
+                hive->samples.push_back(sample);
+            }
+        }
+        fclose(file);
+    }
+    return true;
+}
+
+/**
+ * Small deterministic generator for synthetic hives (xorshift32)
+ */
+static float syntheticNoise(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+
+    // Sum of uniforms, roughly normal with unit variance
+    float sum = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        sum += ((x >> (i * 8)) & 0xFF) / 255.0f;
+    }
+    return (sum - 2.0f) * 1.732f;
+}
+
+/**
+ * Generate one wake of a synthetic hive: daily brood, humidity, weight
+ * and audio cycles, a nectar flow in summer and a harvest in autumn
+ */
+static void syntheticSample(uint32_t hiveIndex, uint32_t wake, uint32_t* rng,
+                            LearningSample* sample) {
+    uint32_t time = SYNTHETIC_START + wake * SYNTHETIC_INTERVAL;
+    int32_t days = (int32_t)(time / 86400);
+    float dayOfYear = (float)(days - daysFromCivil(2024, 1, 1));
+    float hourOfDay = (time % 86400) / 3600.0f;
+    float daily = sinf((hourOfDay - 9.0f) * (float)M_PI / 12.0f);
+
+    sample->time = time;
+    sample->month = (uint8_t)(1 + (int)(dayOfYear / 30.5f) % 12);
+
+    float flow = (dayOfYear > 150 && dayOfYear < 200) ? 0.04f : 0.0f;
+    float harvest = (dayOfYear > 240) ? -12.0f : 0.0f;
+
+    sample->temperature = 34.8f + 0.3f * daily + 0.1f * syntheticNoise(rng);
+    sample->ambientTemperature = 15.0f - 10.0f * cosf(dayOfYear * 2.0f * (float)M_PI / 365.0f) +
+                                 6.0f * daily + 0.5f * syntheticNoise(rng);
+    sample->humidity = 60.0f - 4.0f * daily + 1.0f * syntheticNoise(rng);
+    sample->pressure = 1013.0f + 3.0f * sinf(dayOfYear * 0.7f) + 0.2f * syntheticNoise(rng);
+    sample->weight = 40.0f + (hiveIndex % 10) + flow * fminf(dayOfYear - 150, 50) * 24 +
+                     harvest - 0.3f * fmaxf(0.0f, daily) + 0.02f * syntheticNoise(rng);
+    sample->rawWeight = sample->weight;
+    sample->motion = 0.005f * expf(0.05f * syntheticNoise(rng));
+    sample->light = (wake % 4000 == 17) ? 500.0f : 2.0f;
+
+    static const float bandLevel[NUM_AUDIO_BANDS] = { 0.6f, 0.3f, 0.2f, 0.1f };
+    for (int i = 0; i < NUM_AUDIO_BANDS; i++) {
+        float level = bandLevel[i] * (1.0f + 0.4f * daily);
+        sample->audioEnergy[i] = level * expf(0.15f * syntheticNoise(rng));
+    }
+}
+
+/**
+ * Score one sample against the model, then let the model learn it
+ * The per-sensor checks run first so the sample does not count towards
+ * its own expected value and spread; update() likewise scores the joint
+ * feature vector before learning it.
+ */
+static void replaySample(LearningModel& model, const LearningSample& sample,
+                         float previousWeight, ReplayCounts* counts) {
+    counts->samples++;
+    if (!model.isBaselineEstablished()) {
+        model.update(sample);
+        return;
+    }
+    counts->scored++;
+
+    if (model.isTemperatureAnomaly(sample.temperature, sample.time)) {
+        counts->alerts[ALERT_TEMPERATURE]++;
+    }
+    if (model.isHumidityAnomaly(sample.humidity, sample.time)) {
+        counts->alerts[ALERT_HUMIDITY]++;
+    }
+    if (model.isAudioAnomaly(sample.audioEnergy, sample.time)) {
+        counts->alerts[ALERT_AUDIO]++;
+    }
+    if (model.isWeightAnomaly(sample.weight, previousWeight, sample.time)) {
+        counts->alerts[ALERT_WEIGHT]++;
+    }
+
+    uint8_t events = model.update(sample);
+    if (events & LEARNING_EVENT_JOINT_ANOMALY) {
+        counts->alerts[ALERT_JOINT]++;
+    }
+}
+
+/**
+ * Replay one hive under one configuration
+ */
+static ReplayCounts replayHive(const Hive& hive, uint32_t hiveIndex,
+                               const LearningParams* params) {
+    ReplayCounts counts;
+    memset(&counts, 0, sizeof(counts));
+
+    LearningModel model;
+    model.init(params);
+
+    float previousWeight = 0.0f;
+    if (hive.samples.empty()) {
+        uint32_t rng = 0x9E3779B9u ^ (hiveIndex * 2654435761u);
+        LearningSample sample;
+        for (uint32_t wake = 0; wake < SYNTHETIC_WAKES; wake++) {
+            syntheticSample(hiveIndex, wake, &rng, &sample);
+            replaySample(model, sample, wake ? previousWeight : sample.weight, &counts);
+            previousWeight = sample.weight;
+        }
+    } else {
+        for (size_t i = 0; i < hive.samples.size(); i++) {
+            const LearningSample& sample = hive.samples[i];
+            replaySample(model, sample, i ? previousWeight : sample.weight, &counts);
+            previousWeight = sample.weight;
+        }
+    }
+    return counts;
+}
+
+/**
+ * Parse a comma-separated list of numbers
+ */
+static bool parseList(const char* text, std::vector<float>* values) {
+    values->clear();
+    const char* cursor = text;
+    while (*cursor) {
+        char* end;
+        float value = strtof(cursor, &end);
+        if (end == cursor) {
+            return false;
+        }
+        values->push_back(value);
+        cursor = (*end == ',') ? end + 1 : end;
+    }
+    return !values->empty();
+}
+
+/**
+ * Print usage to stderr
+ */
+static void printUsage() {
+    fprintf(stderr,
+        "usage: replay [options] <sd-image-dir>...\n"
+        "       replay [options] --synthetic <hives>\n"
+        "options: --rate --samples-min --temp-z --humidity-z --weight-z\n"
+        "         --joint --margin <comma list>, --threads <n>, --per-hive\n");
+}
+
+int main(int argc, char** argv) {
+    // Parameter grid, each axis defaulting to the config.h value
+    const LearningParams& defaults = learningDefaultParams;
+    std::vector<float> rates(1, defaults.adaptationRate);
+    std::vector<float> samplesMin(1, defaults.samplesMin);
+    std::vector<float> tempZ(1, defaults.tempAnomalyThreshold);
+    std::vector<float> humidityZ(1, defaults.humidityAnomalyThreshold);
+    std::vector<float> weightZ(1, defaults.weightAnomalyThreshold);
+    std::vector<float> joint(1, defaults.jointAnomalyThreshold);
+    std::vector<float> margins(1, defaults.quantileMargin);
+
+    unsigned threads = std::thread::hardware_concurrency();
+    uint32_t syntheticHives = 0;
+    bool perHive = false;
+    std::vector<fs::path> images;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        std::vector<float>* axis = NULL;
+
+        if (strcmp(arg, "--rate") == 0) axis = &rates;
+        else if (strcmp(arg, "--samples-min") == 0) axis = &samplesMin;
+        else if (strcmp(arg, "--temp-z") == 0) axis = &tempZ;
+        else if (strcmp(arg, "--humidity-z") == 0) axis = &humidityZ;
+        else if (strcmp(arg, "--weight-z") == 0) axis = &weightZ;
+        else if (strcmp(arg, "--joint") == 0) axis = &joint;
+        else if (strcmp(arg, "--margin") == 0) axis = &margins;
+
+        if (axis) {
+            if (!value || !parseList(value, axis)) {
+                fprintf(stderr, "Bad value list for %s\n", arg);
+                return 1;
+            }
+            i++;
+        } else if (strcmp(arg, "--threads") == 0 && value) {
+            threads = (unsigned)atoi(value);
+            i++;
+        } else if (strcmp(arg, "--synthetic") == 0 && value) {
+            syntheticHives = (uint32_t)atoi(value);
+            i++;
+        } else if (strcmp(arg, "--per-hive") == 0) {
+            perHive = true;
+        } else if (arg[0] == '-') {
+            printUsage();
+            return 1;
+        } else {
+            images.push_back(arg);
+        }
+    }
+
+    if (images.empty() == (syntheticHives == 0)) {
+        printUsage();
+        return 1;
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+
+    // Every combination of the axis values
+    std::vector<LearningParams> configs;
+    for (float rate : rates)
+    for (float minimum : samplesMin)
+    for (float t : tempZ)
+    for (float h : humidityZ)
+    for (float w : weightZ)
+    for (float j : joint)
+    for (float m : margins) {
+        LearningParams params = defaults;
+        params.adaptationRate = rate;
+        params.samplesMin = (uint16_t)minimum;
+        params.tempAnomalyThreshold = t;
+        params.humidityAnomalyThreshold = h;
+        params.weightAnomalyThreshold = w;
+        params.jointAnomalyThreshold = j;
+        params.quantileMargin = m;
+        configs.push_back(params);
+    }
+
+    // Logs are parsed once and shared by all configurations
+    std::vector<Hive> hives;
+    if (syntheticHives > 0) {
+        hives.resize(syntheticHives);
+        for (uint32_t i = 0; i < syntheticHives; i++) {
+            hives[i].name = "synthetic" + std::to_string(i);
+        }
+    } else {
+        for (const fs::path& image : images) {
+            Hive hive;
+            if (loadHive(image, &hive) && !hive.samples.empty()) {
+                hives.push_back(std::move(hive));
+            } else {
+                fprintf(stderr, "No LOG_*.CSV data in %s\n", image.c_str());
+            }
+        }
+        if (hives.empty()) {
+            return 1;
+        }
+    }
+
+    // Thread pool over (configuration, hive) jobs
+    size_t jobs = configs.size() * hives.size();
+    std::vector<ReplayCounts> results(jobs);
+    std::atomic<size_t> nextJob(0);
+    std::vector<std::thread> workers;
+
+    auto started = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threads && t < jobs; t++) {
+        workers.emplace_back([&]() {
+            for (size_t job = nextJob++; job < jobs; job = nextJob++) {
+                size_t config = job / hives.size();
+                size_t hive = job % hives.size();
+                results[job] = replayHive(hives[hive], (uint32_t)hive, &configs[config]);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - started).count();
+
+    // One row per configuration (optionally per hive)
+    printf("config,%srate,samplesMin,tempZ,humidityZ,weightZ,joint,margin,samples,scored",
+           perHive ? "hive," : "");
+    for (int k = 0; k < NUM_ALERT_KINDS; k++) {
+        printf(",%s", alertNames[k]);
+    }
+    printf("\n");
+
+    uint64_t updates = 0;
+    for (size_t c = 0; c < configs.size(); c++) {
+        const LearningParams& p = configs[c];
+        ReplayCounts total;
+        memset(&total, 0, sizeof(total));
+
+        for (size_t h = 0; h < hives.size(); h++) {
+            const ReplayCounts& counts = results[c * hives.size() + h];
+            total.samples += counts.samples;
+            total.scored += counts.scored;
+            for (int k = 0; k < NUM_ALERT_KINDS; k++) {
+                total.alerts[k] += counts.alerts[k];
+            }
+
+            if (perHive) {
+                printf("%zu,%s,%g,%u,%g,%g,%g,%g,%g,%u,%u", c, hives[h].name.c_str(),
+                       p.adaptationRate, p.samplesMin, p.tempAnomalyThreshold,
+                       p.humidityAnomalyThreshold, p.weightAnomalyThreshold,
+                       p.jointAnomalyThreshold, p.quantileMargin,
+                       counts.samples, counts.scored);
+                for (int k = 0; k < NUM_ALERT_KINDS; k++) {
+                    printf(",%u", counts.alerts[k]);
+                }
+                printf("\n");
+            }
+        }
+        updates += total.samples;
+
+        if (!perHive) {
+            printf("%zu,%g,%u,%g,%g,%g,%g,%g,%u,%u", c,
+                   p.adaptationRate, p.samplesMin, p.tempAnomalyThreshold,
+                   p.humidityAnomalyThreshold, p.weightAnomalyThreshold,
+                   p.jointAnomalyThreshold, p.quantileMargin,
+                   total.samples, total.scored);
+            for (int k = 0; k < NUM_ALERT_KINDS; k++) {
+                printf(",%u", total.alerts[k]);
+            }
+            printf("\n");
+        }
+    }
+
+    fprintf(stderr, "%zu hives x %zu configurations on %u threads: %.2f s, %.0f updates/s\n",
+            hives.size(), configs.size(), threads, seconds, updates / seconds);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,213 @@
+/**
+ * Hive Monitor System - HX711 Shared-Clock Simulator
+ *
+ * Host-side simulation of up to four HX711s on one shared clock line,
+ * read the way weight_sensing.cpp reads them: wait until every DOUT is
+ * low, then clock all 24-bit results out with a single pulse train,
+ * reading one data pin per channel on each pulse, plus the 25th pulse
+ * for channel A at gain 128. Each chip converts at 10 SPS with its own
+ * oscillator error, so the channels drift apart slightly within a
+ * wake. Pin accesses advance a virtual clock by the nRF52 Arduino core's
+ * digitalRead/digitalWrite cost, so the wall time of an acquisition can
+ * be compared across channel counts.
+ *
+ * Build from the repository root:
+ *   g++ -O2 -std=c++17 tools/sim_hx711.cpp -o sim_hx711
+ *
+ * Usage:
+ *   sim_hx711 [runs]
+ *
+ * Prints, per channel count, the mean wall time of WEIGHT_SAMPLES
+ * conversions after power-up, the readout time per conversion and the
+ * number of wrongly decoded values, and exits non-zero if any were.
+ */
+
+#include <math.h>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Mirrors of the firmware settings
+#define WEIGHT_SAMPLES       5       // Conversions per reading (config.h)
+#define WEIGHT_MAX_CHANNELS  4       // Chips on the shared clock (weight_sensing.h)
+
+// HX711 timing at RATE = 0 (10 SPS)
+#define HX711_PERIOD_US      100000.0  // Nominal conversion period
+#define HX711_SETTLE_PERIODS 4         // Periods before the first conversion after power-up
+#define HX711_CLOCK_SPREAD   0.02      // Oscillator tolerance (+/-)
+
+// nRF52 Arduino core pin access cost and interrupt latency (us)
+#define PIN_READ_US          0.35
+#define PIN_WRITE_US         0.30
+#define EDGE_LATENCY_US      10.0
+
+// One simulated HX711
+typedef struct {
+    double period;     // Conversion period with this chip's oscillator error (us)
+    double nextReady;  // Virtual time the next conversion completes (us)
+    bool ready;        // DOUT held low with a conversion waiting
+    long value;        // Conversion being shifted out (24-bit two's complement)
+    int shift;         // Rising clock edges seen in this readout
+} SimChip;
+
+static SimChip chips[WEIGHT_MAX_CHANNELS];
+static int channels = 1;
+static double nowUs = 0.0;
+static int clockLevel = 0;
+
+/**
+ * Advance the virtual clock, completing any conversions that are due
+ */
+static void advance(double us) {
+    nowUs += us;
+    for (int ch = 0; ch < channels; ch++) {
+        if (!chips[ch].ready && nowUs >= chips[ch].nextReady) {
+            chips[ch].ready = true;
+            chips[ch].shift = 0;
+        }
+    }
+}
+
+/**
+ * Drive the shared clock line
+ * A rising edge shifts the next bit out of every chip with a
+ * conversion waiting; the falling edge after the 25th pulse ends the
+ * readout and starts the wait for the next conversion.
+ */
+static void writeClock(int level) {
+    advance(PIN_WRITE_US);
+    for (int ch = 0; ch < channels; ch++) {
+        SimChip* chip = &chips[ch];
+        if (!chip->ready) {
+            continue;
+        }
+        if (level && !clockLevel) {
+            chip->shift++;
+        } else if (!level && clockLevel && chip->shift == 25) {
+            chip->ready = false;
+            chip->nextReady += chip->period;
+        }
+    }
+    clockLevel = level;
+}
+
+/**
+ * Read one chip's DOUT line
+ */
+static int readData(int ch) {
+    advance(PIN_READ_US);
+    const SimChip* chip = &chips[ch];
+    if (!chip->ready) {
+        return 1;
+    }
+    if (chip->shift == 0 || chip->shift > 24) {
+        return 0;
+    }
+    return (chip->value >> (24 - chip->shift)) & 1;
+}
+
+/**
+ * Check if every channel has a conversion ready, as isHX711Ready() does
+ */
+static bool isReady() {
+    for (int ch = 0; ch < channels; ch++) {
+        if (readData(ch) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Clock one conversion out of every chip, as readHX711Raw() does
+ */
+static void readRaw(long values[WEIGHT_MAX_CHANNELS]) {
+    unsigned long bits[WEIGHT_MAX_CHANNELS] = {0};
+    for (int i = 0; i < 24; i++) {
+        writeClock(1);
+        advance(1.0);
+        for (int ch = 0; ch < channels; ch++) {
+            bits[ch] = (bits[ch] << 1) | readData(ch);
+        }
+        writeClock(0);
+        advance(1.0);
+    }
+    writeClock(1);
+    advance(1.0);
+    writeClock(0);
+
+    for (int ch = 0; ch < channels; ch++) {
+        if (bits[ch] & 0x800000UL) {
+            bits[ch] |= 0xFF000000UL;
+        }
+        values[ch] = (long)(int32_t)bits[ch];
+    }
+}
+
+/**
+ * Random 24-bit signed conversion result
+ */
+static long randomConversion(std::mt19937* rng) {
+    return (long)((*rng)() % 0xFFFFFF) - 0x7FFFFF;
+}
+
+int main(int argc, char** argv) {
+    const int runs = (argc > 1) ? atoi(argv[1]) : 200;
+    if (runs <= 0) {
+        fprintf(stderr, "usage: sim_hx711 [runs]\n");
+        return 2;
+    }
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> spread(-HX711_CLOCK_SPREAD, HX711_CLOCK_SPREAD);
+    int totalErrors = 0;
+
+    printf("channels,wall_ms,readout_us,decode_errors\n");
+    for (channels = 1; channels <= WEIGHT_MAX_CHANNELS; channels++) {
+        double wallUs = 0.0, readoutUs = 0.0;
+        int errors = 0;
+
+        for (int run = 0; run < runs; run++) {
+            // Releasing the shared clock powers every chip up at once
+            nowUs = 0.0;
+            clockLevel = 0;
+            for (int ch = 0; ch < channels; ch++) {
+                chips[ch].period = HX711_PERIOD_US * (1.0 + spread(rng));
+                chips[ch].nextReady = chips[ch].period * HX711_SETTLE_PERIODS;
+                chips[ch].ready = false;
+                chips[ch].value = randomConversion(&rng);
+            }
+
+            for (int sample = 0; sample < WEIGHT_SAMPLES; sample++) {
+                // The data-ready interrupt fires on each DOUT edge and
+                // returns until the last channel is ready
+                while (!isReady()) {
+                    advance(EDGE_LATENCY_US);
+                }
+
+                long expected[WEIGHT_MAX_CHANNELS];
+                for (int ch = 0; ch < channels; ch++) {
+                    expected[ch] = chips[ch].value;
+                }
+                double start = nowUs;
+                long values[WEIGHT_MAX_CHANNELS];
+                readRaw(values);
+                readoutUs += nowUs - start;
+
+                for (int ch = 0; ch < channels; ch++) {
+                    if (values[ch] != expected[ch]) {
+                        errors++;
+                    }
+                    chips[ch].value = randomConversion(&rng);
+                }
+            }
+            wallUs += nowUs;
+        }
+
+        printf("%d,%.1f,%.1f,%d\n", channels, wallUs / runs / 1000.0,
+               readoutUs / runs / WEIGHT_SAMPLES, errors);
+        totalErrors += errors;
+    }
+    return totalErrors ? 1 : 0;
+}
\ No newline at end of file
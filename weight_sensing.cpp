@@ -2,103 +2,461 @@
  * Hive Monitor System - Weight Sensing Module
  * 
  * This module handles the weight sensing subsystem, using a load
- * cell and HX711 amplifier to measure and log the hive's weight.
+ * cell and HX711 amplifier per hive to measure and log hive weights.
+ * The HX711s share one clock line: powering them up together starts
+ * their conversions in step, and each 24-bit result is clocked out of
+ * every channel with the same pulse train, so reading several scales
+ * takes about as long as reading one.
  */
 
  #include "weight_sensing.h"
  #include "config.h"
- #include <HX711.h>
+ #include "learning.h"
+ #include "power_management.h"
  
- // HX711 instance
- HX711 scale;
+ // HX711 data pins, one per channel
+ static const uint8_t weightDataPins[WEIGHT_MAX_CHANNELS] = HX711_DATA_PINS;
  
- // Weight variables
- float currentWeight = 0.0f;
- float previousWeight = 0.0f;
- WeightStatus weightStatus = WEIGHT_STABLE;
+ // Calibration and latest reading of one channel
+ typedef struct {
+   long offset;                    // Raw reading with the scale empty
+   float calibration;              // Raw counts per kg
+   float previousWeight;           // Weight at the previous reading (kg)
+   WeightReading reading;          // Latest reading
+   ChangeDetector changeDetector;  // Change-point detection on the weight series
+   bool changeDetected;            // Latest reading completed a change
+ } WeightChannel;
+ 
+ WeightChannel weightChannels[WEIGHT_CHANNELS];
+ 
+ // Temperature at the previous reading, for the drift rate term
+ float driftLastTemperature = NAN;
+ uint32_t driftLastTime = 0;
+ 
+ // Conversions captured by the data-ready interrupt, all channels per entry
+ volatile long weightRawSamples[WEIGHT_SAMPLES][WEIGHT_CHANNELS];
+ volatile uint8_t weightRawCount = 0;
+ bool weightAcquiring = false;
+ 
+ // The last reading got at least one conversion
+ bool weightReadingValid = false;
+ 
+ // Burst capture, also filled by the data-ready interrupt
+ WeightBurst weightBurst;
+ volatile bool weightBurstActive = false;
+ volatile uint16_t weightBurstCount = 0;
+ volatile unsigned long weightBurstLastMs = 0;
+ long weightBurstOffset = 0;
+ float weightBurstScale = 1.0f;
+ bool weightBurstPending = false;
+ uint8_t weightBurstChannel = 0;
+ uint32_t weightBurstLastTime = 0;
  
  /**
-  * Initialize weight sensor
+  * Check if every channel has a conversion ready (DOUT low)
   */
- bool setupWeightSensor() {
-   // Initialize HX711
-   scale.begin(HX711_DATA_PIN, HX711_CLOCK_PIN);
+ static bool isHX711Ready() {
+   for (uint8_t ch = 0; ch < WEIGHT_CHANNELS; ch++) {
+     if (digitalRead(weightDataPins[ch]) != LOW) {
+       return false;
+     }
+   }
+   return true;
+ }
+ 
+ /**
+  * Clock one 24-bit conversion out of every HX711 at once
+  * Each clock pulse shifts the next bit out of all channels, so the
+  * cost grows by one pin read per channel and bit. The 25th pulse
+  * keeps channel A at gain 128 for the next conversion. Pulses stay
+  * well under the 60 us that would power the chips down.
+  */
+ static void readHX711Raw(long values[WEIGHT_CHANNELS]) {
+   unsigned long bits[WEIGHT_CHANNELS];
+   for (uint8_t ch = 0; ch < WEIGHT_CHANNELS; ch++) {
+     bits[ch] = 0;
+   }
    
-   // Check if HX711 is found
-   if (!scale.is_ready()) {
-     Serial.println("HX711 not found or not ready!");
-     return false;
+   for (int i = 0; i < 24; i++) {
+     digitalWrite(HX711_CLOCK_PIN, HIGH);
+     delayMicroseconds(1);
+     for (uint8_t ch = 0; ch < WEIGHT_CHANNELS; ch++) {
+       bits[ch] = (bits[ch] << 1) | digitalRead(weightDataPins[ch]);
+     }
+     digitalWrite(HX711_CLOCK_PIN, LOW);
+     delayMicroseconds(1);
    }
+   digitalWrite(HX711_CLOCK_PIN, HIGH);
+   delayMicroseconds(1);
+   digitalWrite(HX711_CLOCK_PIN, LOW);
    
-   // Set calibration factor (should be adjusted for specific load cell)
-   scale.set_scale(WEIGHT_CALIBRATION);
+   // Sign-extend the two's complement results
+   for (uint8_t ch = 0; ch < WEIGHT_CHANNELS; ch++) {
+     if (bits[ch] & 0x800000UL) {
+       bits[ch] |= 0xFF000000UL;
+     }
+     values[ch] = (long)bits[ch];
+   }
+ }
+ 
+ /**
+  * Average several conversions of every channel, polling for each
+  * Only used outside acquisition (tare, calibration), when the
+  * interrupt leaves the chips alone.
+  */
+ static bool readHX711Average(long values[WEIGHT_CHANNELS], uint8_t times) {
+   long long totals[WEIGHT_CHANNELS];
+   for (uint8_t ch = 0; ch < WEIGHT_CHANNELS; ch++) {
+     totals[ch] = 0;
+   }
    
-   // Reset the scale to zero
-   scale.tare();
+   for (uint8_t i = 0; i < times; i++) {
+     unsigned long start = millis();
+     while (!isHX711Ready()) {
+       if (millis() - start > WEIGHT_ACQUISITION_TIMEOUT_MS) {
+         return false;
+       }
+       delay(1);
+     }
+     
+     long raw[WEIGHT_CHANNELS];
+     noInterrupts();
+     readHX711Raw(raw);
+     interrupts();
+     for (uint8_t ch = 0; ch < WEIGHT_CHANNELS; ch++) {
+       totals[ch] += raw[ch];
+     }
+   }
    
-   Serial.println("HX711 weight sensor initialized");
+   for (uint8_t ch = 0; ch < WEIGHT_CHANNELS; ch++) {
+     values[ch] = (long)(totals[ch] / times);
+   }
    return true;
  }
  
  /**
-  * Read weight from load cell
+  * HX711 DOUT falling edge on any channel: a conversion may be ready
+  * The channels convert in step but their oscillators differ slightly,
+  * so the readout waits for the last one. Clocking the data out toggles
+  * DOUT and can queue another edge, so the lines are checked first.
   */
- void readWeightSensor() {
-   // Store previous reading for change detection
-   previousWeight = currentWeight;
+ static void weightDataReadyISR() {
+   if (!weightBurstActive && weightRawCount >= WEIGHT_SAMPLES) {
+     return;
+   }
+   if (!isHX711Ready()) {
+     return;
+   }
    
-   // Take multiple readings and average them
-   if (scale.is_ready()) {
-     float totalWeight = 0.0f;
-     
-     for (int i = 0; i < WEIGHT_SAMPLES; i++) {
-       totalWeight += scale.get_units();
-       delay(50); // Short delay between samples
+   long raw[WEIGHT_CHANNELS];
+   readHX711Raw(raw);
+   
+   if (weightBurstActive) {
+     if (weightBurstCount < WEIGHT_BURST_MAX_SAMPLES) {
+       float kg = (raw[weightBurstChannel] - weightBurstOffset) / weightBurstScale;
+       float grams = (kg - weightBurst.baseWeight) * 1000.0f;
+       grams = constrain(grams, -32768.0f, 32767.0f);
+       weightBurst.grams[weightBurstCount] = (int16_t)lroundf(grams);
+       weightBurstCount++;
+       weightBurstLastMs = millis();
      }
+     return;
+   }
+   
+   for (uint8_t ch = 0; ch < WEIGHT_CHANNELS; ch++) {
+     weightRawSamples[weightRawCount][ch] = raw[ch];
+   }
+   weightRawCount++;
+ }
+ 
+ /**
+  * Trimmed mean of a small sample set, sorted in place
+  * spread receives the scaled median absolute deviation, a robust
+  * standard deviation estimate.
+  */
+ static float trimmedMean(float* values, int count, int trim, float* spread) {
+   // Insertion sort, count is at most WEIGHT_SAMPLES
+   for (int i = 1; i < count; i++) {
+     float value = values[i];
+     int j = i - 1;
+     while (j >= 0 && values[j] > value) {
+       values[j + 1] = values[j];
+       j--;
+     }
+     values[j + 1] = value;
+   }
+   
+   if (2 * trim >= count) {
+     trim = (count - 1) / 2;
+   }
+   float total = 0.0f;
+   for (int i = trim; i < count - trim; i++) {
+     total += values[i];
+   }
+   
+   float median = (count % 2) ? values[count / 2] :
+                  0.5f * (values[count / 2 - 1] + values[count / 2]);
+   float deviations[WEIGHT_SAMPLES];
+   for (int i = 0; i < count; i++) {
+     deviations[i] = fabsf(values[i] - median);
+   }
+   for (int i = 1; i < count; i++) {
+     float value = deviations[i];
+     int j = i - 1;
+     while (j >= 0 && deviations[j] > value) {
+       deviations[j + 1] = deviations[j];
+       j--;
+     }
+     deviations[j + 1] = value;
+   }
+   float mad = (count % 2) ? deviations[count / 2] :
+               0.5f * (deviations[count / 2 - 1] + deviations[count / 2]);
+   *spread = 1.4826f * mad;
+   
+   return total / (count - 2 * trim);
+ }
+ 
+ /**
+  * Initialize weight sensor
+  */
+ bool setupWeightSensor() {
+   pinMode(HX711_CLOCK_PIN, OUTPUT);
+   for (uint8_t ch = 0; ch < WEIGHT_CHANNELS; ch++) {
+     pinMode(weightDataPins[ch], INPUT);
      
-     // Calculate average
-     currentWeight = totalWeight / WEIGHT_SAMPLES;
-     
-     // Determine weight status
-     float weightDifference = currentWeight - previousWeight;
-     
-     // Reset status to stable by default
-     weightStatus = WEIGHT_STABLE;
+     // Two-sided CUSUM for swarms leaving over several wakes and slow drains
+     weightChannels[ch].changeDetector.init(WEIGHT_CUSUM_DRIFT, WEIGHT_CUSUM_THRESHOLD,
+                                            WEIGHT_CUSUM_HALF_LIFE);
+     weightChannels[ch].changeDetected = false;
+     weightChannels[ch].previousWeight = 0.0f;
+     weightChannels[ch].reading.weight = 0.0f;
+     weightChannels[ch].reading.rawWeight = 0.0f;
+     weightChannels[ch].reading.spread = 0.0f;
+     weightChannels[ch].reading.status = WEIGHT_STABLE;
      
-     // Check for significant changes
-     if (abs(weightDifference) > WEIGHT_CHANGE_ALERT) {
-       if (weightDifference < 0) {
-         // Weight decrease (could be honey removal, absconding, etc.)
-         if (weightDifference < -WEIGHT_CHANGE_ALERT * 2) {
-           weightStatus = WEIGHT_DROP_ALERT; // Severe drop
-         } else {
-           weightStatus = WEIGHT_DECREASE;
-         }
+     // Set calibration factor (should be adjusted for specific load cell)
+     weightChannels[ch].calibration = WEIGHT_CALIBRATION;
+   }
+   
+   // Power-cycle all HX711s together so their conversions start in step
+   digitalWrite(HX711_CLOCK_PIN, HIGH);
+   delayMicroseconds(100);
+   digitalWrite(HX711_CLOCK_PIN, LOW);
+   
+   // Reset the scales to zero
+   long offsets[WEIGHT_CHANNELS];
+   if (!readHX711Average(offsets, WEIGHT_TARE_SAMPLES)) {
+     Serial.print("HX711 not found or not ready on channel");
+     for (uint8_t ch = 0; ch < WEIGHT_CHANNELS; ch++) {
+       if (digitalRead(weightDataPins[ch]) != LOW) {
+         Serial.print(" ");
+         Serial.print(ch);
+       }
+     }
+     Serial.println("!");
+     return false;
+   }
+   for (uint8_t ch = 0; ch < WEIGHT_CHANNELS; ch++) {
+     weightChannels[ch].offset = offsets[ch];
+   }
+   
+   // Conversions are collected on any DOUT falling edge
+   weightRawCount = WEIGHT_SAMPLES;  // Idle until startWeightAcquisition()
+   for (uint8_t ch = 0; ch < WEIGHT_CHANNELS; ch++) {
+     attachInterrupt(digitalPinToInterrupt(weightDataPins[ch]), weightDataReadyISR, FALLING);
+   }
+   
+   Serial.print("HX711 weight sensor initialized (");
+   Serial.print(WEIGHT_CHANNELS);
+   Serial.println(" channels)");
+   return true;
+ }
+ 
+ /**
+  * Start collecting conversions in the background
+  * Call early in the wake so the buffer fills while other sensors are read.
+  * A conversion that is already waiting holds DOUT low and raises no
+  * edge, so it is read straight away.
+  */
+ void startWeightAcquisition() {
+   noInterrupts();
+   weightRawCount = 0;
+   weightDataReadyISR();
+   interrupts();
+   weightAcquiring = true;
+ }
+ 
+ /**
+  * Power the HX711s down across sleep and back up on wake
+  * Holding the shared clock high for over 60 us powers every chip down;
+  * releasing it powers them up together, so their conversions stay in
+  * step. The first conversion after power-up includes the settling time.
+  */
+ void setWeightSensorPower(bool on) {
+   digitalWrite(HX711_CLOCK_PIN, on ? LOW : HIGH);
+ }
+ 
+ /**
+  * Reduce one channel's conversions to a reading and classify it
+  * Drift compensation and the learned daily cycle belong to the
+  * learning model's colony, so they only apply to channel 0.
+  */
+ static void updateWeightChannel(uint8_t ch, const long raw[][WEIGHT_CHANNELS], uint8_t count,
+                                 DateTime now, float correction) {
+   WeightChannel* channel = &weightChannels[ch];
+   WeightReading* reading = &channel->reading;
+   
+   // Store previous reading for change detection
+   channel->previousWeight = reading->weight;
+   
+   float samples[WEIGHT_SAMPLES];
+   for (uint8_t i = 0; i < count; i++) {
+     samples[i] = (raw[i][ch] - channel->offset) / channel->calibration;
+   }
+   reading->rawWeight = trimmedMean(samples, count, WEIGHT_TRIM_SAMPLES, &reading->spread);
+   
+   // Remove learned load-cell thermal drift before classifying
+   if (ch != 0) {
+     correction = 0.0f;
+   }
+   reading->weight = reading->rawWeight - correction;
+   
+   // Determine weight status
+   float weightDifference = reading->weight - channel->previousWeight;
+   
+   // Reset status to stable by default
+   reading->status = WEIGHT_STABLE;
+   
+   // Check for significant changes
+   if (abs(weightDifference) > WEIGHT_CHANGE_ALERT) {
+     if (weightDifference < 0) {
+       // Weight decrease (could be honey removal, absconding, etc.)
+       if (weightDifference < -WEIGHT_CHANGE_ALERT * 2) {
+         reading->status = WEIGHT_DROP_ALERT; // Severe drop
        } else {
-         // Weight increase (honey production, rain ingress, etc.)
-         weightStatus = WEIGHT_INCREASE;
+         reading->status = WEIGHT_DECREASE;
        }
+     } else {
+       // Weight increase (honey production, rain ingress, etc.)
+       reading->status = WEIGHT_INCREASE;
      }
+   }
+   
+   // Gradual changes spread over several wakes, with the learned daily
+   // cycle (forager departures) removed first
+   float dailyOffset = (ch == 0 && ENABLE_LEARNING && isBaselineEstablished()) ?
+                       getWeightDailyOffset(now) : 0.0f;
+   channel->changeDetected = channel->changeDetector.addSample(reading->weight - dailyOffset,
+                                                               now.unixtime());
+   if (channel->changeDetected) {
+     const ChangeEvent& change = channel->changeDetector.lastChange();
      
-     // Print weight
-     Serial.print("Current Weight: ");
-     Serial.print(currentWeight, 2);
-     Serial.println(" kg");
-     
-     Serial.print("Weight Change: ");
-     Serial.print(weightDifference, 2);
-     Serial.println(" kg");
+     if (change.direction == CHANGE_DOWN && reading->status != WEIGHT_DROP_ALERT) {
+       reading->status = (change.magnitude > WEIGHT_CHANGE_ALERT * 2) ?
+                         WEIGHT_DROP_ALERT : WEIGHT_DECREASE;
+     } else if (change.direction == CHANGE_UP && reading->status == WEIGHT_STABLE) {
+       reading->status = WEIGHT_INCREASE;
+     }
      
-     Serial.print("Weight Status: ");
-     switch (weightStatus) {
-       case WEIGHT_STABLE: Serial.println("Stable"); break;
-       case WEIGHT_INCREASE: Serial.println("Increase"); break;
-       case WEIGHT_DECREASE: Serial.println("Decrease"); break;
-       case WEIGHT_DROP_ALERT: Serial.println("Weight Drop Alert!"); break;
-       default: Serial.println("Unknown"); break;
+     Serial.print("Weight change detected: ");
+     Serial.print(change.direction * change.magnitude, 2);
+     Serial.print(" kg over ");
+     Serial.print((change.detectTime - change.startTime) / 60);
+     Serial.println(" min");
+   }
+   
+   // A step or a noisy reading may be the start of an event worth tracing
+   if (!weightBurstPending && (reading->status != WEIGHT_STABLE ||
+                               reading->spread > WEIGHT_BURST_SPREAD)) {
+     weightBurstPending = true;
+     weightBurstChannel = ch;
+   }
+   
+   // Print weight
+   if (WEIGHT_CHANNELS > 1) {
+     Serial.print("Scale ");
+     Serial.print(ch);
+     Serial.print(" - ");
+   }
+   Serial.print("Current Weight: ");
+   Serial.print(reading->weight, 2);
+   Serial.print(" kg (spread ");
+   Serial.print(reading->spread, 3);
+   Serial.print(" kg, drift correction ");
+   Serial.print(correction, 3);
+   Serial.println(" kg)");
+   
+   Serial.print("Weight Change: ");
+   Serial.print(weightDifference, 2);
+   Serial.println(" kg");
+   
+   Serial.print("Weight Status: ");
+   switch (reading->status) {
+     case WEIGHT_STABLE: Serial.println("Stable"); break;
+     case WEIGHT_INCREASE: Serial.println("Increase"); break;
+     case WEIGHT_DECREASE: Serial.println("Decrease"); break;
+     case WEIGHT_DROP_ALERT: Serial.println("Weight Drop Alert!"); break;
+     default: Serial.println("Unknown"); break;
+   }
+ }
+ 
+ /**
+  * Read weight from every load cell
+  * Waits only for conversions still outstanding, then reduces each
+  * channel's with a trimmed mean so a single spike does not skew the
+  * reading.
+  */
+ void readWeightSensor() {
+   if (!weightAcquiring) {
+     startWeightAcquisition();
+   }
+   
+   unsigned long start = millis();
+   while (weightRawCount < WEIGHT_SAMPLES &&
+          millis() - start < WEIGHT_ACQUISITION_TIMEOUT_MS) {
+     delay(1);
+   }
+   
+   // Stop collecting and take a consistent copy of the buffer
+   noInterrupts();
+   uint8_t count = weightRawCount;
+   long raw[WEIGHT_SAMPLES][WEIGHT_CHANNELS];
+   for (uint8_t i = 0; i < count; i++) {
+     for (uint8_t ch = 0; ch < WEIGHT_CHANNELS; ch++) {
+       raw[i][ch] = weightRawSamples[i][ch];
      }
-   } else {
-     Serial.println("HX711 not ready for reading");
+   }
+   weightRawCount = WEIGHT_SAMPLES;
+   interrupts();
+   weightAcquiring = false;
+   
+   weightReadingValid = count > 0;
+   if (count == 0) {
+     Serial.println("HX711 produced no conversions before timeout");
+     return;
+   }
+   if (count < WEIGHT_SAMPLES) {
+     Serial.print("Weight from ");
+     Serial.print(count);
+     Serial.println(" conversions (timeout)");
+   }
+   
+   // Learned load-cell thermal drift of the primary hive's scale
+   DateTime now = getRTCTime();
+   EnvData env = getEnvData();
+   float temperature = isnan(env.ambientTemperature) ? env.temperature : env.ambientTemperature;
+   float rate = 0.0f;
+   uint32_t gap = now.unixtime() - driftLastTime;
+   if (!isnan(driftLastTemperature) && gap > 0 && gap <= WEIGHT_DRIFT_MAX_GAP) {
+     rate = (temperature - driftLastTemperature) * 3600.0f / gap;
+   }
+   driftLastTemperature = temperature;
+   driftLastTime = now.unixtime();
+   float correction = ENABLE_LEARNING ? getWeightTemperatureCorrection(temperature, rate) : 0.0f;
+   
+   weightBurstPending = false;
+   for (uint8_t ch = 0; ch < WEIGHT_CHANNELS; ch++) {
+     updateWeightChannel(ch, raw, count, now, correction);
    }
  }
  
@@ -106,32 +464,178 @@
   * Get the current weight reading
   */
  float getWeight() {
-   return currentWeight;
+   return weightChannels[0].reading.weight;
+ }
+ 
+ /**
+  * Get the latest reading before temperature compensation
+  */
+ float getRawWeight() {
+   return weightChannels[0].reading.rawWeight;
+ }
+ 
+ /**
+  * Get the spread of the latest reading's conversions (kg)
+  * A robust standard deviation; large values mean a noisy reading.
+  */
+ float getWeightSpread() {
+   return weightChannels[0].reading.spread;
  }
  
  /**
   * Get the current weight status
   */
  WeightStatus getWeightStatus() {
-   return weightStatus;
+   return weightChannels[0].reading.status;
  }
  
  /**
-  * Calibrate the weight sensor with a known reference weight
+  * Check if the last reading produced a weight rather than timing out
   */
- void calibrateWeightSensor(float knownWeight) {
-   if (!scale.is_ready()) {
-     Serial.println("HX711 not ready for calibration");
+ bool isWeightReadingValid() {
+   return weightReadingValid;
+ }
+ 
+ /**
+  * Get the change detected on the latest reading, if any
+  */
+ bool getWeightChange(ChangeEvent* event) {
+   if (weightChannels[0].changeDetected && event != NULL) {
+     *event = weightChannels[0].changeDetector.lastChange();
+   }
+   return weightChannels[0].changeDetected;
+ }
+ 
+ /**
+  * Get the number of weight channels
+  */
+ uint8_t getWeightChannelCount() {
+   return WEIGHT_CHANNELS;
+ }
+ 
+ /**
+  * Get the latest reading of one weight channel
+  */
+ bool getWeightReading(uint8_t channel, WeightReading* reading) {
+   if (channel >= WEIGHT_CHANNELS) {
+     return false;
+   }
+   *reading = weightChannels[channel].reading;
+   return true;
+ }
+ 
+ /**
+  * Check if the latest reading asked for a burst capture
+  */
+ bool isWeightBurstPending() {
+   return weightBurstPending;
+ }
+ 
+ /**
+  * Capture a WEIGHT_BURST_SECONDS trace at the HX711 data rate
+  * Traces the first channel whose reading asked for it. Stays awake in
+  * short idle sleeps while the data-ready interrupt fills the fixed
+  * buffer. Skipped on a weak battery or when the last burst was less
+  * than WEIGHT_BURST_MIN_INTERVAL ago.
+  */
+ bool captureWeightBurst() {
+   weightBurstPending = false;
+   
+   if (getBatteryStatus() != BATTERY_NORMAL) {
+     Serial.println("Weight burst skipped - battery low");
+     return false;
+   }
+   
+   DateTime now = getRTCTime();
+   if (weightBurstLastTime != 0 &&
+       now.unixtime() - weightBurstLastTime < WEIGHT_BURST_MIN_INTERVAL) {
+     Serial.println("Weight burst skipped - too soon after the last one");
+     return false;
+   }
+   weightBurstLastTime = now.unixtime();
+   
+   Serial.print("Weight burst capture of scale ");
+   Serial.print(weightBurstChannel);
+   Serial.print(" for ");
+   Serial.print(WEIGHT_BURST_SECONDS);
+   Serial.println(" s...");
+   
+   // Trace is stored relative to the raw reading that triggered it
+   WeightChannel* channel = &weightChannels[weightBurstChannel];
+   weightBurst.channel = weightBurstChannel;
+   weightBurst.startTime = now.unixtime();
+   weightBurst.baseWeight = channel->reading.rawWeight;
+   weightBurstOffset = channel->offset;
+   weightBurstScale = channel->calibration;
+   
+   // Make sure the chips are converting; a clock left high powers them down
+   setWeightSensorPower(true);
+   
+   // The conversion left unread by readWeightSensor() raises no edge
+   unsigned long start = millis();
+   noInterrupts();
+   weightBurstCount = 0;
+   weightBurstLastMs = start;
+   weightBurstActive = true;
+   weightDataReadyISR();
+   interrupts();
+   
+   unsigned long limit = WEIGHT_BURST_SECONDS * 1000UL + WEIGHT_ACQUISITION_TIMEOUT_MS;
+   while (weightBurstCount < WEIGHT_BURST_MAX_SAMPLES && millis() - start < limit) {
+     delay(50);  // Idle between conversions
+   }
+   
+   noInterrupts();
+   weightBurstActive = false;
+   weightBurst.count = weightBurstCount;
+   weightBurst.durationMs = weightBurstLastMs - start;
+   interrupts();
+   
+   if (weightBurst.count == 0) {
+     Serial.println("HX711 produced no conversions during the burst");
+     return false;
+   }
+   Serial.print("Captured ");
+   Serial.print(weightBurst.count);
+   Serial.print(" samples, ");
+   Serial.print(weightBurst.grams[0]);
+   Serial.print(" to ");
+   Serial.print(weightBurst.grams[weightBurst.count - 1]);
+   Serial.println(" g");
+   return true;
+ }
+ 
+ /**
+  * Get the latest burst capture
+  */
+ const WeightBurst* getWeightBurst() {
+   return &weightBurst;
+ }
+ 
+ /**
+  * Calibrate one weight channel with a known reference weight
+  */
+ void calibrateWeightSensor(uint8_t ch, float knownWeight) {
+   if (ch >= WEIGHT_CHANNELS) {
+     Serial.println("No such weight channel");
      return;
    }
+   WeightChannel* channel = &weightChannels[ch];
+   long raw[WEIGHT_CHANNELS];
    
-   Serial.println("Starting calibration procedure...");
+   Serial.print("Starting calibration procedure for scale ");
+   Serial.print(ch);
+   Serial.println("...");
    Serial.println("Please remove all weight from the scale");
    delay(5000);
    
    // Tare scale
    Serial.println("Taring scale...");
-   scale.tare();
+   if (!readHX711Average(raw, WEIGHT_TARE_SAMPLES)) {
+     Serial.println("HX711 not ready for calibration");
+     return;
+   }
+   channel->offset = raw[ch];
    delay(1000);
    
    // Prompt to add calibration weight
@@ -140,21 +644,25 @@
    Serial.println("kg calibration weight on the scale");
    delay(10000);
    
-   // Get raw reading
-   long rawReading = scale.read_average(20);
+   // Get reading above the tare
+   if (!readHX711Average(raw, 2 * WEIGHT_TARE_SAMPLES)) {
+     Serial.println("HX711 not ready for calibration");
+     return;
+   }
    
    // Calculate calibration factor
-   float calibrationFactor = rawReading / knownWeight;
+   float calibrationFactor = (raw[ch] - channel->offset) / knownWeight;
    
    Serial.print("New calibration factor: ");
    Serial.println(calibrationFactor);
    
    // Update scale with new calibration factor
-   scale.set_scale(calibrationFactor);
+   channel->calibration = calibrationFactor;
    
    // Test the calibration
+   readHX711Average(raw, WEIGHT_TARE_SAMPLES);
    Serial.print("Measured weight: ");
-   Serial.print(scale.get_units(10), 2);
+   Serial.print((raw[ch] - channel->offset) / channel->calibration, 2);
    Serial.println(" kg");
    
    // Prompt to remove weight
@@ -162,7 +670,8 @@
    delay(5000);
    
    // Verify zero
+   readHX711Average(raw, WEIGHT_TARE_SAMPLES);
    Serial.print("Zero reading: ");
-   Serial.print(scale.get_units(10), 2);
+   Serial.print((raw[ch] - channel->offset) / channel->calibration, 2);
    Serial.println(" kg");
  }
\ No newline at end of file
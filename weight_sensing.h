@@ -2,13 +2,16 @@
  * Hive Monitor System - Weight Sensing Header
  * 
  * Header file for the weight sensing module that tracks hive
- * weight using a load cell and HX711 amplifier.
+ * weight using a load cell and HX711 amplifier per hive. Channel 0
+ * is the hive that carries the other sensors.
  */
 
 #ifndef WEIGHT_SENSING_H
 #define WEIGHT_SENSING_H
 
 #include <Arduino.h>
+#include "config.h"
+#include "anomaly_detection.h"
 
 // Weight status enumeration
 enum WeightStatus {
@@ -18,15 +21,53 @@ enum WeightStatus {
   WEIGHT_DROP_ALERT   // Sudden large weight drop (possible theft/swarming)
 };
 
-// Pin definitions for HX711
-#define HX711_DATA_PIN  6
-#define HX711_CLOCK_PIN 5
+// Pin definitions for HX711. All channels share the clock, so their
+// conversions stay in step and are clocked out together.
+#define HX711_DATA_PINS     { 6, 9, 10, 11 }
+#define HX711_CLOCK_PIN     12
+#define WEIGHT_MAX_CHANNELS 4
+
+#if WEIGHT_CHANNELS < 1 || WEIGHT_CHANNELS > WEIGHT_MAX_CHANNELS
+#error "WEIGHT_CHANNELS must be between 1 and WEIGHT_MAX_CHANNELS"
+#endif
+
+// Latest reading of one weight channel
+typedef struct {
+  float weight;         // Temperature-compensated weight (kg)
+  float rawWeight;      // Reading before compensation (kg)
+  float spread;         // Robust spread of the reading's conversions (kg)
+  WeightStatus status;  // Change classification
+} WeightReading;
+
+// Samples held by one burst capture
+#define WEIGHT_BURST_MAX_SAMPLES (WEIGHT_BURST_RATE_HZ * WEIGHT_BURST_SECONDS)
+
+// High-rate weight trace captured around a weight event
+typedef struct {
+  uint8_t channel;                           // Weight channel traced
+  uint32_t startTime;                        // Unix time of the first sample
+  uint32_t durationMs;                       // Capture start to the last sample (ms)
+  float baseWeight;                          // Reading the trace is relative to (kg)
+  uint16_t count;                            // Samples captured
+  int16_t grams[WEIGHT_BURST_MAX_SAMPLES];   // Weight minus baseWeight (g)
+} WeightBurst;
 
 // Function prototypes
 bool setupWeightSensor();
+void startWeightAcquisition();
+void setWeightSensorPower(bool on);
 void readWeightSensor();
 float getWeight();
+float getRawWeight();
+float getWeightSpread();
 WeightStatus getWeightStatus();
-void calibrateWeightSensor(float knownWeight);
+bool isWeightReadingValid();
+bool getWeightChange(ChangeEvent* event);
+uint8_t getWeightChannelCount();
+bool getWeightReading(uint8_t channel, WeightReading* reading);
+bool isWeightBurstPending();
+bool captureWeightBurst();
+const WeightBurst* getWeightBurst();
+void calibrateWeightSensor(uint8_t channel, float knownWeight);
 
 #endif // WEIGHT_SENSING_H
\ No newline at end of file